@@ -885,7 +885,14 @@ bool Builder::Build(string* err) {
   IRemoteExecutor::Result remoteResult;
   while (plan_.more_to_do()) {
 
-    if (failures_allowed && remote_runner_->CanRunMore()  ) {
+    // If there is nothing but remote-capable work, an idle local core could
+    // still finish it sooner than remote (fast local machine, slow link).
+    const bool prefer_local = failures_allowed && plan_.get_ready_count() > 0 &&
+                              plan_.get_ready_count() == plan_.get_ready_remote_count() &&
+                              command_runner_->CanRunMore() &&
+                              remote_runner_->PreferLocalExecution();
+
+    if (failures_allowed && !prefer_local && remote_runner_->CanRunMore()  ) {
         if (Edge* edge = plan_.FindWork(true)) {
 
             if (!StartEdge(edge, err, true)) {
@@ -1084,6 +1091,8 @@ bool Builder::FinishCommand(CommandRunner::Result* result, string* err, bool rem
   int start_time, end_time;
   status_->BuildEdgeFinished(edge, result->success(), silentOnSuccess && result->success(),  result->output,
                              &start_time, &end_time, remote ? "[REMOTE] " : "");
+  if (!remote && edge->is_remote_ && result->success())
+    remote_runner_->RecordLocalExecution(edge, end_time - start_time);
 
   // The rest of this function only applies to successful commands.
   if (!result->success()) {
@@ -188,6 +188,7 @@ struct Edge {
   bool deps_missing_;
   bool is_remote_ = false;
   bool use_temporary_inputs_ = false;
+  bool fused_preprocess_ = false; // remote executor runs preprocessor itself, there is no preprocess edge.
 
   const Rule& rule() const { return *rule_; }
   Pool* pool() const { return pool_; }
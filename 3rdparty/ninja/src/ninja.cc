@@ -1212,7 +1212,12 @@ int NinjaMain::RunBuild(RemoteExecutor * const remoteExecutor, int argc, char**
     return 0;
   }
 
-  if (!builder.Build(&err)) {
+  const bool built = builder.Build(&err);
+  const std::string summary = remoteExecutor->GetBuildSummary();
+  if (!summary.empty())
+    printf("wuild: %s\n", summary.c_str());
+
+  if (!built) {
     printf("ninja: build stopped: %s.\n", err.c_str());
     if (err.find("interrupted by user") != string::npos) {
       return 2;
@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <spawn.h>
 
 #if defined(USE_PPOLL)
@@ -36,31 +37,110 @@ extern char** environ;
 
 using namespace std;
 
-Subprocess::Subprocess(bool use_console) : fd_(-1), pid_(-1),
+namespace {
+
+void CheckPollable(int fd) {
+#if !defined(USE_PPOLL)
+  // If available, we use ppoll in DoWork(); otherwise we use pselect
+  // and so must avoid overly-large FDs.
+  if (fd >= static_cast<int>(FD_SETSIZE))
+    Fatal("pipe: %s", strerror(EMFILE));
+#endif  // !USE_PPOLL
+}
+
+/// Reads available data; closes fd on EOF.
+void ReadPipe(int& fd, string* buf) {
+  char chunk[4 << 10];
+  ssize_t len = read(fd, chunk, sizeof(chunk));
+  if (len > 0) {
+    buf->append(chunk, len);
+  } else {
+    if (len < 0)
+      Fatal("read: %s", strerror(errno));
+    close(fd);
+    fd = -1;
+  }
+}
+
+/// Writes to pipe without being killed by SIGPIPE if the reader has already
+/// exited: signal is blocked for calling thread and discarded, write fails
+/// with EPIPE instead.
+ssize_t WriteNoSigPipe(int fd, const char* data, size_t size) {
+  sigset_t pipe_set, old_set, pending;
+  sigemptyset(&pipe_set);
+  sigaddset(&pipe_set, SIGPIPE);
+  sigpending(&pending);
+  const bool was_pending = sigismember(&pending, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+
+  ssize_t len = write(fd, data, size);
+  const int write_errno = errno;
+  if (len < 0 && write_errno == EPIPE && !was_pending) {
+    sigpending(&pending);
+    int sig;
+    if (sigismember(&pending, SIGPIPE))
+      sigwait(&pipe_set, &sig);
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+  errno = write_errno;
+  return len;
+}
+
+}  // namespace
+
+Subprocess::Subprocess(bool use_console) : peak_memory_(0),
+                                           fd_(-1), stdout_fd_(-1),
+                                           stdin_fd_(-1), stdin_pos_(0),
+                                           pid_(-1),
                                            use_console_(use_console) {
 }
 
 Subprocess::~Subprocess() {
   if (fd_ >= 0)
     close(fd_);
+  if (stdout_fd_ >= 0)
+    close(stdout_fd_);
+  CloseStdin();
   // Reap child if forgotten.
   if (pid_ != -1)
     Finish();
 }
 
-bool Subprocess::Start(SubprocessSet* set, const string& command, const vector<string> &, bool useStderr) {
+bool Subprocess::Start(SubprocessSet* set, const string& command, const vector<string> &, bool useStderr, SubprocessPipes* pipes) {
+  if (use_console_)
+    pipes = NULL;  // console subprocess uses terminal streams.
+
   int output_pipe[2];
   if (pipe(output_pipe) < 0)
     Fatal("pipe: %s", strerror(errno));
   fd_ = output_pipe[0];
-#if !defined(USE_PPOLL)
-  // If available, we use ppoll in DoWork(); otherwise we use pselect
-  // and so must avoid overly-large FDs.
-  if (fd_ >= static_cast<int>(FD_SETSIZE))
-    Fatal("pipe: %s", strerror(EMFILE));
-#endif  // !USE_PPOLL
+  CheckPollable(fd_);
   SetCloseOnExec(fd_);
 
+  int stdout_pipe[2] = { -1, -1 };
+  if (pipes && pipes->capture_stdout) {
+    if (pipe(stdout_pipe) < 0)
+      Fatal("pipe: %s", strerror(errno));
+    stdout_fd_ = stdout_pipe[0];
+    CheckPollable(stdout_fd_);
+    SetCloseOnExec(stdout_fd_);
+  }
+
+  int stdin_pipe[2] = { -1, -1 };
+  if (pipes && !pipes->stdin_data.empty()) {
+    if (pipe(stdin_pipe) < 0)
+      Fatal("pipe: %s", strerror(errno));
+    stdin_fd_ = stdin_pipe[1];
+    CheckPollable(stdin_fd_);
+    SetCloseOnExec(stdin_fd_);
+    // Child may read slowly; DoWork() feeds it whenever pipe has room.
+    if (fcntl(stdin_fd_, F_SETFL, fcntl(stdin_fd_, F_GETFL) | O_NONBLOCK) < 0)
+      Fatal("fcntl: %s", strerror(errno));
+    stdin_data_.swap(pipes->stdin_data);
+    stdin_pos_ = 0;
+  }
+
   posix_spawn_file_actions_t action;
   int err = posix_spawn_file_actions_init(&action);
   if (err != 0)
@@ -90,16 +170,34 @@ bool Subprocess::Start(SubprocessSet* set, const string& command, const vector<s
     flags |= POSIX_SPAWN_SETPGROUP;
     // No need to posix_spawnattr_setpgroup(&attr, 0), it's the default.
 
-    // Open /dev/null over stdin.
-    err = posix_spawn_file_actions_addopen(&action, 0, "/dev/null", O_RDONLY,
-          0);
-    if (err != 0) {
-      Fatal("posix_spawn_file_actions_addopen: %s", strerror(err));
+    if (stdin_fd_ >= 0) {
+      err = posix_spawn_file_actions_adddup2(&action, stdin_pipe[0], 0);
+      if (err != 0)
+        Fatal("posix_spawn_file_actions_adddup2: %s", strerror(err));
+      err = posix_spawn_file_actions_addclose(&action, stdin_pipe[0]);
+      if (err != 0)
+        Fatal("posix_spawn_file_actions_addclose: %s", strerror(err));
+    } else {
+      // Open /dev/null over stdin.
+      err = posix_spawn_file_actions_addopen(&action, 0, "/dev/null", O_RDONLY,
+            0);
+      if (err != 0) {
+        Fatal("posix_spawn_file_actions_addopen: %s", strerror(err));
+      }
     }
 
-    err = posix_spawn_file_actions_adddup2(&action, output_pipe[1], 1);
-    if (err != 0)
-      Fatal("posix_spawn_file_actions_adddup2: %s", strerror(err));
+    if (stdout_fd_ >= 0) {
+      err = posix_spawn_file_actions_adddup2(&action, stdout_pipe[1], 1);
+      if (err != 0)
+        Fatal("posix_spawn_file_actions_adddup2: %s", strerror(err));
+      err = posix_spawn_file_actions_addclose(&action, stdout_pipe[1]);
+      if (err != 0)
+        Fatal("posix_spawn_file_actions_addclose: %s", strerror(err));
+    } else {
+      err = posix_spawn_file_actions_adddup2(&action, output_pipe[1], 1);
+      if (err != 0)
+        Fatal("posix_spawn_file_actions_adddup2: %s", strerror(err));
+    }
 
     if (useStderr)
       err = posix_spawn_file_actions_adddup2(&action, output_pipe[1], 2);
@@ -133,28 +231,64 @@ bool Subprocess::Start(SubprocessSet* set, const string& command, const vector<s
     Fatal("posix_spawn_file_actions_destroy: %s", strerror(err));
 
   close(output_pipe[1]);
+  if (stdout_pipe[1] >= 0)
+    close(stdout_pipe[1]);
+  if (stdin_pipe[0] >= 0)
+    close(stdin_pipe[0]);
   return true;
 }
 
 void Subprocess::OnPipeReady() {
-  char buf[4 << 10];
-  ssize_t len = read(fd_, buf, sizeof(buf));
-  if (len > 0) {
-    buf_.append(buf, len);
-  } else {
-    if (len < 0)
-      Fatal("read: %s", strerror(errno));
-    close(fd_);
-    fd_ = -1;
+  ReadPipe(fd_, &buf_);
+}
+
+void Subprocess::OnFdReady(int fd) {
+  if (fd == fd_)
+    OnPipeReady();
+  else if (fd == stdout_fd_)
+    ReadPipe(stdout_fd_, &stdout_buf_);
+  else if (fd == stdin_fd_)
+    OnStdinReady();
+}
+
+void Subprocess::OnStdinReady() {
+  ssize_t len = WriteNoSigPipe(stdin_fd_, stdin_data_.data() + stdin_pos_,
+                               stdin_data_.size() - stdin_pos_);
+  if (len < 0) {
+    if (errno == EAGAIN || errno == EINTR)
+      return;
+    // Child has closed stdin without reading everything (e.g. it failed);
+    // its exit status tells the rest.
+    CloseStdin();
+    return;
   }
+  stdin_pos_ += len;
+  if (stdin_pos_ == stdin_data_.size())
+    CloseStdin();
+}
+
+void Subprocess::CloseStdin() {
+  if (stdin_fd_ < 0)
+    return;
+  close(stdin_fd_);
+  stdin_fd_ = -1;
+  string().swap(stdin_data_);
 }
 
 ExitStatus Subprocess::Finish() {
   assert(pid_ != -1);
+  // Child could wait for more input after closing its outputs.
+  CloseStdin();
   int status;
-  if (waitpid(pid_, &status, 0) < 0)
-    Fatal("waitpid(%d): %s", pid_, strerror(errno));
+  struct rusage usage;
+  if (wait4(pid_, &status, 0, &usage) < 0)
+    Fatal("wait4(%d): %s", pid_, strerror(errno));
   pid_ = -1;
+#ifdef __APPLE__
+  peak_memory_ = usage.ru_maxrss;
+#else
+  peak_memory_ = int64_t(usage.ru_maxrss) * 1024;
+#endif
 
 #ifdef _AIX
   if (WIFEXITED(status) && WEXITSTATUS(status) & 0x80) {
@@ -179,13 +313,28 @@ ExitStatus Subprocess::Finish() {
 }
 
 bool Subprocess::Done() const {
-  return fd_ == -1;
+  return fd_ == -1 && stdout_fd_ == -1;
 }
 
 const string& Subprocess::GetOutput() const {
   return buf_;
 }
 
+const string& Subprocess::GetStdout() const {
+  return stdout_buf_;
+}
+
+int64_t Subprocess::GetPeakMemory() const {
+  return peak_memory_;
+}
+
+void Subprocess::Terminate() {
+  if (pid_ == -1)
+    return;
+  // Non-console children are group leaders, so kill compiler subprocesses too.
+  kill(use_console_ ? pid_ : -pid_, SIGKILL);
+}
+
 int SubprocessSet::interrupted_;
 
 void SubprocessSet::SetInterruptedFlag(int signum) {
@@ -209,6 +358,14 @@ void SubprocessSet::HandlePendingInterruption() {
 
 SubprocessSet::SubprocessSet(bool setupSignalHandlers)
     : setupSignalHandlers_(setupSignalHandlers) {
+  if (pipe(wakeup_pipe_) < 0)
+    Fatal("pipe: %s", strerror(errno));
+  for (int fd : wakeup_pipe_) {
+    SetCloseOnExec(fd);
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0)
+      Fatal("fcntl: %s", strerror(errno));
+  }
+
     if (!setupSignalHandlers_)
         return;
 
@@ -233,6 +390,8 @@ SubprocessSet::SubprocessSet(bool setupSignalHandlers)
 
 SubprocessSet::~SubprocessSet() {
   Clear();
+  close(wakeup_pipe_[0]);
+  close(wakeup_pipe_[1]);
 
   if (!setupSignalHandlers_)
       return;
@@ -246,9 +405,9 @@ SubprocessSet::~SubprocessSet() {
     Fatal("sigprocmask: %s", strerror(errno));
 }
 
-Subprocess *SubprocessSet::Add(const string& command, bool use_console, const vector<string> & environment, bool useStderr) {
+Subprocess *SubprocessSet::Add(const string& command, bool use_console, const vector<string> & environment, bool useStderr, SubprocessPipes* pipes) {
   Subprocess *subprocess = new Subprocess(use_console);
-  if (!subprocess->Start(this, command, environment, useStderr)) {
+  if (!subprocess->Start(this, command, environment, useStderr, pipes)) {
     delete subprocess;
     return 0;
   }
@@ -256,23 +415,44 @@ Subprocess *SubprocessSet::Add(const string& command, bool use_console, const ve
   return subprocess;
 }
 
+void SubprocessSet::Wakeup() {
+  // Pipe is non-blocking: if it is full, wakeup is already pending.
+  const char byte = 0;
+  ssize_t unused = write(wakeup_pipe_[1], &byte, 1);
+  (void)unused;
+}
+
+bool SubprocessSet::ConsumeWakeup() {
+  char buf[64];
+  bool woken = false;
+  while (read(wakeup_pipe_[0], buf, sizeof(buf)) > 0)
+    woken = true;
+  return woken;
+}
+
 #ifdef USE_PPOLL
 bool SubprocessSet::DoWork() {
   vector<pollfd> fds;
-  nfds_t nfds = 0;
+  vector<Subprocess*> owners;
 
   for (vector<Subprocess*>::iterator i = running_.begin();
        i != running_.end(); ++i) {
-    int fd = (*i)->fd_;
-    if (fd < 0)
-      continue;
-    pollfd pfd = { fd, POLLIN | POLLPRI, 0 };
-    fds.push_back(pfd);
-    ++nfds;
+    const pollfd pfds[] = { { (*i)->fd_, POLLIN | POLLPRI, 0 },
+                            { (*i)->stdout_fd_, POLLIN | POLLPRI, 0 },
+                            { (*i)->stdin_fd_, POLLOUT, 0 } };
+    for (const pollfd& pfd : pfds) {
+      if (pfd.fd < 0)
+        continue;
+      fds.push_back(pfd);
+      owners.push_back(*i);
+    }
   }
+  const nfds_t nfds = fds.size();
+  pollfd wakeup_pfd = { wakeup_pipe_[0], POLLIN, 0 };
+  fds.push_back(wakeup_pfd);
 
   interrupted_ = 0;
-  int ret = ppoll(&fds.front(), nfds, NULL, &old_mask_);
+  int ret = ppoll(&fds.front(), nfds + 1, NULL, &old_mask_);
   if (ret == -1) {
     if (errno != EINTR) {
       perror("ninja: ppoll");
@@ -285,23 +465,14 @@ bool SubprocessSet::DoWork() {
   if (IsInterrupted())
     return true;
 
-  nfds_t cur_nfd = 0;
-  for (vector<Subprocess*>::iterator i = running_.begin();
-       i != running_.end(); ) {
-    int fd = (*i)->fd_;
-    if (fd < 0)
-      continue;
-    assert(fd == fds[cur_nfd].fd);
-    if (fds[cur_nfd++].revents) {
-      (*i)->OnPipeReady();
-      if ((*i)->Done()) {
-        finished_.push(*i);
-        i = running_.erase(i);
-        continue;
-      }
-    }
-    ++i;
+  if (fds[nfds].revents)
+    ConsumeWakeup();
+
+  for (nfds_t cur_nfd = 0; cur_nfd < nfds; ++cur_nfd) {
+    if (fds[cur_nfd].revents)
+      owners[cur_nfd]->OnFdReady(fds[cur_nfd].fd);
   }
+  CollectFinished();
 
   return IsInterrupted();
 }
@@ -309,21 +480,28 @@ bool SubprocessSet::DoWork() {
 #else  // !defined(USE_PPOLL)
 bool SubprocessSet::DoWork() {
   fd_set set;
+  fd_set write_set;
   int nfds = 0;
   FD_ZERO(&set);
+  FD_ZERO(&write_set);
 
   for (vector<Subprocess*>::iterator i = running_.begin();
        i != running_.end(); ++i) {
-    int fd = (*i)->fd_;
-    if (fd >= 0) {
-      FD_SET(fd, &set);
+    const int fds[] = { (*i)->fd_, (*i)->stdout_fd_, (*i)->stdin_fd_ };
+    for (int fd : fds) {
+      if (fd < 0)
+        continue;
+      FD_SET(fd, fd == (*i)->stdin_fd_ ? &write_set : &set);
       if (nfds < fd+1)
         nfds = fd+1;
     }
   }
+  FD_SET(wakeup_pipe_[0], &set);
+  if (nfds < wakeup_pipe_[0] + 1)
+    nfds = wakeup_pipe_[0] + 1;
 
   interrupted_ = 0;
-  int ret = pselect(nfds, &set, 0, 0, 0, &old_mask_);
+  int ret = pselect(nfds, &set, &write_set, 0, 0, &old_mask_);
   if (ret == -1) {
     if (errno != EINTR) {
       perror("ninja: pselect");
@@ -336,24 +514,35 @@ bool SubprocessSet::DoWork() {
   if (IsInterrupted())
     return true;
 
+  if (FD_ISSET(wakeup_pipe_[0], &set))
+    ConsumeWakeup();
+
   for (vector<Subprocess*>::iterator i = running_.begin();
-       i != running_.end(); ) {
-    int fd = (*i)->fd_;
-    if (fd >= 0 && FD_ISSET(fd, &set)) {
-      (*i)->OnPipeReady();
-      if ((*i)->Done()) {
-        finished_.push(*i);
-        i = running_.erase(i);
-        continue;
-      }
+       i != running_.end(); ++i) {
+    const int fds[] = { (*i)->fd_, (*i)->stdout_fd_, (*i)->stdin_fd_ };
+    for (int fd : fds) {
+      if (fd >= 0 && (FD_ISSET(fd, &set) || FD_ISSET(fd, &write_set)))
+        (*i)->OnFdReady(fd);
     }
-    ++i;
   }
+  CollectFinished();
 
   return IsInterrupted();
 }
 #endif  // !defined(USE_PPOLL)
 
+void SubprocessSet::CollectFinished() {
+  for (vector<Subprocess*>::iterator i = running_.begin();
+       i != running_.end(); ) {
+    if ((*i)->Done()) {
+      finished_.push(*i);
+      i = running_.erase(i);
+      continue;
+    }
+    ++i;
+  }
+}
+
 Subprocess* SubprocessSet::NextFinished() {
   if (finished_.empty())
     return NULL;
@@ -23,7 +23,8 @@
 
 using namespace std;
 
-Subprocess::Subprocess(bool use_console) : child_(NULL) , overlapped_(),
+Subprocess::Subprocess(bool use_console) : peak_memory_(0),
+                                           child_(NULL) , overlapped_(),
                                            is_reading_(false),
                                            use_console_(use_console) {
 }
@@ -74,7 +75,11 @@ HANDLE Subprocess::SetupPipe(HANDLE ioport) {
   return output_write_child;
 }
 
-bool Subprocess::Start(SubprocessSet* set, const string& command, const vector<string> & environment, bool useStderr) {
+bool Subprocess::Start(SubprocessSet* set, const string& command, const vector<string> & environment, bool useStderr, SubprocessPipes* pipes) {
+  // Stream redirection is not implemented; callers have to use files.
+  if (pipes)
+    return false;
+
   HANDLE child_pipe = SetupPipe(set->ioport_);
 
   SECURITY_ATTRIBUTES security_attributes;
@@ -221,8 +226,26 @@ const string& Subprocess::GetOutput() const {
   return buf_;
 }
 
+const string& Subprocess::GetStdout() const {
+  return stdout_buf_;
+}
+
+int64_t Subprocess::GetPeakMemory() const {
+  return peak_memory_;
+}
+
+void Subprocess::Terminate() {
+  if (child_)
+    TerminateProcess(child_, 1);
+}
+
 HANDLE SubprocessSet::ioport_;
 
+namespace {
+// Completion key used by Wakeup(); its address can't clash with any Subprocess*.
+char wakeup_key;
+}
+
 SubprocessSet::SubprocessSet(bool setupSignalHandlers)
     : setupSignalHandlers_(setupSignalHandlers) {
   ioport_ = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
@@ -252,9 +275,9 @@ BOOL WINAPI SubprocessSet::NotifyInterrupted(DWORD dwCtrlType) {
   return FALSE;
 }
 
-Subprocess *SubprocessSet::Add(const string& command, bool use_console, const vector<string> & environment, bool useStderr) {
+Subprocess *SubprocessSet::Add(const string& command, bool use_console, const vector<string> & environment, bool useStderr, SubprocessPipes* pipes) {
   Subprocess *subprocess = new Subprocess(use_console);
-  if (!subprocess->Start(this, command, environment, useStderr)) {
+  if (!subprocess->Start(this, command, environment, useStderr, pipes)) {
     delete subprocess;
     return 0;
   }
@@ -280,6 +303,9 @@ bool SubprocessSet::DoWork() {
                 // delivered by NotifyInterrupted above.
     return true;
 
+  if (subproc == reinterpret_cast<Subprocess*>(&wakeup_key)) // Delivered by Wakeup().
+    return false;
+
   subproc->OnPipeReady();
 
   if (subproc->Done()) {
@@ -294,6 +320,11 @@ bool SubprocessSet::DoWork() {
   return false;
 }
 
+void SubprocessSet::Wakeup() {
+  if (!PostQueuedCompletionStatus(ioport_, 0, (ULONG_PTR)&wakeup_key, NULL))
+    Win32Fatal("PostQueuedCompletionStatus");
+}
+
 Subprocess* SubprocessSet::NextFinished() {
   if (finished_.empty())
     return NULL;
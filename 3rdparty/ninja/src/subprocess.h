@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <stdint.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -35,6 +36,15 @@
 
 #include "exit_status.h"
 
+/// Optional redirection of subprocess standard streams; POSIX only,
+/// ignored for console subprocesses.
+struct SubprocessPipes {
+  /// Written to child stdin (otherwise stdin is /dev/null).
+  std::string stdin_data;
+  /// Collect stdout separately from stderr, see Subprocess::GetStdout().
+  bool capture_stdout = false;
+};
+
 /// Subprocess wraps a single async subprocess.  It is entirely
 /// passive: it expects the caller to notify it when its fds are ready
 /// for reading, as well as call Finish() to reap the child once done()
@@ -50,12 +60,26 @@ struct Subprocess {
 
   const std::string& GetOutput() const;
 
+  /// Child stdout when SubprocessPipes::capture_stdout was requested;
+  /// GetOutput() then contains stderr only.
+  const std::string& GetStdout() const;
+
+  /// Peak resident memory in bytes of the process and its waited
+  /// children, known after Finish(); 0 if not supported.
+  int64_t GetPeakMemory() const;
+
+  /// Forcibly stops the process (and its process group); the caller
+  /// still has to wait for Done() and call Finish() as usual.
+  void Terminate();
+
  private:
   Subprocess(bool use_console);
-  bool Start(struct SubprocessSet* set, const std::string& command, const std::vector<std::string> & environment = {}, bool useStderr = true);
+  bool Start(struct SubprocessSet* set, const std::string& command, const std::vector<std::string> & environment = {}, bool useStderr = true, SubprocessPipes* pipes = nullptr);
   void OnPipeReady();
 
   std::string buf_;
+  std::string stdout_buf_;
+  int64_t peak_memory_;
 
 #ifdef _WIN32
   /// Set up pipe_ as the parent-side pipe of the subprocess; return the
@@ -68,7 +92,16 @@ struct Subprocess {
   char overlapped_buf_[4 << 10];
   bool is_reading_;
 #else
+  /// Handles readiness of any of process pipes.
+  void OnFdReady(int fd);
+  void OnStdinReady();
+  void CloseStdin();
+
   int fd_;
+  int stdout_fd_;
+  int stdin_fd_;
+  std::string stdin_data_;
+  size_t stdin_pos_;
   pid_t pid_;
 #endif
   bool use_console_;
@@ -83,11 +116,15 @@ struct SubprocessSet {
   SubprocessSet(bool setupSignalHandlers = true);
   ~SubprocessSet();
 
-  Subprocess* Add(const std::string& command, bool use_console = false, const std::vector<std::string> & environment = {}, bool useStderr = true);
+  Subprocess* Add(const std::string& command, bool use_console = false, const std::vector<std::string> & environment = {}, bool useStderr = true, SubprocessPipes* pipes = nullptr);
   bool DoWork();
   Subprocess* NextFinished();
   void Clear();
 
+  /// Makes blocked DoWork() return (without interruption) as soon as possible.
+  /// The only method which is safe to call from another thread.
+  void Wakeup();
+
   std::vector<Subprocess*> running_;
   std::queue<Subprocess*> finished_;
 
@@ -107,6 +144,11 @@ struct SubprocessSet {
   struct sigaction old_term_act_;
   struct sigaction old_hup_act_;
   sigset_t old_mask_;
+  int wakeup_pipe_[2];
+  /// Empties wakeup pipe; returns true if wakeup was requested.
+  bool ConsumeWakeup();
+  /// Moves subprocesses with all outputs closed to finished_.
+  void CollectFinished();
 #endif
   bool setupSignalHandlers_;
 };
@@ -260,4 +260,45 @@ TEST_F(SubprocessTest, ReadStdin) {
   ASSERT_EQ(ExitSuccess, subproc->Finish());
   ASSERT_EQ(1u, subprocs_.finished_.size());
 }
+
+// Input larger than pipe buffer is fed to stdin, stdout is kept apart
+// from stderr.
+TEST_F(SubprocessTest, PipeStdinStdout) {
+  SubprocessPipes pipes;
+  pipes.stdin_data = string(1 << 20, 'x');
+  pipes.capture_stdout = true;
+  Subprocess* subproc = subprocs_.Add("cat -; echo err >&2", false, {}, true,
+                                      &pipes);
+  ASSERT_NE((Subprocess *) 0, subproc);
+  while (!subproc->Done()) {
+    subprocs_.DoWork();
+  }
+  ASSERT_EQ(ExitSuccess, subproc->Finish());
+  EXPECT_EQ(string(1 << 20, 'x'), subproc->GetStdout());
+  EXPECT_EQ("err\n", subproc->GetOutput());
+}
+
+// Child which does not read its stdin doesn't kill us with SIGPIPE.
+TEST_F(SubprocessTest, PipeStdinUnread) {
+  SubprocessPipes pipes;
+  pipes.stdin_data = string(1 << 20, 'x');
+  Subprocess* subproc = subprocs_.Add("exit 1", false, {}, true, &pipes);
+  ASSERT_NE((Subprocess *) 0, subproc);
+  while (!subproc->Done()) {
+    subprocs_.DoWork();
+  }
+  ASSERT_EQ(ExitFailure, subproc->Finish());
+}
+
+// Peak memory includes children of the process, as compiler driver
+// spawns the actual compiler.
+TEST_F(SubprocessTest, PeakMemory) {
+  Subprocess* subproc = subprocs_.Add("sh -c 'x=$(head -c 33554432 /dev/zero | tr \\\\0 x); true'");
+  ASSERT_NE((Subprocess *) 0, subproc);
+  while (!subproc->Done()) {
+    subprocs_.DoWork();
+  }
+  ASSERT_EQ(ExitSuccess, subproc->Finish());
+  EXPECT_GT(subproc->GetPeakMemory(), 32 << 20);
+}
 #endif  // _WIN32
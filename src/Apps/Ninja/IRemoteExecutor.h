@@ -44,6 +44,9 @@ public:
     virtual std::string FilterPreprocessorFlags(const std::string& toolId, const std::string& flags) const     = 0;
     virtual std::string FilterCompilerFlags(const std::string& toolId, const std::string& flags) const         = 0;
 
+    /// True if compile edge can stay whole: executor preprocesses it in memory before sending, without preprocess edge.
+    virtual bool CanFusePreprocessing(const std::string& toolId) const = 0;
+
     virtual void RunIfNeeded(const std::vector<std::string>& toolIds, const std::shared_ptr<SubprocessSet>& subprocessSet) = 0;
     virtual int  GetMinimalRemoteTasks() const                                                                             = 0;
     virtual void SleepSome() const                                                                                         = 0;
@@ -51,6 +54,11 @@ public:
     virtual bool CanRunMore()                                             = 0;
     virtual bool StartCommand(Edge* userData, const std::string& command) = 0;
 
+    /// Remote-capable command was executed locally, duration in milliseconds.
+    virtual void RecordLocalExecution(const Edge* edge, int64_t durationMs) = 0;
+    /// True if remote-capable command is expected to finish sooner on idle local core.
+    virtual bool PreferLocalExecution() const = 0;
+
     /// The result of waiting for a command.
     struct Result {
         Result() = default;
@@ -71,4 +79,7 @@ public:
     virtual std::set<Edge*> GetActiveEdges() = 0;
 
     virtual std::vector<std::string> GetKnownToolNames() const = 0;
+
+    /// Line for the end of build, e.g. local cache hit rate; empty if nothing to report.
+    virtual std::string GetBuildSummary() const = 0;
 };
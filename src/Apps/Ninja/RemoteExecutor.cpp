@@ -13,6 +13,10 @@
 
 #include "RemoteExecutor.h"
 
+#include <graph.h>
+
+#include <thread>
+
 using namespace Wuild;
 
 RemoteExecutor::RemoteExecutor(ConfiguredApplication& app)
@@ -115,6 +119,22 @@ bool RemoteExecutor::CheckRemotePossibleForFlags(const std::string& toolId, cons
     return tool->CheckRemotePossibleForFlags(ToolCommandline(flags, ToolCommandline::InvokeType::Preprocess).SetId(toolId));
 }
 
+bool RemoteExecutor::CanFusePreprocessing(const std::string& toolId) const
+{
+    if (!m_remoteEnabled || !m_remoteToolConfig.m_fusedPreprocessing)
+        return false;
+#ifdef _WIN32
+    return false; // Subprocess can't capture stdout on Windows.
+#else
+    IInvocationTool::Ptr tool;
+    if (!(tool = m_invocationToolProvider->GetTool({ toolId })))
+        return false;
+
+    const auto type = tool->GetConfig().m_type;
+    return type == IInvocationTool::Config::ToolchainType::GCC || type == IInvocationTool::Config::ToolchainType::Clang;
+#endif
+}
+
 std::string RemoteExecutor::GetPreprocessedPath(const std::string& sourcePath, const std::string& objectPath) const
 {
     if (!m_remoteEnabled)
@@ -154,6 +174,15 @@ void RemoteExecutor::RunIfNeeded(const std::vector<std::string>& toolIds, const
         return;
 
     m_hasStart = true;
+    if (m_remoteToolConfig.m_fusedPreprocessing && !m_preprocessExecutor) {
+        m_preprocessExecutor = LocalExecutor::Create(m_invocationToolProvider, m_app.m_tempDir);
+        m_preprocessExecutor->SetThreadCount(std::max(std::thread::hardware_concurrency(), 1u));
+    }
+    {
+        // previous build (e.g. manifest rebuild) was aborted in builder cleanup.
+        std::unique_lock<std::shared_mutex> lock(m_preprocessMutex);
+        m_preprocessCancelled = false;
+    }
     if (!m_remoteService) {
         auto localExecutor = LocalExecutor::Create(m_invocationToolProvider, m_app.m_tempDir, subprocessSet);
         auto toolsVersions = VersionChecker::Create(localExecutor, m_invocationToolProvider)->DetermineToolVersions(toolIds);
@@ -185,7 +214,14 @@ bool RemoteExecutor::CanRunMore()
     if (!m_remoteEnabled || !m_hasStart)
         return false;
 
-    return m_remoteService->GetFreeRemoteThreads() > 0;
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    return HasFreeRemoteThreads();
+}
+
+bool RemoteExecutor::HasFreeRemoteThreads() const
+{
+    // tasks being preprocessed will take remote threads soon.
+    return m_remoteService->GetFreeRemoteThreads() - int(m_preprocessTasks.size()) > 0;
 }
 
 bool RemoteExecutor::StartCommand(Edge* userData, const std::string& command)
@@ -201,27 +237,95 @@ bool RemoteExecutor::StartCommand(Edge* userData, const std::string& command)
 
     invocation = tool->CompleteInvocation(invocation);
 
+    uint64_t buildId = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        m_activeEdges.insert(userData);
+        buildId = m_buildId;
+    }
     auto outputFilename = invocation.GetOutput();
-    auto callback       = [this, userData, outputFilename](const RemoteToolClient::TaskExecutionInfo& info) {
+    auto callback       = [this, userData, outputFilename, buildId](const RemoteToolClient::TaskExecutionInfo& info) {
         bool result = info.m_result;
         Syslogger() << outputFilename << " -> " << result << ", " << info.GetProfilingStr();
         std::lock_guard<std::mutex> lock(m_resultsMutex);
+        if (buildId != m_buildId) // build is aborted, its active edges are cleaned up by builder.
+            return;
+        if (result && !info.m_cached)
+            m_executionModel.AddRemoteExecution(info.m_toolExecutionTime.GetUS(), info.GetOverheadPercent());
         m_results.emplace_back(userData, result, info.m_stdOutput);
-        if (m_hasStart) {
-            auto it = m_activeEdges.find(userData);
-            if (it != m_activeEdges.end())
-                m_activeEdges.erase(it);
+        m_activeEdges.erase(userData);
+    };
+    if (userData->fused_preprocess_)
+        return StartPreprocess(userData, buildId, tool, invocation, callback);
+
+    m_remoteService->InvokeTool(invocation, callback);
+
+    return true;
+}
+
+bool RemoteExecutor::StartPreprocess(Edge* userData, uint64_t buildId, const IInvocationTool::Ptr& tool, const ToolCommandline& invocation, const RemoteToolClient::InvokeCallback& callback)
+{
+    ToolCommandline pp, cc;
+    if (!m_preprocessExecutor || !tool->SplitInvocation(invocation, pp, cc)) {
+        callback(RemoteToolClient::TaskExecutionInfo("Failed to split invocation for preprocessing."));
+        return true;
+    }
+    pp.SetOutput("-"); // dependency file is still written by preprocessor, ninja reads it as for local command.
+
+    LocalExecutorTask::Ptr task(new LocalExecutorTask());
+    task->m_invocation               = pp;
+    task->m_writeInput               = false;
+    task->m_pipeOutput               = true;
+    task->m_compressionOutput.m_type = Mernel::CompressionType::None; // compressed by m_remoteService, same as input file.
+    task->m_callback                 = [this, userData, buildId, cc, callback](LocalExecutorResult::Ptr result) {
+        {
+            std::lock_guard<std::mutex> lock(m_resultsMutex);
+            if (buildId == m_buildId)
+                m_preprocessTasks.erase(userData);
+            if (result->m_result)
+                m_executionModel.AddPreprocessing(result->m_executionTime.GetUS());
+        }
+        std::shared_lock<std::shared_mutex> lock(m_preprocessMutex);
+        if (result->m_cancelled || m_preprocessCancelled) {
+            callback(RemoteToolClient::TaskExecutionInfo("Preprocessing is cancelled."));
+            return;
         }
+        if (!result->m_result) {
+            callback(RemoteToolClient::TaskExecutionInfo(result->m_stdOut));
+            return;
+        }
+        // preprocessor warnings are shown same as with separate preprocess step.
+        const std::string ppOutput = result->m_stdOut;
+        m_remoteService->InvokeTool(cc, result->m_outputData, [callback, ppOutput](const RemoteToolClient::TaskExecutionInfo& info) {
+            RemoteToolClient::TaskExecutionInfo fullInfo = info;
+            fullInfo.m_stdOutput                         = ppOutput + info.m_stdOutput;
+            callback(fullInfo);
+        });
     };
     {
         std::lock_guard<std::mutex> lock(m_resultsMutex);
-        m_activeEdges.insert(userData);
+        m_preprocessTasks[userData] = task;
     }
-    m_remoteService->InvokeTool(invocation, callback);
-
+    m_preprocessExecutor->AddTask(task);
     return true;
 }
 
+void RemoteExecutor::RecordLocalExecution(const Edge* edge, int64_t durationMs)
+{
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    // fused edge runs preprocessor too, while remote samples are compilation only.
+    m_executionModel.AddLocalExecution(durationMs * 1000, edge->fused_preprocess_);
+}
+
+bool RemoteExecutor::PreferLocalExecution() const
+{
+    if (!m_remoteEnabled || !m_hasStart || !m_remoteToolConfig.m_adaptiveLocalExecution)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    return m_executionModel.PreferLocal(HasFreeRemoteThreads());
+}
+
 bool RemoteExecutor::WaitForCommand(IRemoteExecutor::Result* result)
 {
     if (!m_remoteEnabled)
@@ -238,17 +342,40 @@ bool RemoteExecutor::WaitForCommand(IRemoteExecutor::Result* result)
 
 void RemoteExecutor::Abort()
 {
+    {
+        // waits for preprocessed inputs which are being passed to m_remoteService.
+        std::unique_lock<std::shared_mutex> lock(m_preprocessMutex);
+        m_preprocessCancelled = true;
+    }
     if (m_hasStart && m_remoteService) {
+        m_remoteService->CancelTasks();
         m_remoteService->FinishSession();
         Syslogger(Syslogger::Notice) << m_remoteService->GetSessionInformation();
+        m_buildSummary = m_remoteService->GetLocalCacheSummary();
     }
     m_hasStart = false;
+
+    // results which come later belong to this build and are dropped; next build may reuse Edge addresses.
+    std::map<Edge*, LocalExecutorTask::Ptr> preprocessTasks;
+    {
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        m_buildId++;
+        m_results.clear();
+        preprocessTasks.swap(m_preprocessTasks);
+    }
+    for (const auto& task : preprocessTasks)
+        m_preprocessExecutor->CancelTask(task.second);
+
     m_remoteService.reset();
 }
 
 std::set<Edge*> RemoteExecutor::GetActiveEdges()
 {
-    return m_activeEdges;
+    // edges are reported once, to builder which cleans up after Abort().
+    std::set<Edge*>             activeEdges;
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    activeEdges.swap(m_activeEdges);
+    return activeEdges;
 }
 
 std::vector<std::string> RemoteExecutor::GetKnownToolNames() const
@@ -260,6 +387,11 @@ std::vector<std::string> RemoteExecutor::GetKnownToolNames() const
     return result;
 }
 
+std::string RemoteExecutor::GetBuildSummary() const
+{
+    return m_hasStart && m_remoteService ? m_remoteService->GetLocalCacheSummary() : m_buildSummary;
+}
+
 RemoteExecutor::~RemoteExecutor()
 {
 }
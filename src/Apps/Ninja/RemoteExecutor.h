@@ -17,12 +17,14 @@
 
 #include <ConfiguredApplication.h>
 #include <RemoteToolClient.h>
+#include <LocalExecutionModel.h>
 #include <InvocationToolProvider.h>
 #include <ThreadUtils.h>
 #include <Syslogger.h>
 #include <LocalExecutor.h>
 #include <VersionChecker.h>
 #include <iostream>
+#include <shared_mutex>
 
 //#define TEST_CLIENT
 #ifdef TEST_CLIENT
@@ -44,10 +46,21 @@ class RemoteExecutor : public IRemoteExecutor {
     bool m_hasStart           = false;
     int  m_minimalRemoteTasks = 0;
 
+    std::string m_buildSummary; //!< Saved when remote service is stopped
+
     std::set<Edge*>    m_activeEdges;
     std::deque<Result> m_results;
+    uint64_t           m_buildId = 0; //!< Changed by Abort(), so late results of aborted build are dropped
     mutable std::mutex m_resultsMutex;
 
+    // Preprocessing of fused edges, output goes to m_remoteService from memory.
+    Wuild::ILocalExecutor::Ptr                     m_preprocessExecutor;
+    std::map<Edge*, Wuild::LocalExecutorTask::Ptr> m_preprocessTasks;             //!< Guarded by m_resultsMutex
+    std::shared_mutex                              m_preprocessMutex;             //!< Held shared while preprocessed input is passed to m_remoteService
+    bool                                           m_preprocessCancelled = false; //!< Guarded by m_preprocessMutex
+
+    Wuild::LocalExecutionModel m_executionModel; //!< Guarded by m_resultsMutex
+
 public:
     RemoteExecutor(Wuild::ConfiguredApplication& app);
 
@@ -61,6 +74,7 @@ public:
                                     std::vector<std::string>&       compileRule) const override;
 
     bool        CheckRemotePossibleForFlags(const std::string& toolId, const std::string& flags) const override;
+    bool        CanFusePreprocessing(const std::string& toolId) const override;
     std::string GetPreprocessedPath(const std::string& sourcePath, const std::string& objectPath) const override;
     std::string FilterPreprocessorFlags(const std::string& toolId, const std::string& flags) const override;
 
@@ -73,6 +87,9 @@ public:
 
     bool StartCommand(Edge* userData, const std::string& command) override;
 
+    void RecordLocalExecution(const Edge* edge, int64_t durationMs) override;
+    bool PreferLocalExecution() const override;
+
     /// return true if has finished result.
     bool WaitForCommand(Result* result) override;
 
@@ -81,5 +98,13 @@ public:
 
     std::vector<std::string> GetKnownToolNames() const override;
 
+    std::string GetBuildSummary() const override;
+
     ~RemoteExecutor();
+
+private:
+    bool HasFreeRemoteThreads() const; //!< Called under m_resultsMutex
+
+    /// Runs preprocessor locally with output to pipe, then sends its output as input of compile invocation.
+    bool StartPreprocess(Edge* userData, uint64_t buildId, const Wuild::IInvocationTool::Ptr& tool, const Wuild::ToolCommandline& invocation, const Wuild::RemoteToolClient::InvokeCallback& callback);
 };
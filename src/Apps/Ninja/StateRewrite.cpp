@@ -20,8 +20,9 @@
 #include <Syslogger.h>
 
 struct RuleReplace {
-    const Rule* pp;
-    const Rule* cc;
+    const Rule* pp    = nullptr;
+    const Rule* cc    = nullptr;
+    const Rule* fused = nullptr; // whole compile rule, when remote executor preprocesses itself.
     std::string toolId;
     RuleReplace() = default;
     RuleReplace(const Rule* pp_, const Rule* cc_, std::string id)
@@ -76,7 +77,20 @@ void RewriteStateRules(State* state, IRemoteExecutor* const remoteExecutor)
         std::vector<std::string> preprocessRule, compileRule;
         std::string              toolId;
         const auto               ppResult = remoteExecutor->PreprocessCode(originalRule, s_ignoredArgs, toolId, preprocessRule, compileRule);
-        if (ppResult == IRemoteExecutor::PreprocessResult::Success) {
+        const EvalString*        deps     = rule->GetBinding("deps");
+        // ninja reads depfile of finished remote command only for deps=gcc; other depfile rules keep preprocess edge.
+        const bool fuse = ppResult == IRemoteExecutor::PreprocessResult::Success && remoteExecutor->CanFusePreprocessing(toolId)
+                          && (!rule->GetBinding("depfile") || (deps && deps->Unparse() == "gcc"));
+        if (fuse) {
+            Rule* ruleRemote = rule->Clone(ruleName + "_REMOTE");
+            state->bindings_.AddRule(ruleRemote);
+            ruleRemote->toolId_ = toolId;
+
+            RuleReplace replacement;
+            replacement.fused     = ruleRemote;
+            replacement.toolId    = toolId;
+            ruleReplacement[rule] = replacement;
+        } else if (ppResult == IRemoteExecutor::PreprocessResult::Success) {
             Rule* rulePP = rule->Clone(ruleName + "_PP");
             state->bindings_.AddRule(rulePP);
             Rule* ruleCC = rule->Clone(ruleName + "_CC");
@@ -129,10 +143,6 @@ void RewriteStateRules(State* state, IRemoteExecutor* const remoteExecutor)
             // always clean preprocessed file from prev crashes.
             remove(ppPath.c_str());
 
-            Node* pp_node = state->GetNode(ppPath, node->slash_bits());
-
-            pp_node->set_buddy(in_egde->outputs_[0]);
-
             auto originalBindings = in_egde->env_->GetBindings();
             bool isRemote         = true;
             if (originalBindings.find("FLAGS") != originalBindings.end())
@@ -140,6 +150,20 @@ void RewriteStateRules(State* state, IRemoteExecutor* const remoteExecutor)
             if (originalBindings.find("INCLUDES") != originalBindings.end())
                 isRemote = isRemote && remoteExecutor->CheckRemotePossibleForFlags(replacement.toolId, originalBindings["INCLUDES"]);
 
+            if (replacement.fused) {
+                // edge keeps original command, deps and depfile; only remote executor knows it has two stages.
+                if (isRemote) {
+                    in_egde->rule_             = replacement.fused;
+                    in_egde->is_remote_        = true;
+                    in_egde->fused_preprocess_ = true;
+                }
+                continue;
+            }
+
+            Node* pp_node = state->GetNode(ppPath, node->slash_bits());
+
+            pp_node->set_buddy(in_egde->outputs_[0]);
+
             if (!isRemote)
                 continue;
 
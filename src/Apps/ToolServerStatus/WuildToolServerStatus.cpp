@@ -57,7 +57,7 @@ public:
     void AddClient(const ToolServerInfo& info)
     {
         SocketFrameHandlerSettings settings;
-        settings.m_channelProtocolVersion = RemoteToolRequest::s_version + RemoteToolResponse::s_version;
+        settings.m_channelProtocolVersion = g_remoteToolProtocolVersion;
         settings.m_segmentSize            = 8192;
         settings.m_hasConnStatus          = true;
         SocketFrameHandler::Ptr handler(new SocketFrameHandler(settings));
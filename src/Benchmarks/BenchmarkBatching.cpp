@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include <AppUtils.h>
+#include <ArgStorage.h>
+#include <LocalExecutor.h>
+#include <RemoteToolClient.h>
+#include <RemoteToolServer.h>
+#include <VersionChecker.h>
+
+#include <condition_variable>
+#include <fstream>
+
+#include "MernelPlatform/FsUtils.hpp"
+
+const int g_benchmarkPort = 12346;
+
+/*
+ * Compiles many tiny generated sources through local tool server, without and with request batching, and shows throughput.
+ * Arguments: [number of files, default 200] [server threads, default 8] [batch size, default maxBatchTasks from config].
+ * First gcc/clang tool from [tools] config is used.
+ */
+int main(int argc, char** argv)
+{
+    using namespace Wuild;
+    ArgStorage            argStorage(argc, argv);
+    ConfiguredApplication app(argStorage.GetConfigValues(), "BenchmarkBatching");
+    auto                  invocationToolProvider = CheckedCreateInvocationToolProvider(app);
+    if (!invocationToolProvider)
+        return 1;
+
+    RemoteToolClient::Config clientConfig;
+    app.GetRemoteToolClientConfig(clientConfig, true); // coordinator is not used, so defaults are fine too.
+
+    const auto args      = argStorage.GetArgs();
+    const int  files     = args.size() > 0 ? std::max(std::atoi(args[0].c_str()), 1) : 200;
+    const int  threads   = args.size() > 1 ? std::max(std::atoi(args[1].c_str()), 1) : 8;
+    const int  batchSize = args.size() > 2 ? std::max(std::atoi(args[2].c_str()), 2) : std::max(clientConfig.m_maxBatchTasks, 2);
+
+    std::string toolId;
+    for (const auto& tool : invocationToolProvider->GetTools()) {
+        const auto type = tool->GetConfig().m_type;
+        if (type == IInvocationTool::Config::ToolchainType::GCC || type == IInvocationTool::Config::ToolchainType::Clang) {
+            toolId = tool->GetId().m_toolId;
+            break;
+        }
+    }
+    if (toolId.empty()) {
+        Syslogger(Syslogger::Err) << "No gcc or clang tool configured.";
+        return 1;
+    }
+
+    auto localExecutor = LocalExecutor::Create(invocationToolProvider, app.m_tempDir);
+    localExecutor->SetThreadCount(threads);
+
+    // preprocessing is done once, only remote part is measured.
+    const std::string dir = app.m_tempDir + "/BenchmarkBatching";
+    Mernel::std_fs::create_directories(dir);
+    std::vector<ToolCommandline> invocations;
+    for (int i = 0; i < files; ++i) {
+        const std::string source = dir + "/small" + std::to_string(i) + ".cpp";
+        std::ofstream(source) << "int small" << i << "(int x) { return x * " << i << " + 1; }\n";
+
+        LocalExecutorTask::Ptr original(new LocalExecutorTask());
+        original->m_readOutput = original->m_writeInput = false;
+        original->m_invocation                          = ToolCommandline({ "-O2", "-c", source, "-o", source + ".o" }, ToolCommandline::InvokeType::Compile);
+        original->m_invocation.SetId(toolId);
+        std::string err;
+        auto        tasks = localExecutor->SplitTask(original, err);
+        if (!tasks.first) {
+            Syslogger(Syslogger::Err) << err;
+            return 1;
+        }
+        bool preprocessed       = false;
+        tasks.first->m_callback = [&preprocessed](LocalExecutorResult::Ptr result) {
+            if (!result->m_result)
+                Syslogger(Syslogger::Err) << result->m_stdOut;
+            preprocessed = result->m_result;
+        };
+        localExecutor->SyncExecTask(tasks.first);
+        if (!preprocessed)
+            return 1;
+        invocations.push_back(tasks.second->m_invocation);
+    }
+
+    const auto toolsVersions = VersionChecker::Create(localExecutor, invocationToolProvider)->DetermineToolVersions({});
+
+    RemoteToolServer::Config toolServerConfig;
+    toolServerConfig.m_listenHost            = "localhost";
+    toolServerConfig.m_listenPort            = g_benchmarkPort;
+    toolServerConfig.m_threadCount           = threads;
+    toolServerConfig.m_coordinator.m_enabled = false;
+    toolServerConfig.m_compression           = clientConfig.m_compression;
+    RemoteToolServer rcServer(localExecutor, toolsVersions);
+    if (!rcServer.SetConfig(toolServerConfig))
+        return 1;
+    rcServer.Start();
+
+    for (const int batch : { 1, batchSize }) {
+        RemoteToolClient rcClient(invocationToolProvider, toolsVersions);
+        ToolServerInfo   toolServerInfo;
+        toolServerInfo.m_connectionHost = "localhost";
+        toolServerInfo.m_connectionPort = g_benchmarkPort;
+        toolServerInfo.m_totalThreads   = static_cast<uint16_t>(threads);
+        rcClient.AddClient(toolServerInfo);
+
+        RemoteToolClient::Config config = clientConfig;
+        config.m_coordinator.m_enabled  = false;
+        config.m_initialToolServers     = RemoteToolClient::Config::ToolServers();
+        config.m_maxBatchTasks          = batch;
+        config.m_batchInputLimitKB      = std::max(config.m_batchInputLimitKB, 1);
+        config.m_queueTimeout           = 600.0;
+        rcClient.SetConfig(config);
+
+        std::mutex              mutex;
+        std::condition_variable done;
+        bool                    available = false;
+        size_t                  finished  = 0;
+        bool                    failed    = false;
+        rcClient.SetRemoteAvailableCallback([&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            available = true;
+            done.notify_one();
+        });
+        rcClient.Start({ toolId });
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&] { return available; });
+        }
+
+        const TimePoint start(true);
+        for (const auto& invocation : invocations) {
+            rcClient.InvokeTool(invocation, [&](const RemoteToolClient::TaskExecutionInfo& info) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!info.m_result) {
+                    Syslogger(Syslogger::Err) << info.m_stdOutput;
+                    failed = true;
+                }
+                finished++;
+                done.notify_one();
+            });
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return finished == invocations.size(); });
+        if (failed)
+            return 1;
+
+        const TimePoint elapsed = start.GetElapsedTime();
+        Syslogger(Syslogger::Warning) << "batch " << batch << ": wall " << elapsed.ToProfilingTime() << ", "
+                                      << int64_t(files * 1000000. / std::max(elapsed.GetUS(), int64_t(1))) << " files/s";
+    }
+    return 0;
+}
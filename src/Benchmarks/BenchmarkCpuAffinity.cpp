@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include <AppUtils.h>
+#include <ArgStorage.h>
+#include <LocalExecutor.h>
+
+#include <cmath>
+#include <condition_variable>
+
+/*
+ * Compiles same source on all process slots with each cpuAffinity policy, and shows compile time variance.
+ * Arguments: <source file> [compilations per slot, default 4] [slots, default hardware threads].
+ * First gcc/clang tool from [tools] config is used.
+ */
+int main(int argc, char** argv)
+{
+    using namespace Wuild;
+    ArgStorage            argStorage(argc, argv);
+    ConfiguredApplication app(argStorage.GetConfigValues(), "BenchmarkCpuAffinity");
+    auto                  invocationToolProvider = CheckedCreateInvocationToolProvider(app);
+    if (!invocationToolProvider)
+        return 1;
+
+    const auto args = argStorage.GetArgs();
+    if (args.empty()) {
+        Syslogger(Syslogger::Err) << "Usage: <source file> [compilations per slot] [slots]";
+        return 1;
+    }
+    const int runs  = args.size() > 1 ? std::max(std::atoi(args[1].c_str()), 1) : 4;
+    const int slots = args.size() > 2 ? std::max(std::atoi(args[2].c_str()), 1) : std::max(int(std::thread::hardware_concurrency()), 1);
+
+    std::string toolId;
+    for (const auto& tool : invocationToolProvider->GetTools()) {
+        const auto type = tool->GetConfig().m_type;
+        if (type == IInvocationTool::Config::ToolchainType::GCC || type == IInvocationTool::Config::ToolchainType::Clang) {
+            toolId = tool->GetId().m_toolId;
+            break;
+        }
+    }
+    if (toolId.empty()) {
+        Syslogger(Syslogger::Err) << "No gcc or clang tool configured.";
+        return 1;
+    }
+
+    auto localExecutor = LocalExecutor::Create(invocationToolProvider, app.m_tempDir);
+    localExecutor->SetThreadCount(slots);
+
+    const std::vector<std::pair<CpuAffinity, std::string>> policies{
+        { CpuAffinity::None, "none" },
+        { CpuAffinity::Core, "core" },
+        { CpuAffinity::Numa, "numa" },
+        { CpuAffinity::Spread, "spread" },
+    };
+    for (const auto& policy : policies) {
+        localExecutor->SetCpuAffinity(policy.first);
+
+        std::mutex              mutex;
+        std::condition_variable done;
+        std::vector<double>     timesMS;
+        bool                    failed = false;
+        const size_t            total  = size_t(runs) * slots;
+        const TimePoint         start(true);
+        for (size_t i = 0; i < total; ++i) {
+            LocalExecutorTask::Ptr task(new LocalExecutorTask());
+            task->m_invocation = ToolCommandline({ "-O2", "-c", args[0], "-o", "/dev/null" }, ToolCommandline::InvokeType::Compile);
+            task->m_invocation.SetId(toolId);
+            task->m_writeInput = false;
+            task->m_readOutput = false;
+            task->m_callback   = [&](LocalExecutorResult::Ptr result) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!result->m_result) {
+                    Syslogger(Syslogger::Err) << result->m_stdOut;
+                    failed = true;
+                }
+                timesMS.push_back(result->m_executionTime.GetUS() / 1000.);
+                done.notify_one();
+            };
+            localExecutor->AddTask(task);
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return timesMS.size() == total; });
+        if (failed)
+            return 1;
+
+        double mean = 0., variance = 0.;
+        for (double time : timesMS)
+            mean += time / total;
+        for (double time : timesMS)
+            variance += (time - mean) * (time - mean) / total;
+        const double stddev = std::sqrt(variance);
+        Syslogger(Syslogger::Warning) << policy.second << ": wall " << start.GetElapsedTime().ToProfilingTime()
+                                      << ", compile mean " << int(mean) << " ms, stddev " << int(stddev) << " ms ("
+                                      << int(stddev * 100 / mean) << "%)";
+    }
+    return 0;
+}
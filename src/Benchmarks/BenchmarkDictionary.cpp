@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include <AppUtils.h>
+#include <ArgStorage.h>
+#include <CompressionDictionary.h>
+#include <FileUtils.h>
+
+#include <algorithm>
+
+namespace {
+using namespace Wuild;
+
+const size_t g_dictionaryMaxSize       = 112 * 1024;
+const size_t g_dictionarySampleMaxSize = 512 * 1024;
+
+int64_t MegabytesPerSecond(size_t bytes, const TimePoint& elapsed)
+{
+    return int64_t(double(bytes) / (1024 * 1024) * 1000000 / std::max(elapsed.GetUS(), int64_t(1)));
+}
+}
+
+/*
+ * Trains zstd dictionary on even preprocessed sources from arguments, and compresses odd ones with and without it.
+ * Shows compressed size and compression/decompression speed. Arguments: <preprocessed files...>, at least two.
+ * Level is taken from compressionLevel config option.
+ */
+int main(int argc, char** argv)
+{
+    using namespace Wuild;
+    ArgStorage            argStorage(argc, argv);
+    ConfiguredApplication app(argStorage.GetConfigValues(), "BenchmarkDictionary");
+
+    const auto args = argStorage.GetArgs();
+    if (args.size() < 2) {
+        Syslogger(Syslogger::Err) << "Usage: <preprocessed files...>";
+        return 1;
+    }
+    if (!CompressionDictionary::IsSupported()) {
+        Syslogger(Syslogger::Err) << "Built without zstd dictionary support.";
+        return 1;
+    }
+
+    RemoteToolClientConfig clientConfig;
+    app.GetRemoteToolClientConfig(clientConfig, true);
+    CompressionInfo compression = clientConfig.m_compression;
+    compression.m_type          = Mernel::CompressionType::ZStd;
+
+    std::vector<ByteArrayHolder> samples, inputs;
+    size_t                       inputSize = 0;
+    for (size_t i = 0; i < args.size(); ++i) {
+        ByteArrayHolder data;
+        if (!FileInfo(args[i]).ReadFile(data)) {
+            Syslogger(Syslogger::Err) << "Failed to read " << args[i];
+            return 1;
+        }
+        if (i % 2 == 0) {
+            const size_t size = std::min(data.size(), g_dictionarySampleMaxSize);
+            samples.push_back(ByteArrayHolder(ByteArray(data.ref().cbegin(), data.ref().cbegin() + size)));
+        } else {
+            inputSize += data.size();
+            inputs.push_back(data);
+        }
+    }
+
+    TimePoint  trainStart(true);
+    const auto dictionary = CompressionDictionary::Train(samples, g_dictionaryMaxSize);
+    if (!dictionary)
+        return 1;
+    Syslogger(Syslogger::Warning) << "Trained " << dictionary->GetData().size() << " bytes on " << samples.size() << " samples in "
+                                  << trainStart.GetElapsedTime().ToProfilingTime() << ", level " << compression.m_level;
+
+    for (const bool useDictionary : { false, true }) {
+        size_t    compressedSize = 0;
+        TimePoint compressTime, uncompressTime;
+        for (const auto& input : inputs) {
+            ByteArrayHolder compressed, uncompressed;
+            TimePoint       start(true);
+            if (useDictionary)
+                dictionary->Compress(input, compressed, compression.m_level);
+            else
+                Mernel::compressDataBuffer(input, compressed, compression);
+            compressTime += start.GetElapsedTime();
+            compressedSize += compressed.size();
+
+            start = TimePoint(true);
+            if (useDictionary)
+                dictionary->Uncompress(compressed, uncompressed);
+            else
+                Mernel::uncompressDataBuffer(compressed, uncompressed, compression);
+            uncompressTime += start.GetElapsedTime();
+            if (uncompressed.ref() != input.ref()) {
+                Syslogger(Syslogger::Err) << "Round trip failed.";
+                return 1;
+            }
+        }
+        Syslogger(Syslogger::Warning) << (useDictionary ? "dictionary: " : "plain:      ") << inputSize / 1024 << " KiB -> " << compressedSize / 1024
+                                      << " KiB (" << (compressedSize * 1000 / std::max(inputSize, size_t(1))) / 10. << "%), "
+                                      << inputs.size() << " inputs, " << compressedSize / inputs.size() << " bytes per input, compress "
+                                      << MegabytesPerSecond(inputSize, compressTime) << " MiB/s, decompress "
+                                      << MegabytesPerSecond(inputSize, uncompressTime) << " MiB/s";
+    }
+    return 0;
+}
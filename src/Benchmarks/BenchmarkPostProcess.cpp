@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include <AppUtils.h>
+#include <ArgStorage.h>
+#include <FileUtils.h>
+
+#include <algorithm>
+
+#include "MernelPlatform/FsUtils.hpp"
+
+namespace {
+using namespace Wuild;
+
+ByteArray ToBytes(const std::string& str)
+{
+    return ByteArray(str.cbegin(), str.cend());
+}
+
+/// Previous implementation: each replacement searches again from the beginning, for each item.
+void ApplyPerItem(const RemoteToolClientConfig::PostProcess& postProcess, ByteArray& data)
+{
+    auto replaceOnce = [&data](const ByteArray& needle, const ByteArray& replacement) -> bool {
+        auto it = std::search(data.begin(), data.end(), needle.begin(), needle.end());
+        if (it == data.end())
+            return false;
+        std::copy(replacement.cbegin(), replacement.cend(), it);
+        return true;
+    };
+    for (auto&& item : postProcess.m_items) {
+        while (replaceOnce(item.m_needle, item.m_replacement)) {
+        }
+    }
+}
+}
+
+/*
+ * Applies client postProcess rules to object files, with previous and current implementation, and shows throughput.
+ * Fails if results differ.
+ * Arguments: <object files...>. Rules are taken from postProcess config option; when it is not set,
+ * current directory and system include paths are remapped, as debug info usually contains them.
+ */
+int main(int argc, char** argv)
+{
+    using namespace Wuild;
+    ArgStorage            argStorage(argc, argv);
+    ConfiguredApplication app(argStorage.GetConfigValues(), "BenchmarkPostProcess");
+
+    const auto args = argStorage.GetArgs();
+    if (args.empty()) {
+        Syslogger(Syslogger::Err) << "Usage: <object files...>";
+        return 1;
+    }
+
+    RemoteToolClientConfig clientConfig;
+    app.GetRemoteToolClientConfig(clientConfig, true);
+    RemoteToolClientConfig::PostProcess postProcess = clientConfig.m_postProcess;
+    if (postProcess.m_items.empty()) {
+        for (const std::string& path : { Mernel::path2string(Mernel::std_fs::current_path()), std::string("/usr/include/"), std::string("/usr/lib/gcc/") }) {
+            std::string replacement = path;
+            std::replace_if(replacement.begin() + 1, replacement.end(), [](char c) { return c != '/'; }, 'x');
+            postProcess.m_items.push_back({ ToBytes(path), ToBytes(replacement) });
+        }
+    }
+
+    Syslogger(Syslogger::Warning) << "Rules: " << postProcess.m_items.size();
+
+    std::vector<ByteArray> objects;
+    size_t                 totalSize = 0;
+    for (const auto& path : args) {
+        ByteArrayHolder data;
+        if (!FileInfo(path).ReadFile(data) || data.size() == 0) {
+            Syslogger(Syslogger::Err) << "Failed to read " << path;
+            return 1;
+        }
+        totalSize += data.size();
+        objects.push_back(data.ref());
+    }
+    // repeat small inputs, so measurement is not lost in timer resolution.
+    const size_t rounds = std::max(size_t(1), size_t(256 * 1024 * 1024) / totalSize);
+
+    std::vector<ByteArray> reference;
+    for (const auto& variant : { std::string("search"), std::string("memchr") }) {
+        std::vector<ByteArray> results;
+        TimePoint              elapsed;
+        for (size_t round = 0; round < rounds; ++round) {
+            results = objects;
+            TimePoint start(true);
+            for (auto& data : results) {
+                if (variant == "search")
+                    ApplyPerItem(postProcess, data);
+                else
+                    postProcess.Apply(data);
+            }
+            elapsed += start.GetElapsedTime();
+        }
+        if (reference.empty())
+            reference = results;
+        else if (reference != results) {
+            Syslogger(Syslogger::Err) << "Results differ";
+            return 1;
+        }
+
+        const double megabytes = double(totalSize) * rounds / (1024 * 1024);
+        Syslogger(Syslogger::Warning) << variant << ": " << elapsed.ToProfilingTime() << " for " << int64_t(megabytes) << " MiB, "
+                                      << int64_t(megabytes * 1000000 / std::max(elapsed.GetUS(), int64_t(1))) << " MiB/s";
+    }
+    return 0;
+}
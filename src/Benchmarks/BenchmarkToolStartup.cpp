@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include <AppUtils.h>
+#include <ArgStorage.h>
+#include <LocalExecutor.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+using namespace Wuild;
+
+#ifdef _WIN32
+const char* s_nullDevice = "NUL";
+#else
+const char* s_nullDevice = "/dev/null";
+#endif
+
+LocalExecutorResult::Ptr Exec(ILocalExecutor::Ptr executor, const std::string& toolId, StringVector args)
+{
+    LocalExecutorResult::Ptr result;
+    LocalExecutorTask::Ptr   task(new LocalExecutorTask());
+    task->m_invocation = ToolCommandline(std::move(args), ToolCommandline::InvokeType::Compile);
+    task->m_invocation.SetId(toolId);
+    task->m_writeInput = false;
+    task->m_readOutput = false;
+    task->m_callback   = [&result](LocalExecutorResult::Ptr taskResult) { result = taskResult; };
+    executor->SyncExecTask(task);
+    return result;
+}
+
+/// Drops file pages of compiler driver and its backend from page cache, as after long idle period or big I/O.
+bool Evict(const StringVector& files)
+{
+#ifdef __linux__
+    for (const auto& file : files) {
+        const int fd = open(file.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+}
+
+/*
+ * Measures per-task startup overhead of compilers from [tools] config: empty file compilation time
+ * with compiler binaries evicted from page cache (cold) and after warmup, as toolWarmupIntervalS does.
+ * Optional argument: number of runs (default 10).
+ */
+int main(int argc, char** argv)
+{
+    ArgStorage            argStorage(argc, argv);
+    ConfiguredApplication app(argStorage.GetConfigValues(), "BenchmarkToolStartup");
+    auto                  invocationToolProvider = CheckedCreateInvocationToolProvider(app);
+    if (!invocationToolProvider)
+        return 1;
+
+    const auto args          = argStorage.GetArgs();
+    const int  runs          = args.empty() ? 10 : std::max(std::atoi(args[0].c_str()), 1);
+    auto       localExecutor = LocalExecutor::Create(invocationToolProvider, app.m_tempDir);
+
+    for (const auto& tool : invocationToolProvider->GetTools()) {
+        const auto type = tool->GetConfig().m_type;
+        if (type != IInvocationTool::Config::ToolchainType::GCC && type != IInvocationTool::Config::ToolchainType::Clang)
+            continue;
+
+        const std::string toolId = tool->GetId().m_toolId;
+        StringVector      files{ tool->GetId().m_toolExecutable };
+        for (const char* helper : { "cc1plus", "as" }) {
+            auto result = Exec(localExecutor, toolId, { std::string("-print-prog-name=") + helper });
+            auto path   = StringUtils::Trim(result->m_stdOut);
+            if (result->m_result && FileInfo(path).Exists())
+                files.push_back(path);
+        }
+        const StringVector emptyCompile{ "-x", "c++", "-c", s_nullDevice, "-o", s_nullDevice };
+
+        auto measure = [&](bool cold) {
+            TimePoint total;
+            for (int i = 0; i < runs; ++i) {
+                if (cold && !Evict(files))
+                    return TimePoint();
+                auto result = Exec(localExecutor, toolId, emptyCompile);
+                if (!result->m_result) {
+                    Syslogger(Syslogger::Err) << toolId << " failed: " << result->m_stdOut;
+                    return TimePoint();
+                }
+                total = total + result->m_executionTime;
+            }
+            return TimePoint(total.GetUS() / double(runs) / TimePoint::ONE_SECOND);
+        };
+        const TimePoint cold = measure(true);
+        const TimePoint warm = measure(false);
+
+        Syslogger(Syslogger::Warning) << toolId << " (" << files.size() << " files evicted) average startup, cold: "
+                                      << (cold ? cold.ToProfilingTime() : std::string("n/a"))
+                                      << ", warm: " << warm.ToProfilingTime();
+    }
+    return 0;
+}
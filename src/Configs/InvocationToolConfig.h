@@ -35,7 +35,8 @@ public:
         std::string              m_appendRemote;
         std::string              m_remoteAlias;
         std::string              m_version;
-        ToolchainType            m_type = ToolchainType::AutoDetect;
+        ToolchainType            m_type     = ToolchainType::AutoDetect;
+        bool                     m_pipeMode = false; //!< Feed compiler through stdin/stdout instead of temporary files
         std::vector<std::string> m_names;
     };
     std::vector<Tool> m_tools;
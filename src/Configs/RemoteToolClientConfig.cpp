@@ -15,6 +15,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 
 namespace Wuild {
 
@@ -30,22 +31,69 @@ bool RemoteToolClientConfig::Validate(std::ostream* errStream) const
             *errStream << "invocationAttempts should be at least 1.";
         return false;
     }
+    if (m_maxPrefetchTasks < 0) {
+        if (errStream)
+            *errStream << "maxPrefetchTasks should not be negative.";
+        return false;
+    }
+    if (m_maxBatchTasks < 1) {
+        if (errStream)
+            *errStream << "maxBatchTasks should be at least 1.";
+        return false;
+    }
+    if (m_batchInputLimitKB < 0) {
+        if (errStream)
+            *errStream << "batchInputLimitKB should not be negative.";
+        return false;
+    }
+    if (m_outputThreadCount < 1) {
+        if (errStream)
+            *errStream << "outputThreadCount should be at least 1.";
+        return false;
+    }
+    if (m_uploadByHashMinKB < 0) {
+        if (errStream)
+            *errStream << "uploadByHashMinKB should not be negative.";
+        return false;
+    }
+    if (m_queuedInputLimitMB < 0) {
+        if (errStream)
+            *errStream << "queuedInputLimitMB should not be negative.";
+        return false;
+    }
+    if (!m_localCacheDir.empty() && m_localCacheSizeMB <= 0) {
+        if (errStream)
+            *errStream << "localCacheSizeMB should be greater than 0.";
+        return false;
+    }
     return m_coordinator.Validate(errStream);
 }
 
 void RemoteToolClientConfig::PostProcess::Apply(ByteArray& data) const
 {
-    auto replaceOnce = [&data](const ByteArray& needle, const ByteArray& replacement) -> bool {
-        auto it = std::search(data.begin(), data.end(), needle.begin(), needle.end());
-        if (it == data.end())
-            return false;
-        std::copy(replacement.cbegin(), replacement.cend(), it);
-        return true;
-    };
-    for (auto&& item : m_items) {
-        const auto& needle      = item.m_needle;
-        const auto& replacement = item.m_replacement;
-        while (replaceOnce(needle, replacement)) {
+    // Items are applied in order, each one until no needle is left, so result of one item can be matched by next ones.
+    // Replacement can also complete a new match which starts before it, so search resumes needle size back;
+    // nothing before that could match, so result is the same as searching again from the beginning.
+    uint8_t* const begin = data.data();
+    uint8_t* const end   = begin + data.size();
+    for (const auto& item : m_items) {
+        const size_t size = item.m_needle.size();
+        if (!size || item.m_needle == item.m_replacement)
+            continue;
+        const uint8_t first = item.m_needle[0];
+        uint8_t*      pos   = begin;
+        while (static_cast<size_t>(end - pos) >= size) {
+            // memchr is vectorized; path needles are usually rare in object file.
+            pos = static_cast<uint8_t*>(std::memchr(pos, first, end - pos - size + 1));
+            if (!pos)
+                break;
+            if (std::memcmp(pos, item.m_needle.data(), size) != 0) {
+                ++pos;
+                continue;
+            }
+            std::memcpy(pos, item.m_replacement.data(), std::min(item.m_replacement.size(), size));
+            const size_t offset = pos - begin;
+            pos                 = begin + (offset + 1 > size ? offset + 1 - size : 0);
         }
     }
 }
@@ -34,16 +34,30 @@ public:
         };
         std::vector<Item> m_items;
 
+        /// Replaces each needle with replacement of the same size; items are applied in order, each one until no needle is left.
         void Apply(ByteArray& data) const;
     };
 
 public:
-    TimePoint               m_queueTimeout       = 10.0;
-    TimePoint               m_requestTimeout     = 240.0;
-    int                     m_invocationAttempts = 2;
-    int                     m_minimalRemoteTasks = 10;
-    double                  m_maxLoadAverage     = 0.0;
+    TimePoint               m_queueTimeout           = 10.0;
+    TimePoint               m_requestTimeout         = 240.0;
+    int                     m_invocationAttempts     = 2;
+    int                     m_minimalRemoteTasks     = 10;
+    int                     m_maxPrefetchTasks       = 8;  //!< Upper limit of tasks queued on server beyond its thread count.
+    int                     m_maxBatchTasks          = 8;  //!< Small tasks for same server are sent in one frame; 1 = no batching.
+    int                     m_batchInputLimitKB      = 64; //!< Only tasks with smaller compressed input are batched.
+    int                     m_outputThreadCount      = 2;  //!< Threads which decompress and write recieved results.
+    int                     m_localCacheSizeMB       = 2048;
+    int                     m_uploadByHashMinKB      = 16;  //!< Bigger inputs are sent by hash if server has them; 0 = always send data.
+    int                     m_queuedInputLimitMB     = 512; //!< Above it, input of queued task is read when task is sent; 0 = no limit.
+    double                  m_maxLoadAverage         = 0.0;
+    bool                    m_adaptiveLocalExecution = true;  //!< Run remote-capable task locally if that expected to be faster.
+    bool                    m_adaptiveCompression    = false; //!< Choose input compression per task from measured link and CPU speed.
+    bool                    m_uploadChunks           = false; //!< Send only header chunks of preprocessed input which server does not have.
+    bool                    m_fusedPreprocessing     = false; //!< Preprocessor output goes to remote task from memory, without preprocess build step.
     std::string             m_clientId;
+    std::string             m_localCacheDir;         //!< Cache of object files by preprocessed input; empty = disabled.
+    std::string             m_compressionDictionary; //!< Zstd dictionary file for inputs, trained on first inputs if missing; empty = disabled.
     CoordinatorClientConfig m_coordinator;
     ToolServers             m_initialToolServers;
     CompressionInfo         m_compression;
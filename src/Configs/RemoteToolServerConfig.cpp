@@ -34,7 +34,66 @@ bool RemoteToolServerConfig::Validate(std::ostream* errStream) const
             *errStream << "threadCount: Number of threads should be greater than zero.";
         return false;
     }
+    if (m_ioThreadCount < 0) {
+        if (errStream)
+            *errStream << "ioThreadCount: should not be negative.";
+        return false;
+    }
+    if (m_minThreadCount < 0 || m_minThreadCount > m_threadCount) {
+        if (errStream)
+            *errStream << "minThreadCount: should be between 0 and threadCount.";
+        return false;
+    }
+    for (const auto& schedule : m_threadSchedule) {
+        if (schedule.m_fromMinute < 0 || schedule.m_fromMinute >= 24 * 60 || schedule.m_toMinute < 0 || schedule.m_toMinute >= 24 * 60 || schedule.m_threadCount <= 0) {
+            if (errStream)
+                *errStream << "threadSchedule: expected HH:MM-HH:MM:threads entries with positive thread count.";
+            return false;
+        }
+    }
+    if (m_threadScalingIntervalS <= 0) {
+        if (errStream)
+            *errStream << "threadScalingIntervalS: should be greater than zero.";
+        return false;
+    }
+    if (m_memoryStagingReserveMB < 0) {
+        if (errStream)
+            *errStream << "memoryStagingReserveMB: should not be negative.";
+        return false;
+    }
+    if (m_memoryAdmissionReserveMB < 0) {
+        if (errStream)
+            *errStream << "memoryAdmissionReserveMB: should not be negative.";
+        return false;
+    }
+    if (m_toolWarmupIntervalS < 0) {
+        if (errStream)
+            *errStream << "toolWarmupIntervalS: should not be negative.";
+        return false;
+    }
+    if (m_defaultClientWeight <= 0) {
+        if (errStream)
+            *errStream << "defaultClientWeight should be greater than zero.";
+        return false;
+    }
+    for (const auto& clientWeight : m_clientWeights) {
+        if (clientWeight.second <= 0) {
+            if (errStream)
+                *errStream << "clientWeights: weight for '" << clientWeight.first << "' should be greater than zero.";
+            return false;
+        }
+    }
 
+    if (!m_resultCacheDir.empty() && m_resultCacheSizeMB <= 0) {
+        if (errStream)
+            *errStream << "resultCacheSizeMB should be greater than 0.";
+        return false;
+    }
+    if (m_inputCacheSizeMB < 0) {
+        if (errStream)
+            *errStream << "inputCacheSizeMB should not be negative.";
+        return false;
+    }
     return m_coordinator.Validate(errStream);
 }
 
@@ -16,18 +16,43 @@
 #include "CoordinatorClientConfig.h"
 
 #include <FileUtils.h>
+#include <CpuAffinity.h>
+
+#include <map>
 
 namespace Wuild {
 class RemoteToolServerConfig : public IConfig {
 public:
-    std::string             m_serverName;
-    std::string             m_listenHost;
-    StringVector            m_hostsWhiteList; //!< List of hostnames which allowed to connect. If empty, any host allowed.
-    int                     m_listenPort  = 0;
-    int                     m_threadCount = 1;
-    CoordinatorClientConfig m_coordinator;
-    CompressionInfo         m_compression;
-    bool                    m_useClientCompression = true;
+    /// Thread count limit for time range of day.
+    struct ThreadSchedule {
+        int m_fromMinute  = 0; //!< Minutes since local midnight, inclusive
+        int m_toMinute    = 0; //!< Exclusive; range passes midnight if it is less than m_fromMinute
+        int m_threadCount = 0;
+    };
+
+public:
+    std::string                   m_serverName;
+    std::string                   m_listenHost;
+    StringVector                  m_hostsWhiteList; //!< List of hostnames which allowed to connect. If empty, any host allowed.
+    int                           m_listenPort     = 0;
+    int                           m_threadCount    = 1;
+    int                           m_ioThreadCount  = 0;              //!< Threads for input/output files and compression; 0 = threadCount / 8.
+    int                           m_minThreadCount = 0;              //!< Lower bound when thread count follows system load; 0 = no load scaling.
+    std::vector<ThreadSchedule>   m_threadSchedule;                  //!< Replaces threadCount as upper bound in given time ranges.
+    int                           m_threadScalingIntervalS = 10;     //!< How often thread count is recalculated.
+    std::string                   m_memoryStagingDir;                //!< In-memory filesystem for temporary files (e.g. /dev/shm); empty = disabled.
+    int                           m_memoryStagingReserveMB   = 2048; //!< Fallback to disk when less memory is available.
+    int                           m_memoryAdmissionReserveMB = 1024; //!< Postpone tasks which would leave less memory available; 0 = disabled.
+    int                           m_toolWarmupIntervalS      = 0;    //!< Keep compilers in page cache by idle empty compilation; 0 = disabled.
+    std::string                   m_resultCacheDir;                  //!< Compilation results are reused for identical requests; empty = disabled.
+    int                           m_resultCacheSizeMB = 4096;        //!< Least recently used results are removed above this size.
+    int                           m_inputCacheSizeMB  = 256;         //!< Recent inputs and input chunks kept in memory for hash-first and chunked upload; 0 = disabled.
+    CoordinatorClientConfig       m_coordinator;
+    CompressionInfo               m_compression;
+    CpuAffinity                   m_cpuAffinity          = CpuAffinity::None; //!< Placement of compiler processes on CPUs.
+    bool                          m_useClientCompression = true;
+    std::map<std::string, double> m_clientWeights;             //!< Executor queue share per clientId; more is better.
+    double                        m_defaultClientWeight = 1.0; //!< Share for clients not listed in m_clientWeights.
 
     bool Validate(std::ostream* errStream = nullptr) const override;
 };
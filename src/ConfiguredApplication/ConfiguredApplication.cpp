@@ -22,6 +22,8 @@
 #include <Syslogger.h>
 #include <FileUtils.h>
 
+#include <cstdio>
+#include <cstdlib>
 #include <utility>
 
 #include <memory>
@@ -283,6 +285,7 @@ void ConfiguredApplication::ReadInvocationToolProviderConfig()
         unit.m_removeRemote = m_config->GetString(defaultGroup, id + "_removeRemote");
         unit.m_remoteAlias  = m_config->GetString(defaultGroup, id + "_remoteAlias");
         unit.m_version      = m_config->GetString(defaultGroup, id + "_version");
+        unit.m_pipeMode     = m_config->GetBool(defaultGroup, id + "_pipeMode");
 
         if (disableVersionChecks)
             unit.m_version = InvocationToolConfig::VERSION_NO_CHECK;
@@ -312,10 +315,24 @@ void ConfiguredApplication::ReadInvocationToolProviderConfig()
 void ConfiguredApplication::ReadRemoteToolClientConfig()
 {
     const std::string defaultGroup("toolClient");
-    m_remoteToolClientConfig.m_invocationAttempts = m_config->GetInt(defaultGroup, "invocationAttempts", m_remoteToolClientConfig.m_invocationAttempts);
-    m_remoteToolClientConfig.m_minimalRemoteTasks = m_config->GetInt(defaultGroup, "minimalRemoteTasks", m_remoteToolClientConfig.m_minimalRemoteTasks);
-    m_remoteToolClientConfig.m_maxLoadAverage     = m_config->GetDouble(defaultGroup, "maxLoadAverage", m_remoteToolClientConfig.m_maxLoadAverage);
-    m_remoteToolClientConfig.m_postProcess        = ParsePostProcess(m_config->GetString(defaultGroup, "postProcess"));
+    m_remoteToolClientConfig.m_invocationAttempts     = m_config->GetInt(defaultGroup, "invocationAttempts", m_remoteToolClientConfig.m_invocationAttempts);
+    m_remoteToolClientConfig.m_minimalRemoteTasks     = m_config->GetInt(defaultGroup, "minimalRemoteTasks", m_remoteToolClientConfig.m_minimalRemoteTasks);
+    m_remoteToolClientConfig.m_maxLoadAverage         = m_config->GetDouble(defaultGroup, "maxLoadAverage", m_remoteToolClientConfig.m_maxLoadAverage);
+    m_remoteToolClientConfig.m_maxPrefetchTasks       = m_config->GetInt(defaultGroup, "maxPrefetchTasks", m_remoteToolClientConfig.m_maxPrefetchTasks);
+    m_remoteToolClientConfig.m_maxBatchTasks          = m_config->GetInt(defaultGroup, "maxBatchTasks", m_remoteToolClientConfig.m_maxBatchTasks);
+    m_remoteToolClientConfig.m_batchInputLimitKB      = m_config->GetInt(defaultGroup, "batchInputLimitKB", m_remoteToolClientConfig.m_batchInputLimitKB);
+    m_remoteToolClientConfig.m_outputThreadCount      = m_config->GetInt(defaultGroup, "outputThreadCount", m_remoteToolClientConfig.m_outputThreadCount);
+    m_remoteToolClientConfig.m_uploadByHashMinKB      = m_config->GetInt(defaultGroup, "uploadByHashMinKB", m_remoteToolClientConfig.m_uploadByHashMinKB);
+    m_remoteToolClientConfig.m_adaptiveLocalExecution = m_config->GetBool(defaultGroup, "adaptiveLocalExecution", m_remoteToolClientConfig.m_adaptiveLocalExecution);
+    m_remoteToolClientConfig.m_adaptiveCompression    = m_config->GetBool(defaultGroup, "adaptiveCompression", m_remoteToolClientConfig.m_adaptiveCompression);
+    m_remoteToolClientConfig.m_uploadChunks           = m_config->GetBool(defaultGroup, "uploadChunks", m_remoteToolClientConfig.m_uploadChunks);
+    m_remoteToolClientConfig.m_fusedPreprocessing     = m_config->GetBool(defaultGroup, "fusedPreprocessing", m_remoteToolClientConfig.m_fusedPreprocessing);
+    m_remoteToolClientConfig.m_queuedInputLimitMB     = m_config->GetInt(defaultGroup, "queuedInputLimitMB", m_remoteToolClientConfig.m_queuedInputLimitMB);
+    m_remoteToolClientConfig.m_postProcess            = ParsePostProcess(m_config->GetString(defaultGroup, "postProcess"));
+    m_remoteToolClientConfig.m_clientId               = m_config->GetString(defaultGroup, "clientId");
+    m_remoteToolClientConfig.m_localCacheDir          = m_config->GetString(defaultGroup, "localCacheDir");
+    m_remoteToolClientConfig.m_localCacheSizeMB       = m_config->GetInt(defaultGroup, "localCacheSizeMB", m_remoteToolClientConfig.m_localCacheSizeMB);
+    m_remoteToolClientConfig.m_compressionDictionary  = m_config->GetString(defaultGroup, "compressionDictionary");
 
     int queueTimeoutMS = m_config->GetInt(defaultGroup, "queueTimeoutMS");
     if (queueTimeoutMS)
@@ -338,12 +355,52 @@ void ConfiguredApplication::ReadRemoteToolClientConfig()
 void ConfiguredApplication::ReadRemoteToolServerConfig()
 {
     const std::string defaultGroup("toolServer");
-    m_remoteToolServerConfig.m_listenPort           = m_config->GetInt(defaultGroup, "listenPort");
-    m_remoteToolServerConfig.m_listenHost           = m_config->GetString(defaultGroup, "listenHost");
-    m_remoteToolServerConfig.m_threadCount          = m_config->GetInt(defaultGroup, "threadCount", m_remoteToolServerConfig.m_threadCount);
-    m_remoteToolServerConfig.m_serverName           = m_config->GetString(defaultGroup, "serverName");
-    m_remoteToolServerConfig.m_hostsWhiteList       = m_config->GetStringList(defaultGroup, "hostsWhiteList");
-    m_remoteToolServerConfig.m_useClientCompression = m_config->GetBool(defaultGroup, "useClientCompression", m_remoteToolServerConfig.m_useClientCompression);
+    m_remoteToolServerConfig.m_listenPort               = m_config->GetInt(defaultGroup, "listenPort");
+    m_remoteToolServerConfig.m_listenHost               = m_config->GetString(defaultGroup, "listenHost");
+    m_remoteToolServerConfig.m_threadCount              = m_config->GetInt(defaultGroup, "threadCount", m_remoteToolServerConfig.m_threadCount);
+    m_remoteToolServerConfig.m_ioThreadCount            = m_config->GetInt(defaultGroup, "ioThreadCount", m_remoteToolServerConfig.m_ioThreadCount);
+    m_remoteToolServerConfig.m_memoryStagingDir         = m_config->GetString(defaultGroup, "memoryStagingDir");
+    m_remoteToolServerConfig.m_memoryStagingReserveMB   = m_config->GetInt(defaultGroup, "memoryStagingReserveMB", m_remoteToolServerConfig.m_memoryStagingReserveMB);
+    m_remoteToolServerConfig.m_memoryAdmissionReserveMB = m_config->GetInt(defaultGroup, "memoryAdmissionReserveMB", m_remoteToolServerConfig.m_memoryAdmissionReserveMB);
+    m_remoteToolServerConfig.m_toolWarmupIntervalS      = m_config->GetInt(defaultGroup, "toolWarmupIntervalS", m_remoteToolServerConfig.m_toolWarmupIntervalS);
+    m_remoteToolServerConfig.m_resultCacheDir           = m_config->GetString(defaultGroup, "resultCacheDir");
+    m_remoteToolServerConfig.m_resultCacheSizeMB        = m_config->GetInt(defaultGroup, "resultCacheSizeMB", m_remoteToolServerConfig.m_resultCacheSizeMB);
+    m_remoteToolServerConfig.m_inputCacheSizeMB         = m_config->GetInt(defaultGroup, "inputCacheSizeMB", m_remoteToolServerConfig.m_inputCacheSizeMB);
+
+    const std::string cpuAffinity = m_config->GetString(defaultGroup, "cpuAffinity", "none"); // "none"|"core"|"numa"|"spread"
+    if (cpuAffinity == "core")
+        m_remoteToolServerConfig.m_cpuAffinity = CpuAffinity::Core;
+    else if (cpuAffinity == "numa")
+        m_remoteToolServerConfig.m_cpuAffinity = CpuAffinity::Numa;
+    else if (cpuAffinity == "spread")
+        m_remoteToolServerConfig.m_cpuAffinity = CpuAffinity::Spread;
+    else if (cpuAffinity != "none")
+        Syslogger(Syslogger::Warning) << "Unknown cpuAffinity value: " << cpuAffinity;
+
+    m_remoteToolServerConfig.m_serverName             = m_config->GetString(defaultGroup, "serverName");
+    m_remoteToolServerConfig.m_hostsWhiteList         = m_config->GetStringList(defaultGroup, "hostsWhiteList");
+    m_remoteToolServerConfig.m_useClientCompression   = m_config->GetBool(defaultGroup, "useClientCompression", m_remoteToolServerConfig.m_useClientCompression);
+    m_remoteToolServerConfig.m_defaultClientWeight    = m_config->GetDouble(defaultGroup, "defaultClientWeight", m_remoteToolServerConfig.m_defaultClientWeight);
+    m_remoteToolServerConfig.m_minThreadCount         = m_config->GetInt(defaultGroup, "minThreadCount", m_remoteToolServerConfig.m_minThreadCount);
+    m_remoteToolServerConfig.m_threadScalingIntervalS = m_config->GetInt(defaultGroup, "threadScalingIntervalS", m_remoteToolServerConfig.m_threadScalingIntervalS);
+    for (const auto& range : m_config->GetStringList(defaultGroup, "threadSchedule")) {
+        // format is HH:MM-HH:MM:threads; invalid entry is reported by Validate.
+        RemoteToolServerConfig::ThreadSchedule schedule{ -1, -1, 0 };
+        int                                    fromH = 0, fromM = 0, toH = 0, toM = 0;
+        if (std::sscanf(range.c_str(), "%d:%d-%d:%d:%d", &fromH, &fromM, &toH, &toM, &schedule.m_threadCount) == 5
+            && fromM >= 0 && fromM < 60 && toM >= 0 && toM < 60) {
+            schedule.m_fromMinute = fromH * 60 + fromM;
+            schedule.m_toMinute   = toH * 60 + toM;
+        }
+        m_remoteToolServerConfig.m_threadSchedule.push_back(schedule);
+    }
+    for (const auto& clientWeight : m_config->GetStringList(defaultGroup, "clientWeights")) {
+        // format is clientId:weight; invalid weight is reported by Validate.
+        const auto delimPos = clientWeight.rfind(':');
+        if (delimPos == std::string::npos || delimPos == 0)
+            continue;
+        m_remoteToolServerConfig.m_clientWeights[clientWeight.substr(0, delimPos)] = std::strtod(clientWeight.c_str() + delimPos + 1, nullptr);
+    }
     ReadCoordinatorClientConfig(m_remoteToolServerConfig.m_coordinator, defaultGroup);
     ReadCompressionConfig(m_remoteToolServerConfig.m_compression, defaultGroup);
 }
@@ -48,6 +48,9 @@ inline ByteOrderDataStreamReader& ByteOrderDataStreamReader::operator>>(ToolServ
         >> info.m_totalThreads
         >> info.m_queuedTasks
         >> info.m_runningTasks
+        >> info.m_memoryLimitedThreads
+        >> info.m_cacheHits
+        >> info.m_cacheMisses
         >> info.m_connectedClients;
     return *this;
 }
@@ -62,6 +65,9 @@ inline ByteOrderDataStreamWriter& ByteOrderDataStreamWriter::operator<<(const To
         << info.m_totalThreads
         << info.m_queuedTasks
         << info.m_runningTasks
+        << info.m_memoryLimitedThreads
+        << info.m_cacheHits
+        << info.m_cacheMisses
         << info.m_connectedClients;
     return *this;
 }
@@ -34,7 +34,7 @@ public:
 
 class CoordinatorListResponse : public SocketFrameExt {
 public:
-    static const uint32_t s_version     = 1;
+    static const uint32_t s_version     = 3;
     static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 2;
     using Ptr                           = std::shared_ptr<CoordinatorListResponse>;
 
@@ -50,7 +50,7 @@ public:
 
 class CoordinatorToolServerStatus : public SocketFrameExt {
 public:
-    static const uint32_t s_version     = 1;
+    static const uint32_t s_version     = 3;
     static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 3;
     using Ptr                           = std::shared_ptr<CoordinatorToolServerStatus>;
 
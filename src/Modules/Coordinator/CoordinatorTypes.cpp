@@ -24,6 +24,11 @@ std::string ToolServerInfo::ToString(bool outputTools, bool outputClients) const
        << " threads: " << m_totalThreads
        << " queue: " << m_queuedTasks
        << " running: " << m_runningTasks;
+    if (m_memoryLimitedThreads)
+        os << " memory limited: " << m_memoryLimitedThreads;
+    if (m_cacheHits + m_cacheMisses)
+        os << " cache hits: " << m_cacheHits << "/" << (m_cacheHits + m_cacheMisses)
+           << " (" << uint64_t(m_cacheHits) * 100 / (m_cacheHits + m_cacheMisses) << "%)";
     if (outputTools) {
         os << " Tools: ";
         for (const std::string& t : m_toolIds)
@@ -59,6 +64,7 @@ bool ToolServerInfo::operator==(const ToolServerInfo& rh) const
            && EqualIdTo(rh)
            && m_toolIds == rh.m_toolIds
            && m_totalThreads == rh.m_totalThreads
+           && m_memoryLimitedThreads == rh.m_memoryLimitedThreads
            && m_connectedClients == rh.m_connectedClients;
 }
 
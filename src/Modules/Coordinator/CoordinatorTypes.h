@@ -25,9 +25,12 @@ struct ToolServerInfo {
     std::string  m_connectionHost;
     int16_t      m_connectionPort = 0;
     StringVector m_toolIds;
-    uint16_t     m_totalThreads = 0;
-    uint16_t     m_queuedTasks  = 0;
-    uint16_t     m_runningTasks = 0;
+    uint16_t     m_totalThreads         = 0;
+    uint16_t     m_queuedTasks          = 0;
+    uint16_t     m_runningTasks         = 0;
+    uint16_t     m_memoryLimitedThreads = 0; //!< Idle threads which can't start tasks due to low memory
+    uint32_t     m_cacheHits            = 0; //!< Requests answered from result cache
+    uint32_t     m_cacheMisses          = 0;
 
     struct ConnectedClientInfo {
         uint16_t    m_usedThreads = 0;
@@ -16,6 +16,7 @@
 #include "MsvcCommandLineParser.h"
 #include "UpdateFileCommandParser.h"
 
+#include <algorithm>
 #include <cassert>
 
 namespace Wuild {
@@ -152,4 +153,63 @@ ToolCommandline InvocationTool::PrepareRemote(const ToolCommandline& original) c
     return inv;
 }
 
+bool InvocationTool::SetupPipes(ToolCommandline& invocation, bool& pipeOutput) const
+{
+    const auto type = m_toolInfo.m_tool.m_type;
+    if (!m_toolInfo.m_tool.m_pipeMode || invocation.m_type != ToolCommandline::InvokeType::Compile)
+        return false;
+    if (type != Config::ToolchainType::GCC && type != Config::ToolchainType::Clang) // MSVC needs real files.
+        return false;
+
+    // stdin has no extension to guess language from; input is already preprocessed.
+    const std::string input = invocation.GetInput();
+    const auto        dot   = input.rfind('.');
+    if (dot == std::string::npos || invocation.m_inputNameIndex < 0 || invocation.m_outputNameIndex < 0)
+        return false;
+    static const StringVector s_cppExtensions{ ".cpp", ".cc", ".cxx", ".c++", ".C" };
+    const std::string         extension = input.substr(dot);
+    std::string               language;
+    if (extension == ".c")
+        language = "cpp-output";
+    else if (std::find(s_cppExtensions.cbegin(), s_cppExtensions.cend(), extension) != s_cppExtensions.cend())
+        language = "c++-cpp-output";
+
+    // explicit "-x c++" (e.g. for header compiled as source) would override inserted one, and stdin would be
+    // preprocessed again; so it is replaced with preprocessed variant. Cases which are not clear go with files.
+    auto& args          = invocation.m_arglist.m_args;
+    int   languageIndex = -1;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i].size() > 2 && args[i].compare(0, 2, "-x") == 0)
+            return false;
+        if (args[i] != "-x")
+            continue;
+        if (languageIndex >= 0 || static_cast<int>(i) + 1 >= invocation.m_inputNameIndex)
+            return false;
+        languageIndex = static_cast<int>(i) + 1;
+    }
+    if (languageIndex >= 0) {
+        const std::string& explicitLanguage = args[languageIndex];
+        if (explicitLanguage == "c" || explicitLanguage == "cpp-output")
+            language = "cpp-output";
+        else if (explicitLanguage == "c++" || explicitLanguage == "c++-cpp-output")
+            language = "c++-cpp-output";
+        else
+            return false; // e.g. precompiled header.
+        args[languageIndex] = language;
+    } else if (language.empty()) {
+        return false; // e.g. Objective-C.
+    } else {
+        args.insert(args.begin(), { "-x", language });
+        invocation.m_inputNameIndex += 2;
+        invocation.m_outputNameIndex += 2;
+    }
+    invocation.SetInput("-");
+
+    // GNU as seeks in object file, so only Clang integrated assembler can write it to pipe.
+    pipeOutput = type == Config::ToolchainType::Clang;
+    if (pipeOutput)
+        invocation.SetOutput("-");
+    return true;
+}
+
 }
@@ -45,6 +45,8 @@ public:
     ToolCommandline FilterFlags(const ToolCommandline& original) const override;
     ToolCommandline PrepareRemote(const ToolCommandline& original) const override;
 
+    bool SetupPipes(ToolCommandline& invocation, bool& pipeOutput) const override;
+
 private:
     ToolInfo m_toolInfo;
 };
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "FairShareQueue.h"
+
+#include <algorithm>
+
+namespace Wuild {
+
+void FairShareQueue::Push(LocalExecutorTask::Ptr task)
+{
+    Group& group = m_groups[task->m_shareGroup];
+    if (group.m_tasks.empty())
+        group.m_virtualTime = std::max(group.m_virtualTime, m_virtualTime);
+    group.m_weight = task->m_shareWeight > 0 ? task->m_shareWeight : 1.0;
+    group.m_tasks.push_back(std::move(task));
+    m_size++;
+}
+
+LocalExecutorTask::Ptr FairShareQueue::Pop()
+{
+    auto next = m_groups.end();
+    for (auto it = m_groups.begin(); it != m_groups.end();) {
+        if (it->second.m_tasks.empty()) {
+            // idle group is kept only while it has debt to others.
+            if (it->second.m_virtualTime <= m_virtualTime)
+                it = m_groups.erase(it);
+            else
+                ++it;
+            continue;
+        }
+        if (next == m_groups.end() || it->second.m_virtualTime < next->second.m_virtualTime)
+            next = it;
+        ++it;
+    }
+    if (next == m_groups.end())
+        return nullptr;
+
+    Group&                 group = next->second;
+    LocalExecutorTask::Ptr task  = group.m_tasks.front();
+    group.m_tasks.pop_front();
+    m_size--;
+    m_virtualTime = std::max(m_virtualTime, group.m_virtualTime);
+    group.m_virtualTime += 1.0 / group.m_weight;
+
+    return task;
+}
+
+LocalExecutorTask::Ptr FairShareQueue::Peek() const
+{
+    const Group* next = nullptr;
+    for (const auto& group : m_groups) {
+        if (!group.second.m_tasks.empty() && (!next || group.second.m_virtualTime < next->m_virtualTime))
+            next = &group.second;
+    }
+    return next ? next->m_tasks.front() : nullptr;
+}
+
+bool FairShareQueue::Remove(const LocalExecutorTask::Ptr& task)
+{
+    auto groupIt = m_groups.find(task->m_shareGroup);
+    if (groupIt == m_groups.end())
+        return false;
+
+    auto& tasks  = groupIt->second.m_tasks;
+    auto  taskIt = std::find(tasks.begin(), tasks.end(), task);
+    if (taskIt == tasks.end())
+        return false;
+
+    tasks.erase(taskIt);
+    m_size--;
+    return true;
+}
+
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+
+#include <LocalExecutorTask.h>
+
+#include <deque>
+#include <map>
+
+namespace Wuild {
+/// Task queue with weighted fair sharing between task groups (LocalExecutorTask::m_shareGroup).
+///
+/// Each group has own FIFO; Pop() takes a task from group with smallest virtual time,
+/// and group virtual time advances by 1/weight for each task taken (start-time fair queuing).
+/// Group which was idle joins not earlier than current virtual time, so it can't bank credit while idle.
+/// Not thread-safe.
+class FairShareQueue {
+public:
+    void                   Push(LocalExecutorTask::Ptr task);
+    LocalExecutorTask::Ptr Pop();
+    LocalExecutorTask::Ptr Peek() const; //!< Task which Pop() would return
+    bool                   Remove(const LocalExecutorTask::Ptr& task);
+
+    size_t Size() const { return m_size; }
+    bool   Empty() const { return m_size == 0; }
+
+private:
+    struct Group {
+        std::deque<LocalExecutorTask::Ptr> m_tasks;
+        double                             m_weight      = 1.0;
+        double                             m_virtualTime = 0.; //!< Virtual start time of next task
+    };
+
+    std::map<std::string, Group> m_groups;
+    double                       m_virtualTime = 0.; //!< Virtual start time of last taken task
+    size_t                       m_size        = 0;
+};
+
+}
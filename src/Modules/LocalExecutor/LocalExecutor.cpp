@@ -14,15 +14,30 @@
 #include "LocalExecutor.h"
 
 #include <subprocess.h>
+#include <Application.h>
+#include <ChunkedCompression.h>
 #include <Syslogger.h>
 #include <ThreadUtils.h>
 
+#include <algorithm>
 #include <cassert>
 #include <utility>
 #include <memory>
 
 namespace Wuild {
 
+namespace {
+#ifdef _WIN32
+constexpr bool s_subprocessPipes = false; // Subprocess can't redirect standard streams on Windows.
+const char*    s_nullDevice      = "NUL";
+#else
+constexpr bool s_subprocessPipes = true;
+const char*    s_nullDevice      = "/dev/null";
+#endif
+constexpr int64_t s_defaultTaskMemory = 512LL * 1024 * 1024; // expectation for tool without history.
+constexpr double  s_historyWeight     = 0.2;                 // weight of last task in running averages.
+}
+
 LocalExecutor::LocalExecutor(IInvocationToolProvider::Ptr invocationToolProvider, std::string tempPath, const std::shared_ptr<SubprocessSet>& subprocessSet)
     : m_invocationToolProvider(std::move(invocationToolProvider))
     , m_tempPath(std::move(tempPath))
@@ -32,6 +47,10 @@ LocalExecutor::LocalExecutor(IInvocationToolProvider::Ptr invocationToolProvider
 
 void LocalExecutor::Start()
 {
+    if (!m_subprocs)
+        m_subprocs = std::make_shared<SubprocessSet>(false);
+    if (!m_ioPool)
+        m_ioPool = std::make_unique<ThreadPool>(GetIoThreadCount());
     m_thread.Exec(std::bind(&LocalExecutor::Quant, this));
 }
 
@@ -42,7 +61,39 @@ void LocalExecutor::AddTask(LocalExecutorTask::Ptr task)
     if (!m_thread.IsRunning())
         Start();
 
-    m_taskQueue.push(task);
+    task->m_queuedAt = TimePoint(true);
+    m_taskQueue.Push(task);
+    m_subprocs->Wakeup();
+}
+
+void LocalExecutor::CancelTask(LocalExecutorTask::Ptr task)
+{
+    bool prepared = false;
+    {
+        Guard guard(m_queueMutex);
+        if (task->m_cancelled)
+            return;
+
+        task->m_cancelled = true;
+        auto preparedIt   = std::find(m_preparedTasks.begin(), m_preparedTasks.end(), task);
+        if (preparedIt != m_preparedTasks.end()) {
+            m_preparedTasks.erase(preparedIt);
+            m_pendingMemory -= task->m_expectedMemory;
+            prepared = true;
+        } else if (!m_taskQueue.Remove(task)) {
+            // Task is already taken by Quant(); result will be reported when process exits.
+            for (const auto& subprocTask : m_subprocToTask) {
+                if (subprocTask.second == task)
+                    subprocTask.first->Terminate();
+            }
+            return;
+        }
+    }
+    // input is already written; caller may keep task object for long, so file is not left until it is destroyed.
+    if (prepared)
+        task->m_inputFile.Remove();
+    Syslogger(Syslogger::Notice) << "Cancelled queued task " << task->GetShortErrorInfo();
+    task->CancelledResult();
 }
 
 void LocalExecutor::SyncExecTask(LocalExecutorTask::Ptr task)
@@ -97,129 +148,476 @@ const StringVector& LocalExecutor::GetToolIds() const
 
 void LocalExecutor::SetThreadCount(int threads)
 {
-    m_maxSubProcesses = threads;
+    {
+        Guard guard(m_queueMutex);
+        m_maxSubProcesses = threads;
+        UpdateCpuSlots();
+        if (m_subprocs)
+            m_subprocs->Wakeup(); // more tasks may be started now.
+    }
+    ResizeIoPool();
+}
+
+void LocalExecutor::SetCpuAffinity(CpuAffinity policy)
+{
+    Guard guard(m_queueMutex);
+    m_cpuAffinity = policy;
+    UpdateCpuSlots();
+}
+
+void LocalExecutor::SetMemoryAdmission(int64_t reservedMemory)
+{
+    Guard guard(m_queueMutex);
+    m_admissionReserve = std::max<int64_t>(reservedMemory, 0);
+    if (m_subprocs)
+        m_subprocs->Wakeup();
+}
+
+size_t LocalExecutor::GetMemoryLimitedThreads() const
+{
+    return m_memoryLimitedSlots;
+}
+
+void LocalExecutor::SetMemoryStaging(const std::string& path, int64_t reservedMemory)
+{
+    m_memoryTempPath = path;
+    m_reservedMemory = reservedMemory;
+    if (!m_memoryTempPath.empty())
+        FileInfo(m_memoryTempPath).Mkdirs();
+}
+
+void LocalExecutor::SetToolWarmup(TimePoint interval)
+{
+    {
+        Guard guard(m_queueMutex);
+        m_warmupInterval = interval;
+    }
+    if (interval)
+        WarmupTools();
+}
+
+void LocalExecutor::SetIoThreadCount(int threads)
+{
+    {
+        Guard guard(m_queueMutex);
+        m_ioThreads = std::max(threads, 0);
+    }
+    ResizeIoPool();
 }
 
 size_t LocalExecutor::GetQueueSize() const
 {
     Guard guard(m_queueMutex);
-    return m_taskQueue.size();
+    return m_taskQueue.Size();
 }
 
-LocalExecutor::~LocalExecutor() = default;
+LocalExecutor::~LocalExecutor()
+{
+    // executor thread could be blocked waiting for processes.
+    m_thread.Cancel();
+    if (m_subprocs)
+        m_subprocs->Wakeup();
+    m_thread.Stop();
+    m_ioPool.reset();
+}
 
-void LocalExecutor::CheckSubprocs()
+void LocalExecutor::ResizeIoPool()
 {
-    if (!m_subprocs)
-        m_subprocs = std::make_shared<SubprocessSet>(false);
+    // resize joins pool workers, and their jobs take m_queueMutex, so it is done without holding it.
+    std::lock_guard<std::mutex> resizeGuard(m_ioResizeMutex);
+    ThreadPool*                 pool    = nullptr;
+    size_t                      threads = 0;
+    {
+        Guard guard(m_queueMutex);
+        pool    = m_ioPool.get(); // once created, pool lives until destructor.
+        threads = GetIoThreadCount();
+    }
+    if (pool)
+        pool->SetThreadCount(threads);
 }
 
-LocalExecutorTask::Ptr LocalExecutor::GetNextTask()
+size_t LocalExecutor::GetIoThreadCount() const
+{
+    if (m_ioThreads > 0)
+        return m_ioThreads;
+    // decompression and disk write usually take few percents of compilation time.
+    return std::clamp<size_t>(m_maxSubProcesses / 8, 1, 8);
+}
+
+bool LocalExecutor::UseMemoryStaging(const LocalExecutorTask& task) const
+{
+    if (m_memoryTempPath.empty())
+        return false;
+    const int64_t available = Application::GetAvailableMemory();
+    if (available < 0)
+        return true; // unknown; write failure still falls back to disk.
+
+    // preprocessed source is compressed several times, and object file is written next to it.
+    const int64_t expectedFootprint = static_cast<int64_t>(task.m_inputData.size()) * 10;
+    if (available - expectedFootprint > m_reservedMemory)
+        return true;
+    Syslogger(Syslogger::Info) << "Available memory is low (" << available / (1024 * 1024) << " MiB), using disk for " << task.GetShortErrorInfo();
+    return false;
+}
+
+void LocalExecutor::UpdateCpuSlots()
+{
+    // running processes keep their slots; CpuSlots moves them to new plan when they exit.
+    std::vector<CpuSet> plan;
+    m_allCpus.clear();
+    if (m_cpuAffinity != CpuAffinity::None) {
+        const auto cpus = GetAvailableCpus();
+        for (const auto& cpu : cpus)
+            m_allCpus.push_back(cpu.m_cpu);
+        plan = PlanCpuSlots(cpus, m_cpuAffinity, m_maxSubProcesses);
+        if (plan.empty())
+            Syslogger(Syslogger::Warning) << "CPU affinity is not supported on this platform.";
+    }
+    m_cpuSlots.Replan(plan);
+}
+
+int64_t LocalExecutor::EstimateMemory(const LocalExecutorTask& task) const
+{
+    auto statsIt = m_toolMemory.find(task.m_invocation.m_id.m_toolId);
+    if (statsIt == m_toolMemory.end())
+        return s_defaultTaskMemory;
+
+    // compiler memory grows with translation unit size, on top of its own footprint.
+    const ToolMemoryStats& stats = statsIt->second;
+    if (stats.m_inputSize <= 0. || !task.m_inputSize)
+        return static_cast<int64_t>(stats.m_peakMemory);
+    const double scale = std::clamp(task.m_inputSize / stats.m_inputSize, 0.5, 4.);
+    return static_cast<int64_t>(stats.m_peakMemory * scale);
+}
+
+bool LocalExecutor::AdmitByMemory(const LocalExecutorTask& task) const
+{
+    if (!m_admissionReserve)
+        return true;
+    // when nothing runs, waiting won't free memory; big task should still be executed.
+    if (m_subprocToTask.empty() && m_preparedTasks.empty() && !m_preparingTasks)
+        return true;
+    const int64_t available = Application::GetAvailableMemory();
+    if (available < 0)
+        return true;
+
+    // running process reaches its peak by the end; assume linear growth over typical duration of its tool.
+    int64_t expected = m_pendingMemory + task.m_expectedMemory;
+    for (const auto& subprocTask : m_subprocToTask) {
+        const LocalExecutorTask& running  = *subprocTask.second;
+        auto                     statsIt  = m_toolMemory.find(running.m_invocation.m_id.m_toolId);
+        const double             duration = statsIt != m_toolMemory.end() ? statsIt->second.m_executionUS : 0.;
+        const double             progress = duration > 0. ? std::min(running.m_executionStart.GetElapsedTime().GetUS() / duration, 1.) : 0.;
+        expected += static_cast<int64_t>(running.m_expectedMemory * (1. - progress));
+    }
+    return available - expected > m_admissionReserve;
+}
+
+void LocalExecutor::UpdateMemoryHistory(const LocalExecutorTask& task, const LocalExecutorResult& result)
+{
+    Guard            guard(m_queueMutex);
+    auto             inserted = m_toolMemory.emplace(task.m_invocation.m_id.m_toolId, ToolMemoryStats());
+    ToolMemoryStats& stats    = inserted.first->second;
+    const double     weight   = inserted.second ? 1. : s_historyWeight;
+    stats.m_peakMemory += (result.m_peakMemory - stats.m_peakMemory) * weight;
+    stats.m_inputSize += (task.m_inputSize - stats.m_inputSize) * weight;
+    stats.m_executionUS += (result.m_executionTime.GetUS() - stats.m_executionUS) * weight;
+}
+
+void LocalExecutor::WarmupTools()
 {
-    LocalExecutorTask::Ptr task;
     {
         Guard guard(m_queueMutex);
-        if (!m_taskQueue.empty()) {
-            task = m_taskQueue.front();
-            m_taskQueue.pop();
+        m_lastActivity = TimePoint(true);
+    }
+    for (const auto& tool : m_invocationToolProvider->GetTools()) {
+        const auto type = tool->GetConfig().m_type;
+        if (type != IInvocationTool::Config::ToolchainType::GCC && type != IInvocationTool::Config::ToolchainType::Clang)
+            continue;
+
+        // compiling empty C++ file loads everything real compilation needs, except headers which come preprocessed.
+        const std::string      toolId = tool->GetId().m_toolId;
+        LocalExecutorTask::Ptr task(new LocalExecutorTask());
+        task->m_invocation = ToolCommandline({ "-x", "c++", "-c", s_nullDevice, "-o", s_nullDevice }, ToolCommandline::InvokeType::Compile);
+        task->m_invocation.SetId(toolId);
+        task->m_writeInput = false;
+        task->m_readOutput = false;
+        task->m_callback   = [toolId](LocalExecutorResult::Ptr result) {
+            if (result->m_result)
+                Syslogger(Syslogger::Info) << "Warmed up " << toolId << " in " << result->m_executionTime.ToProfilingTime();
+            else
+                Syslogger(Syslogger::Info) << "Warmup of " << toolId << " failed: " << result->m_stdOut;
+        };
+        AddTask(task);
+    }
+}
+
+bool LocalExecutor::PrepareTask(LocalExecutorTask::Ptr task)
+{
+    const TimePoint      start(true);
+    ToolCommandline      inv = task->m_invocation;
+    IInvocationTool::Ptr invocationTool;
+    if ((invocationTool = m_invocationToolProvider->GetTool(task->m_invocation.m_id)))
+        inv = invocationTool->CompleteInvocation(inv);
+
+    if (task->m_writeInput) {
+        FileInfo inputFile(inv.GetInput());
+        FileInfo outputFile(inv.GetOutput());
+
+        if (inputFile.GetFullname().empty() || outputFile.GetFullname().empty()) {
+            task->ErrorResult("Failed to extract filenames for " + task->GetShortErrorInfo());
+            return false;
+        }
+        task->m_pipeInput = s_subprocessPipes && invocationTool && invocationTool->SetupPipes(inv, task->m_pipeOutput);
+        if (task->m_pipeInput) {
+            ByteArrayHolder uncompressedInput;
+            try {
+                ChunkedCompression::Uncompress(task->m_inputData, uncompressedInput, task->m_compressionInput);
+            }
+            catch (std::exception& e) {
+                task->ErrorResult("Failed to uncompress input for " + task->GetShortErrorInfo() + ": " + e.what());
+                return false;
+            }
+            task->m_stdinData.assign(reinterpret_cast<const char*>(uncompressedInput.data()), uncompressedInput.size());
+        }
+
+        const auto taskPrefix = "/" + std::to_string(m_taskId++) + "_";
+        auto       writeInput = [&task, &inputFile, &outputFile](const std::string& tmpPrefix) {
+            if (!task->m_pipeOutput) {
+                task->m_outputFile.SetPath(tmpPrefix + outputFile.GetFullname());
+                task->m_outputFile.Remove();
+            }
+            if (task->m_pipeInput)
+                return true;
+            task->m_inputFile.SetPath(tmpPrefix + inputFile.GetFullname());
+            if (task->m_inputFile.WriteCompressed(task->m_inputData, task->m_compressionInput))
+                return true;
+            task->m_inputFile.Remove();
+            return false;
+        };
+        task->m_memoryStaged = !task->m_pipeOutput && UseMemoryStaging(*task) && writeInput(m_memoryTempPath + taskPrefix);
+        if (!task->m_memoryStaged && !writeInput(m_tempPath + taskPrefix)) {
+            task->ErrorResult("Failed to write file " + task->m_inputFile.GetPath());
+            return false;
         }
+        task->m_inputData = ByteArrayHolder(); // not needed anymore, free memory while process is running.
+        if (!task->m_pipeInput)
+            inv.SetInput(task->m_inputFile.GetPath());
+        if (!task->m_pipeOutput)
+            inv.SetOutput(task->m_outputFile.GetPath());
     }
-    return task;
+
+    if (inv.m_id.m_toolExecutable.empty()) {
+        task->ErrorResult("Failed to create cmd string for " + task->GetShortErrorInfo());
+        return false;
+    }
+    task->m_invocation = inv;
+    task->m_inputTime  = start.GetElapsedTime();
+    return true;
 }
 
-bool LocalExecutor::Quant()
+void LocalExecutor::SpawnTask(LocalExecutorTask::Ptr task)
 {
-    CheckSubprocs();
-
-    while (m_subprocs->running_.size() < m_maxSubProcesses) {
-        auto task = GetNextTask();
-        if (task) {
-            do {
-                ToolCommandline           inv = task->m_invocation;
-                IInvocationTool::Ptr invocationTool;
-                if ((invocationTool = m_invocationToolProvider->GetTool(task->m_invocation.m_id)))
-                    inv = invocationTool->CompleteInvocation(inv);
-
-                if (task->m_writeInput) {
-                    FileInfo inputFile(inv.GetInput());
-                    FileInfo outputFile(inv.GetOutput());
-
-                    if (inputFile.GetFullname().empty() || outputFile.GetFullname().empty()) {
-                        task->ErrorResult("Failed to extract filenames for " + task->GetShortErrorInfo());
-                        break;
-                    }
-                    const auto tmpPrefix = m_tempPath + "/" + std::to_string(m_taskId++) + "_";
-                    task->m_inputFile.SetPath(tmpPrefix + inputFile.GetFullname());
-                    task->m_outputFile.SetPath(tmpPrefix + outputFile.GetFullname());
-                    task->m_outputFile.Remove();
-
-                    if (!task->m_inputFile.WriteCompressed(task->m_inputData, task->m_compressionInput)) {
-                        break;
-                    }
-                    inv.SetInput(task->m_inputFile.GetPath());
-                    inv.SetOutput(task->m_outputFile.GetPath());
-                }
+    const auto cmd         = task->m_invocation.m_id.m_toolExecutable + " " + task->m_invocation.GetArgsString();
+    task->m_executionStart = TimePoint(true);
+    SubprocessPipes pipes;
+    pipes.stdin_data     = std::move(task->m_stdinData);
+    pipes.capture_stdout = task->m_pipeOutput;
+    const bool usePipes  = task->m_pipeInput || task->m_pipeOutput;
+
+    // child process inherits CPU affinity of executor thread.
+    CpuSet cpuSlot, allCpus;
+    size_t slot      = 0;
+    bool   slotTaken = false;
+    {
+        Guard guard(m_queueMutex);
+        m_pendingMemory -= task->m_expectedMemory; // now it is counted as running.
+        slotTaken = m_cpuSlots.Acquire(slot, cpuSlot);
+        if (slotTaken)
+            allCpus = m_allCpus;
+    }
+    const bool  pinned     = !cpuSlot.empty() && SetThreadCpuAffinity(cpuSlot);
+    Subprocess* addsubproc = m_subprocs->Add(cmd, false, {}, task->m_readStderr, usePipes ? &pipes : nullptr);
+    if (pinned)
+        SetThreadCpuAffinity(allCpus);
+
+    if (!addsubproc) {
+        if (slotTaken) {
+            Guard guard(m_queueMutex);
+            m_cpuSlots.Release(slot);
+        }
+        task->ErrorResult("Failed to execute: " + cmd);
+        return;
+    }
+    Guard guard(m_queueMutex);
+    if (slotTaken)
+        m_subprocToCpuSlot[addsubproc] = slot;
+    m_subprocToTask[addsubproc] = task;
+    m_lastActivity              = task->m_executionStart;
+    if (task->m_cancelled) // cancelled while we were preparing input.
+        addsubproc->Terminate();
+}
 
-                auto cmd = inv.m_id.m_toolExecutable + " " + inv.GetArgsString();
-                if (inv.m_id.m_toolExecutable.empty()) {
-                    task->ErrorResult("Failed to create cmd string for " + task->GetShortErrorInfo());
-                    break;
-                }
-                task->m_invocation     = inv;
-                task->m_executionStart = TimePoint(true);
-                Subprocess* addsubproc = m_subprocs->Add(cmd, false, {}, task->m_readStderr);
-                if (!addsubproc) {
-                    task->ErrorResult("Failed to execute: " + cmd);
+void LocalExecutor::FinishTask(LocalExecutorTask::Ptr task, LocalExecutorResult::Ptr result)
+{
+    const TimePoint    start(true);
+    std::ostringstream compressionInfo;
+    if (result->m_result && task->m_readOutput && task->m_pipeOutput) {
+        ByteArrayHolder uncompressedOutput(ByteArray(task->m_stdoutData.cbegin(), task->m_stdoutData.cend()));
+        try {
+            ChunkedCompression::Compress(uncompressedOutput, result->m_outputData, task->m_compressionOutput);
+        }
+        catch (std::exception& e) {
+            result->m_result = false;
+            result->m_stdOut = std::string("Failed to compress output: ") + e.what();
+        }
+        compressionInfo << " [" << uncompressedOutput.size() << " / " << result->m_outputData.size() << "]";
+    } else if (result->m_result && task->m_readOutput) {
+        result->m_result = task->m_outputFile.ReadCompressed(result->m_outputData, task->m_compressionOutput);
+        compressionInfo << " [" << task->m_outputFile.GetFileSize() << " / " << result->m_outputData.size() << "]";
+        if (task->m_memoryStaged)
+            compressionInfo << " (memory)";
+
+        if (!result->m_result)
+            result->m_stdOut = "Failed to read file " + task->m_outputFile.GetPath();
+    }
+    if (task->m_pipeInput)
+        compressionInfo << " (pipe)";
+    result->m_inputTime  = task->m_inputTime;
+    result->m_outputTime = start.GetElapsedTime();
+    const std::string outputName = task->m_pipeOutput ? std::string("stdout") : task->m_outputFile.GetPath();
+    if (!outputName.empty())
+        Syslogger(Syslogger::Notice) << task->GetShortErrorInfo() << " -> " << outputName << compressionInfo.str()
+                                     << " queue/input/exec/output ms: " << result->m_queueTime.GetUS() / 1000
+                                     << "/" << result->m_inputTime.GetUS() / 1000
+                                     << "/" << result->m_executionTime.GetUS() / 1000
+                                     << "/" << result->m_outputTime.GetUS() / 1000;
+
+    assert(bool(task->m_callback));
+    task->m_callback(result);
+}
+
+bool LocalExecutor::Quant()
+{
+    // Start processes for prepared tasks; new tasks go to I/O pool to write their input.
+    while (true) {
+        LocalExecutorTask::Ptr task;
+        bool                   prepareAsync = false, prepareInPlace = false;
+        {
+            Guard guard(m_queueMutex);
+            if (!m_preparedTasks.empty()) {
+                task = m_preparedTasks.front();
+                m_preparedTasks.pop_front();
+            } else if (m_subprocs->running_.size() + m_preparingTasks < m_maxSubProcesses && !m_taskQueue.Empty()) {
+                task                   = m_taskQueue.Peek();
+                task->m_inputSize      = task->m_inputData.size();
+                task->m_expectedMemory = EstimateMemory(*task);
+                if (!AdmitByMemory(*task)) {
+                    const size_t idleSlots = m_maxSubProcesses - m_subprocs->running_.size() - m_preparingTasks;
+                    if (!m_memoryLimitedSlots.exchange(idleSlots))
+                        Syslogger(Syslogger::Info) << "Available memory is low (" << Application::GetAvailableMemory() / (1024 * 1024)
+                                                   << " MiB), postponing " << m_taskQueue.Size() << " tasks";
                     break;
                 }
-                m_subprocToTask[addsubproc] = task;
-            } while (false);
-        } else {
-            break;
+                m_taskQueue.Pop();
+                m_pendingMemory += task->m_expectedMemory;
+                prepareAsync   = task->m_writeInput;
+                prepareInPlace = !prepareAsync; // task without input file is cheap to prepare.
+                if (prepareAsync)
+                    m_preparingTasks++;
+            } else {
+                m_memoryLimitedSlots = 0;
+                break;
+            }
         }
+        if (prepareAsync) {
+            m_ioPool->Enqueue([this, task] {
+                const bool prepared = PrepareTask(task);
+                Guard      guard(m_queueMutex);
+                m_preparingTasks--;
+                if (prepared)
+                    m_preparedTasks.push_back(task);
+                else
+                    m_pendingMemory -= task->m_expectedMemory;
+                m_subprocs->Wakeup();
+            });
+            continue;
+        }
+        if (prepareInPlace && !PrepareTask(task)) {
+            Guard guard(m_queueMutex);
+            m_pendingMemory -= task->m_expectedMemory;
+            continue;
+        }
+        SpawnTask(task);
     }
 
-    if (!m_subprocs->running_.empty()) {
-        Subprocess* subproc;
-        while ((subproc = m_subprocs->NextFinished()) == nullptr) {
-            bool interrupted = m_subprocs->DoWork();
-            if (interrupted)
-                return true;
+    if (m_subprocs->running_.empty() && m_subprocs->finished_.empty()) {
+        bool warmup = false;
+        {
+            Guard guard(m_queueMutex);
+            warmup = m_warmupInterval && m_taskQueue.Empty() && !m_preparingTasks && m_lastActivity.GetElapsedTime() > m_warmupInterval;
         }
+        if (warmup)
+            WarmupTools();
+        return true;
+    }
 
-        LocalExecutorResult::Ptr result(new LocalExecutorResult());
-        result->m_result = subproc->Finish() == ExitSuccess;
-        result->m_stdOut = subproc->GetOutput();
+    Subprocess* subproc = m_subprocs->NextFinished();
+    if (!subproc) {
+        if (m_subprocs->DoWork())
+            return true; // interrupted.
+        subproc = m_subprocs->NextFinished();
+        if (!subproc)
+            return false; // woken up by new task or some output received.
+    }
 
-        auto taskIter = m_subprocToTask.find(subproc);
+    LocalExecutorTask::Ptr task;
+    bool                   cancelled = false;
+    {
+        // Forget subprocess before reaping it, so CancelTask() never signals reaped pid.
+        Guard guard(m_queueMutex);
+        auto  taskIter = m_subprocToTask.find(subproc);
         assert(taskIter != m_subprocToTask.end());
-        LocalExecutorTask::Ptr task = taskIter->second;
+        task = taskIter->second;
         m_subprocToTask.erase(taskIter);
-        delete subproc;
-
-        result->m_executionTime    = task->m_executionStart.GetElapsedTime();
-        const auto& executableName = task->m_invocation.m_id.m_toolExecutable;
-        if (result->m_stdOut.size() < 1000
-            && result->m_stdOut.find_first_of('\n') == result->m_stdOut.size() - 1
-            && executableName.find("cl.exe") != std::string::npos) { // cl.exe always outputs input name to stderr.
-            result->m_stdOut.clear();
+        auto slotIter = m_subprocToCpuSlot.find(subproc);
+        if (slotIter != m_subprocToCpuSlot.end()) {
+            m_cpuSlots.Release(slotIter->second);
+            m_subprocToCpuSlot.erase(slotIter);
         }
+        cancelled = task->m_cancelled;
+    }
 
-        std::ostringstream compressionInfo;
-        if (result->m_result && task->m_readOutput) {
-            result->m_result = task->m_outputFile.ReadCompressed(result->m_outputData, task->m_compressionOutput);
-            compressionInfo << " [" << task->m_outputFile.GetFileSize() << " / " << result->m_outputData.size() << "]";
-
-            if (!result->m_result)
-                result->m_stdOut = "Failed to read file " + task->m_outputFile.GetPath();
-        }
-        if (!task->m_outputFile.GetPath().empty())
-            Syslogger(Syslogger::Notice) << task->GetShortErrorInfo() << " -> " << task->m_outputFile.GetPath() << compressionInfo.str();
+    LocalExecutorResult::Ptr result(new LocalExecutorResult());
+    result->m_result = subproc->Finish() == ExitSuccess;
+    result->m_stdOut     = subproc->GetOutput();
+    result->m_peakMemory = subproc->GetPeakMemory();
+    if (task->m_pipeOutput)
+        task->m_stdoutData = subproc->GetStdout();
+    delete subproc;
+
+    if (cancelled) {
+        Syslogger(Syslogger::Notice) << "Cancelled running task " << task->GetShortErrorInfo();
+        task->CancelledResult();
+        return false;
+    }
 
-        assert(bool(task->m_callback));
-        task->m_callback(result);
+    result->m_executionTime    = task->m_executionStart.GetElapsedTime();
+    result->m_queueTime        = task->m_queuedAt ? task->m_executionStart - task->m_queuedAt : TimePoint();
+    if (result->m_result && result->m_peakMemory > 0 && task->m_writeInput) // warmup and local tasks don't represent remote load.
+        UpdateMemoryHistory(*task, *result);
+    const auto& executableName = task->m_invocation.m_id.m_toolExecutable;
+    if (result->m_stdOut.size() < 1000
+        && result->m_stdOut.find_first_of('\n') == result->m_stdOut.size() - 1
+        && executableName.find("cl.exe") != std::string::npos) { // cl.exe always outputs input name to stderr.
+        result->m_stdOut.clear();
     }
-    return true;
+
+    if (task->m_readOutput)
+        m_ioPool->Enqueue([this, task, result] { FinishTask(task, result); });
+    else
+        FinishTask(task, result);
+    return false;
 }
 
 }
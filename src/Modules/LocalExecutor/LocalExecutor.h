@@ -12,11 +12,14 @@
  */
 
 #pragma once
+#include "FairShareQueue.h"
+
 #include <ILocalExecutor.h>
 #include <IInvocationToolProvider.h>
 #include <ThreadLoop.h>
+#include <ThreadPool.h>
 
-#include <queue>
+#include <deque>
 #include <map>
 #include <atomic>
 #include <mutex>
@@ -29,7 +32,7 @@ struct SubprocessSet;
 namespace Wuild {
 /// Executes command on local host and notifies caller when task finished.
 ///
-/// Uses ninja's SubprocessSet.
+/// Uses ninja's SubprocessSet. Queued tasks are started in weighted fair order between share groups.
 class LocalExecutor : public ILocalExecutor {
     LocalExecutor(IInvocationToolProvider::Ptr invocationToolProvider, std::string tempPath, const std::shared_ptr<SubprocessSet>& subprocessSet);
 
@@ -41,30 +44,76 @@ public:
 
 public:
     void                AddTask(LocalExecutorTask::Ptr task) override;
+    void                CancelTask(LocalExecutorTask::Ptr task) override;
     void                SyncExecTask(LocalExecutorTask::Ptr task) override;
     TaskPair            SplitTask(LocalExecutorTask::Ptr task, std::string& err) override;
     const StringVector& GetToolIds() const override;
     void                SetThreadCount(int threads) override;
+    void                SetIoThreadCount(int threads) override;
+    void                SetMemoryStaging(const std::string& path, int64_t reservedMemory) override;
+    void                SetToolWarmup(TimePoint interval) override;
+    void                SetCpuAffinity(CpuAffinity policy) override;
+    void                SetMemoryAdmission(int64_t reservedMemory) override;
+    size_t              GetMemoryLimitedThreads() const override;
     size_t              GetQueueSize() const override;
 
     ~LocalExecutor();
 
 private:
-    void                   Start();
-    void                   CheckSubprocs();
-    LocalExecutorTask::Ptr GetNextTask();
-    bool                   Quant();
+    void   Start();
+    size_t GetIoThreadCount() const;
+    void   ResizeIoPool();
+    bool   UseMemoryStaging(const LocalExecutorTask& task) const;
+    void   WarmupTools();
+    void   UpdateCpuSlots();
+    bool   Quant();
+
+    // Memory admission; called under m_queueMutex, except UpdateMemoryHistory.
+    int64_t EstimateMemory(const LocalExecutorTask& task) const;
+    bool    AdmitByMemory(const LocalExecutorTask& task) const;
+    void    UpdateMemoryHistory(const LocalExecutorTask& task, const LocalExecutorResult& result);
+
+    // Stages of task processing; input and output files are handled by I/O pool,
+    // so executor thread only spawns and reaps processes.
+    bool PrepareTask(LocalExecutorTask::Ptr task);
+    void SpawnTask(LocalExecutorTask::Ptr task);
+    void FinishTask(LocalExecutorTask::Ptr task, LocalExecutorResult::Ptr result);
 
-    size_t             m_maxSubProcesses = 1;
-    size_t             m_taskId          = 0;
+    std::atomic_size_t m_maxSubProcesses{ 1 }; //!< Written under m_queueMutex; changed at runtime by thread scaler
+    size_t             m_ioThreads = 0;        //!< 0 = depends on m_maxSubProcesses
+    std::atomic_size_t m_taskId{ 0 };
     mutable std::mutex m_queueMutex;
+    std::mutex         m_ioResizeMutex; //!< Serializes m_ioPool resizes; never taken under m_queueMutex
     using Guard = std::lock_guard<std::mutex>;
-    std::queue<LocalExecutorTask::Ptr> m_taskQueue;
+    FairShareQueue                     m_taskQueue;
+    std::deque<LocalExecutorTask::Ptr> m_preparedTasks;      //!< Input is written, ready to spawn
+    size_t                             m_preparingTasks = 0; //!< Tasks being prepared by I/O pool
+    TimePoint                          m_warmupInterval;     //!< 0 = no tool warmup
+    TimePoint                          m_lastActivity;       //!< Last time process was spawned
+
+    CpuAffinity                   m_cpuAffinity = CpuAffinity::None;
+    CpuSet                        m_allCpus;
+    CpuSlots                      m_cpuSlots; //!< Empty = no pinning
+    std::map<Subprocess*, size_t> m_subprocToCpuSlot; //!< Slots are guarded by m_queueMutex
+
+    /// Running averages over finished tasks of one tool.
+    struct ToolMemoryStats {
+        double m_peakMemory  = 0.;
+        double m_inputSize   = 0.;
+        double m_executionUS = 0.;
+    };
+    std::map<std::string, ToolMemoryStats> m_toolMemory;           //!< By tool id
+    int64_t                                m_admissionReserve = 0; //!< Bytes which should stay available; 0 = no memory admission
+    int64_t                                m_pendingMemory    = 0; //!< Expected memory of admitted tasks which are not started yet
+    std::atomic_size_t                     m_memoryLimitedSlots{ 0 };
 
     IInvocationToolProvider::Ptr                  m_invocationToolProvider;
     std::string                                   m_tempPath;
+    std::string                                   m_memoryTempPath;     //!< tmpfs dir; empty = disabled
+    int64_t                                       m_reservedMemory = 0; //!< Bytes which should stay available
     std::shared_ptr<SubprocessSet>                m_subprocs;
-    std::map<Subprocess*, LocalExecutorTask::Ptr> m_subprocToTask;
+    std::map<Subprocess*, LocalExecutorTask::Ptr> m_subprocToTask; //!< Guarded by m_queueMutex
+    std::unique_ptr<ThreadPool>                   m_ioPool;
     ThreadLoop                                    m_thread;
 };
 
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "ChunkedInput.h"
+
+#include <Sha256.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace Wuild {
+
+namespace {
+bool StartsWith(const uint8_t* begin, const uint8_t* end, const char* prefix)
+{
+    const size_t size = strlen(prefix);
+    return size_t(end - begin) >= size && memcmp(begin, prefix, size) == 0;
+}
+
+// gcc and clang: # 12 "file" 1 3, flag 1 is entering the file, 2 is returning to it; lines without flags are jumps within file.
+bool IsFileBoundary(const uint8_t* begin, const uint8_t* end)
+{
+    if (StartsWith(begin, end, "#line "))
+        return true;
+    if (!StartsWith(begin, end, "# ") || end - begin < 3 || !isdigit(begin[2]))
+        return false;
+
+    const uint8_t* quote = nullptr;
+    for (const uint8_t* it = begin; it != end; ++it) {
+        if (*it == '"')
+            quote = it;
+    }
+    if (!quote)
+        return false;
+    const uint8_t* flag = quote + 1;
+    while (flag != end && *flag == ' ')
+        ++flag;
+    return flag != end && (*flag == '1' || *flag == '2') && (flag + 1 == end || !isdigit(flag[1]));
+}
+}
+
+ChunkedInput::Ptr ChunkedInput::Split(const ByteArrayHolder& data)
+{
+    auto input    = std::make_shared<ChunkedInput>();
+    input->m_data = data;
+
+    const uint8_t* begin      = data.data();
+    const uint8_t* end        = begin + data.size();
+    const uint8_t* chunkStart = begin;
+    auto           addChunk   = [&input, begin, &chunkStart](const uint8_t* chunkEnd) {
+        Chunk chunk;
+        chunk.m_offset = chunkStart - begin;
+        chunk.m_size   = chunkEnd - chunkStart;
+        chunk.m_hash   = Sha256().Update(chunkStart, chunk.m_size).GetHexDigest();
+        input->m_chunks.push_back(chunk);
+        chunkStart = chunkEnd;
+    };
+    for (const uint8_t* line = begin; line != end;) {
+        const uint8_t* lineEnd = std::find(line, end, '\n');
+        if (*line == '#' && size_t(line - chunkStart) >= s_minChunkSize && IsFileBoundary(line, lineEnd))
+            addChunk(line);
+        line = lineEnd == end ? end : lineEnd + 1;
+    }
+    if (chunkStart != end)
+        addChunk(end);
+    return input;
+}
+
+StringVector ChunkedInput::GetHashes() const
+{
+    StringVector hashes;
+    hashes.reserve(m_chunks.size());
+    for (const auto& chunk : m_chunks)
+        hashes.push_back(chunk.m_hash);
+    return hashes;
+}
+
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+
+#include <CommonTypes.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Wuild {
+/**
+ * Preprocessed source split into chunks, which are sent to tool server only if it does not have them yet.
+ *
+ * Chunk starts at line marker of entering or leaving included file (# 1 "file" 1 for gcc and clang, #line for msvc),
+ * so system and project headers give the same chunks in all sources which include them in same context.
+ * Boundaries depend only on nearby content, so chunks match again after sources differ.
+ */
+class ChunkedInput {
+public:
+    static const size_t s_minChunkSize = 256; //!< Smaller chunks are merged with next ones, hash would cost more than data
+
+    struct Chunk {
+        std::string m_hash; //!< SHA-256 of chunk data
+        size_t      m_offset = 0;
+        size_t      m_size   = 0;
+    };
+    using Ptr = std::shared_ptr<const ChunkedInput>;
+
+public:
+    static Ptr Split(const ByteArrayHolder& data);
+
+    const ByteArrayHolder&    GetData() const { return m_data; }
+    const std::vector<Chunk>& GetChunks() const { return m_chunks; }
+    StringVector              GetHashes() const;
+
+private:
+    ByteArrayHolder    m_data;
+    std::vector<Chunk> m_chunks;
+};
+
+}
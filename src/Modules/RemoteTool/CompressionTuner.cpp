@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "CompressionTuner.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace Wuild {
+
+namespace {
+const int g_zstdLevels[] = { 1, 3, 6, 9 };
+
+// exponential moving sums, 1/8 weight for new sample, same as balancer timings.
+void AddSample(double& sum, double sample)
+{
+    sum = sum * 7 / 8 + sample;
+}
+
+std::string ToString(const CompressionInfo& compression)
+{
+    if (compression.m_type == Mernel::CompressionType::None)
+        return "none";
+    return "zstd " + std::to_string(compression.m_level);
+}
+}
+
+CompressionTuner::CompressionTuner(const CompressionInfo& configured)
+{
+    Candidate none;
+    none.m_compression.m_type = Mernel::CompressionType::None;
+    m_candidates.push_back(none);
+    for (int level : g_zstdLevels) {
+        Candidate zstd;
+        zstd.m_compression.m_type  = Mernel::CompressionType::ZStd;
+        zstd.m_compression.m_level = level;
+        m_candidates.push_back(zstd);
+    }
+    // configured compression of any type (e.g. LZ4 or Gzip) is candidate too.
+    auto isConfigured = [&configured](const Candidate& candidate) {
+        const auto& compression = candidate.m_compression;
+        return compression.m_type == configured.m_type && (compression.m_type == Mernel::CompressionType::None || compression.m_level == configured.m_level);
+    };
+    m_configured = std::find_if(m_candidates.cbegin(), m_candidates.cend(), isConfigured) - m_candidates.cbegin();
+    if (m_configured == m_candidates.size()) {
+        Candidate candidate;
+        candidate.m_compression = configured;
+        m_candidates.push_back(candidate);
+    }
+}
+
+CompressionInfo CompressionTuner::Choose()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t                best  = FindBest();
+    size_t                      index = best;
+    if (++m_tasks % s_exploreInterval == 0) {
+        // candidates which were never tried go first, then all in turn.
+        auto untried = std::find_if(m_candidates.cbegin(), m_candidates.cend(), [](const Candidate& candidate) { return !candidate.m_chosen; });
+        if (untried != m_candidates.cend()) {
+            index = untried - m_candidates.cbegin();
+        } else {
+            m_exploreIndex = (m_exploreIndex + 1) % m_candidates.size();
+            if (m_exploreIndex == best)
+                m_exploreIndex = (m_exploreIndex + 1) % m_candidates.size();
+            index = m_exploreIndex;
+        }
+    }
+    m_candidates[index].m_chosen++;
+    return m_candidates[index].m_compression;
+}
+
+void CompressionTuner::AddCompression(const CompressionInfo& compression, size_t inputSize, size_t outputSize, const TimePoint& elapsed)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& candidate : m_candidates) {
+        if (candidate.m_compression.m_type != compression.m_type || (compression.m_type != Mernel::CompressionType::None && candidate.m_compression.m_level != compression.m_level))
+            continue;
+        AddSample(candidate.m_inputBytes, double(inputSize));
+        AddSample(candidate.m_outputBytes, double(outputSize));
+        AddSample(candidate.m_seconds, std::max(elapsed.GetUS(), int64_t(1)) / 1e6);
+        return;
+    }
+}
+
+void CompressionTuner::AddTransfer(size_t bytes, const TimePoint& transferTime)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const double seconds = std::max(transferTime.GetUS(), int64_t(0)) / 1e6;
+    // least transfer time is taken as round trip; it slowly follows bigger times, if latency grows.
+    if (!m_linkTransfers || seconds < m_roundTrip)
+        m_roundTrip = seconds;
+    else
+        m_roundTrip += (seconds - m_roundTrip) / 64;
+    AddSample(m_linkBytes, double(bytes));
+    AddSample(m_linkSeconds, seconds);
+    AddSample(m_linkTransfers, 1.);
+}
+
+std::string CompressionTuner::GetSummary() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_tasks)
+        return "";
+
+    std::ostringstream os;
+    os << "adaptive compression:";
+    for (const auto& candidate : m_candidates) {
+        if (candidate.m_chosen)
+            os << " " << ToString(candidate.m_compression) << " " << candidate.m_chosen * 100 / m_tasks << "%,";
+    }
+    const double linkSecondsPerByte = GetLinkSecondsPerByte();
+    if (m_linkTransfers) {
+        os << " link " << (linkSecondsPerByte > 0 ? std::to_string(int64_t(1 / linkSecondsPerByte / 1024)) : std::string("unlimited")) << " KiB/s";
+        os << ", round trip " << TimePoint(m_roundTrip).ToProfilingTime();
+        const Candidate& best = m_candidates[FindBest()];
+        if (best.IsMeasured())
+            os << ", effective " << int64_t(1 / best.GetCost(linkSecondsPerByte) / 1024) << " KiB/s with " << ToString(best.m_compression);
+    }
+    return os.str();
+}
+
+double CompressionTuner::Candidate::GetCost(double linkSecondsPerByte) const
+{
+    return (m_seconds + m_outputBytes * linkSecondsPerByte) / std::max(m_inputBytes, 1.);
+}
+
+size_t CompressionTuner::FindBest() const
+{
+    if (!m_linkTransfers)
+        return m_configured;
+
+    const double linkSecondsPerByte = GetLinkSecondsPerByte();
+    size_t       best               = m_configured;
+    double       bestCost           = m_candidates[best].IsMeasured() ? m_candidates[best].GetCost(linkSecondsPerByte) : 0;
+    for (size_t i = 0; i < m_candidates.size(); ++i) {
+        if (!m_candidates[i].IsMeasured())
+            continue;
+        const double cost = m_candidates[i].GetCost(linkSecondsPerByte);
+        if (!m_candidates[best].IsMeasured() || cost < bestCost) {
+            best     = i;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+double CompressionTuner::GetLinkSecondsPerByte() const
+{
+    if (m_linkBytes <= 0)
+        return 0;
+    return std::max(m_linkSeconds - m_linkTransfers * m_roundTrip, 0.) / m_linkBytes;
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+
+#include <FileUtils.h>
+#include <TimePoint.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Wuild {
+/**
+ * Chooses compression of task input from measured link and local compression speed.
+ *
+ * Candidates are no compression, several zstd levels and configured compression. For each one, compression speed and ratio
+ * are measured on real inputs (AddCompression). Link is modeled as round trip plus bytes / bandwidth,
+ * measured on transfers to all servers (AddTransfer), since server is not known when input is compressed.
+ * Choose returns candidate with least time to compress and send one byte of input; every
+ * s_exploreInterval-th task uses other candidate, so estimates follow changes of link and CPU load.
+ */
+class CompressionTuner {
+public:
+    static const uint64_t s_exploreInterval = 16;
+
+public:
+    /// Configured compression is used until link is measured.
+    explicit CompressionTuner(const CompressionInfo& configured);
+
+    CompressionInfo Choose();
+
+    void AddCompression(const CompressionInfo& compression, size_t inputSize, size_t outputSize, const TimePoint& elapsed);
+    void AddTransfer(size_t bytes, const TimePoint& transferTime);
+
+    /// Decision, link estimate and effective input throughput, for session statistics.
+    std::string GetSummary() const;
+
+protected:
+    struct Candidate {
+        CompressionInfo m_compression;
+        double          m_inputBytes  = 0; //!< Moving sums of measured compressions
+        double          m_outputBytes = 0;
+        double          m_seconds     = 0;
+        uint64_t        m_chosen      = 0;
+
+        bool   IsMeasured() const { return m_seconds > 0; }
+        double GetCost(double linkSecondsPerByte) const;
+    };
+
+    size_t FindBest() const;
+    double GetLinkSecondsPerByte() const; //!< Without round trip; 0 = size does not matter or not measured
+
+    mutable std::mutex     m_mutex;
+    std::vector<Candidate> m_candidates;
+    size_t                 m_configured   = 0;
+    uint64_t               m_tasks        = 0;
+    size_t                 m_exploreIndex = 0;
+
+    double m_linkBytes     = 0; //!< Moving sums of measured transfers
+    double m_linkSeconds   = 0;
+    double m_linkTransfers = 0;
+    double m_roundTrip     = 0; //!< Least transfer time seen, in seconds
+};
+
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "InputStore.h"
+
+namespace Wuild {
+
+InputStore::InputStore(int64_t maxSize)
+    : m_maxSize(maxSize)
+{
+}
+
+bool InputStore::Has(const std::string& hash) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.count(hash) > 0;
+}
+
+bool InputStore::Get(const std::string& hash, ByteArrayHolder& data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto                        it = m_entries.find(hash);
+    if (it == m_entries.end())
+        return false;
+    m_recent.splice(m_recent.begin(), m_recent, it->second.m_recent);
+    data = it->second.m_data;
+    return true;
+}
+
+void InputStore::Put(const std::string& hash, const ByteArrayHolder& data)
+{
+    if (int64_t(data.size()) > m_maxSize)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_entries.count(hash))
+        return;
+    m_recent.push_front(hash);
+    m_entries[hash] = Entry{ data, m_recent.begin() };
+    m_size += data.size();
+    while (m_size > m_maxSize) {
+        auto it = m_entries.find(m_recent.back());
+        m_size -= it->second.m_data.size();
+        m_entries.erase(it);
+        m_recent.pop_back();
+    }
+}
+
+}
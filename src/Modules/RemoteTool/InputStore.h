@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+
+#include <CommonTypes.h>
+
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace Wuild {
+/// Recently recieved tool inputs in memory, by SHA-256 of compressed data, bounded by total size.
+///
+/// Lets client send only hash of input which server already got from it or other client.
+class InputStore {
+public:
+    /// maxSize is in bytes; 0 = store is disabled.
+    explicit InputStore(int64_t maxSize);
+
+    bool IsEnabled() const { return m_maxSize > 0; }
+
+    bool Has(const std::string& hash) const;
+    bool Get(const std::string& hash, ByteArrayHolder& data);
+    void Put(const std::string& hash, const ByteArrayHolder& data);
+
+private:
+    struct Entry {
+        ByteArrayHolder                  m_data;
+        std::list<std::string>::iterator m_recent;
+    };
+
+    const int64_t                m_maxSize;
+    mutable std::mutex           m_mutex;
+    std::map<std::string, Entry> m_entries;
+    std::list<std::string>       m_recent; //!< Hashes, most recently used first
+    int64_t                      m_size = 0;
+};
+
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "LocalExecutionModel.h"
+
+#include <algorithm>
+
+namespace Wuild {
+
+namespace {
+void AddSample(int64_t& average, int64_t samples, int64_t value)
+{
+    average = samples ? (average * 7 + value) / 8 : value;
+}
+}
+
+void LocalExecutionModel::AddRemoteExecution(int64_t executionUS, int64_t overheadPercent)
+{
+    AddSample(m_avgRemoteExecutionUS, m_remoteSamples, executionUS);
+    AddSample(m_avgRemoteOverheadPerc, m_remoteSamples, overheadPercent);
+    m_remoteSamples++;
+}
+
+void LocalExecutionModel::AddLocalExecution(int64_t executionUS, bool withPreprocessing)
+{
+    if (withPreprocessing) {
+        if (!m_preprocessSamples)
+            return; // compilation part is not known yet.
+        executionUS = std::max<int64_t>(executionUS - m_avgPreprocessUS, 0);
+    }
+    AddSample(m_avgLocalExecutionUS, m_localSamples, executionUS);
+    m_localSamples++;
+}
+
+void LocalExecutionModel::AddPreprocessing(int64_t executionUS)
+{
+    AddSample(m_avgPreprocessUS, m_preprocessSamples, executionUS);
+    m_preprocessSamples++;
+}
+
+bool LocalExecutionModel::PreferLocal(bool remoteAvailable) const
+{
+    // nothing to compare yet: idle local core is better than waiting for busy remote.
+    if (m_remoteSamples < s_minimalRemoteSamples)
+        return !remoteAvailable;
+
+    const int64_t expectedRemoteUS = m_avgRemoteExecutionUS * (100 + m_avgRemoteOverheadPerc) / 100;
+    const int64_t expectedLocalUS  = m_localSamples ? m_avgLocalExecutionUS : m_avgRemoteExecutionUS;
+    return expectedLocalUS < expectedRemoteUS;
+}
+
+}
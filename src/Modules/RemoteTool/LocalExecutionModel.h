@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace Wuild {
+/**
+ * Decides whether remote-capable task should run on idle local core, from measured execution times.
+ *
+ * Remote task takes compilation time plus network overhead; local one takes just compilation.
+ * Until local time is measured, local cores are assumed to be as fast as remote ones.
+ * Until remote time is measured, task goes remote only if remote has free threads for it.
+ * Local run of task with fused preprocessing includes preprocessor, which is subtracted to compare compilation only.
+ * Not thread safe, owner guards it.
+ */
+class LocalExecutionModel {
+public:
+    static const int64_t s_minimalRemoteSamples = 3;
+
+public:
+    void AddRemoteExecution(int64_t executionUS, int64_t overheadPercent);
+    void AddLocalExecution(int64_t executionUS, bool withPreprocessing = false);
+    /// Local preprocessing of task sent to remote.
+    void AddPreprocessing(int64_t executionUS);
+
+    /// True if task is expected to finish sooner on idle local core.
+    bool PreferLocal(bool remoteAvailable) const;
+
+protected:
+    // Moving averages, 1/8 weight for new sample.
+    int64_t m_remoteSamples         = 0;
+    int64_t m_avgRemoteExecutionUS  = 0;
+    int64_t m_avgRemoteOverheadPerc = 0;
+    int64_t m_localSamples          = 0;
+    int64_t m_avgLocalExecutionUS   = 0;
+    int64_t m_preprocessSamples     = 0;
+    int64_t m_avgPreprocessUS       = 0;
+};
+
+}
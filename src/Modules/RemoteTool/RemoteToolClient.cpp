@@ -13,12 +13,19 @@
 
 #include "RemoteToolClient.h"
 
+#include "ChunkedInput.h"
+#include "CompressionTuner.h"
 #include "RemoteToolFrames.h"
 #include "ToolBalancer.h"
 
+#include <ChunkedCompression.h>
+#include <CompressionDictionary.h>
 #include <CoordinatorClient.h>
+#include <ResultCache.h>
+#include <Sha256.h>
 #include <SocketFrameService.h>
 #include <ThreadUtils.h>
+#include <ThreadPool.h>
 #include <FileUtils.h>
 
 #include <cstdio>
@@ -27,22 +34,37 @@
 #include <functional>
 #include <fstream>
 #include <algorithm>
+#include <set>
 #include <utility>
 
 namespace Wuild {
 static const size_t g_recommendedBufferSize = 64 * 1024;
+// dictionary training input: zstd recommends about 100 times of dictionary size in total.
+static const size_t g_dictionaryMaxSize       = 112 * 1024;
+static const size_t g_dictionarySamples       = 100;
+static const size_t g_dictionarySampleMaxSize = 512 * 1024;
+static const size_t g_dictionaryTrainingSize  = 16 * 1024 * 1024;
+// hashes of chunks sent to one server; above it, chunks are sent again.
+static const size_t g_maxSentChunks = 1024 * 1024;
 
 class RemoteToolRequestWrap {
 public:
     TimePoint                        m_start;
+    TimePoint                        m_dispatched;
     int64_t                          m_taskIndex = 0;
     ToolCommandline                  m_invocation;
     std::string                      m_originalFilename;
+    std::string                      m_cacheKey;      //!< Key in local cache; empty = not cached
+    std::string                      m_deferredInput; //!< Input file which is read when task is sent; empty = input is in request
+    size_t                           m_deferredSize = 0;
     RemoteToolRequest::Ptr           m_toolRequest;
+    ChunkedInput::Ptr                m_chunkedInput; //!< Not null if input is sent by chunks; request is made for each server
     RemoteToolClient::InvokeCallback m_callback;
     TimePoint                        m_expirationMoment;
     TimePoint                        m_requestTimeout;
     int                              m_attemptsRemain = 1;
+    bool                             m_probed         = false; //!< Servers were asked whether they have input
+    bool                             m_uploadFull     = false; //!< Server reported input is missing, don't send by hash or skip chunks
 };
 
 class RemoteToolClientImpl {
@@ -51,23 +73,481 @@ public:
     ToolBalancer                        m_balancer;
     std::mutex                          m_clientsMutex;
     std::deque<SocketFrameHandler::Ptr> m_clients;
+    std::map<size_t, std::mutex>        m_sendMutexes; //!< Client index -> held while requests are built and queued
     std::mutex                          m_requestsMutex;
     std::deque<RemoteToolRequestWrap>   m_requests;
+    size_t                              m_queuedInputBytes = 0; //!< Input data held by m_requests
+    size_t                              m_queuedInputPeak  = 0;
     std::unique_ptr<SocketFrameService> m_server;
     CoordinatorClient                   m_coordinator;
     size_t                              m_clientIndex = 0;
     std::atomic_int                     m_pendingTasks{ 0 };
+    std::mutex                          m_inFlightMutex;
+    std::map<int64_t, size_t>           m_inFlightTasks; //!< task index -> client index
+    std::atomic_bool                    m_cancelled{ false };
+    std::unique_ptr<ThreadPool>         m_outputPool; //!< Decompresses and writes results
+    std::unique_ptr<ResultCache>        m_localCache; //!< Object files by local cache key
+    std::unique_ptr<CompressionTuner>   m_compressionTuner; //!< Null if compression is not adaptive
 
-    void QueueTask(const RemoteToolRequestWrap& task)
+    std::mutex                              m_inputOwnersMutex;
+    std::map<std::string, std::set<size_t>> m_inputOwners; //!< Input hash -> clients which reported having it
+
+    std::mutex                   m_dictionaryMutex;
+    CompressionDictionary::Ptr   m_dictionary;         //!< Used for inputs once it is sent to all servers
+    std::set<size_t>             m_dictionaryRejected; //!< Clients which can't use dictionary
+    std::vector<ByteArrayHolder> m_dictionarySamples;  //!< Inputs collected for training
+    size_t                       m_dictionarySamplesSize = 0;
+    bool                         m_dictionaryTraining    = false;
+    std::unique_ptr<ThreadPool>  m_trainingPool; //!< Single worker, so training does not hold output workers
+
+    std::mutex                              m_sentChunksMutex;
+    std::map<size_t, std::set<std::string>> m_sentChunks; //!< Client index -> hashes of chunks sent to it
+
+    void SendCancel(size_t clientIndex, int64_t taskIndex)
+    {
+        SocketFrameHandler::Ptr handler;
+        {
+            std::lock_guard<std::mutex> lock(m_clientsMutex);
+            handler = m_clients[clientIndex];
+        }
+        RemoteToolCancel::Ptr cancelFrame(new RemoteToolCancel());
+        cancelFrame->m_sessionId = m_parent->m_sessionId;
+        cancelFrame->m_taskId    = taskIndex;
+        handler->QueueFrame(cancelFrame);
+    }
+
+    void CancelTasks()
+    {
+        m_cancelled = true;
+        {
+            std::lock_guard<std::mutex> lock(m_requestsMutex);
+            m_pendingTasks -= static_cast<int>(m_requests.size());
+            m_requests.clear();
+            m_queuedInputBytes = 0;
+        }
+        std::map<int64_t, size_t> inFlightTasks;
+        {
+            std::lock_guard<std::mutex> lock(m_inFlightMutex);
+            inFlightTasks.swap(m_inFlightTasks);
+        }
+        if (!inFlightTasks.empty())
+            Syslogger(Syslogger::Notice) << "Cancelling " << inFlightTasks.size() << " remote tasks.";
+        for (const auto& inFlight : inFlightTasks)
+            SendCancel(inFlight.second, inFlight.first);
+    }
+
+    void QueueTask(const RemoteToolRequestWrap& task, bool front = false)
     {
         std::lock_guard<std::mutex> lock(m_requestsMutex);
-        m_requests.push_back(task);
+        if (front)
+            m_requests.push_front(task);
+        else
+            m_requests.push_back(task);
         m_pendingTasks++;
+        m_queuedInputBytes += GetInputSize(task);
+        m_queuedInputPeak = std::max(m_queuedInputPeak, m_queuedInputBytes);
+    }
+
+    /// Input data held in memory by task.
+    static size_t GetInputSize(const RemoteToolRequestWrap& task)
+    {
+        return task.m_chunkedInput ? task.m_chunkedInput->GetData().size() : task.m_toolRequest->m_fileData.size();
+    }
+
+    bool IsOverInputLimit()
+    {
+        const size_t                limit = size_t(m_parent->m_config.m_queuedInputLimitMB) * 1024 * 1024;
+        std::lock_guard<std::mutex> lock(m_requestsMutex);
+        return limit && m_queuedInputBytes >= limit;
+    }
+
+    /// Asks all servers which of inputs they have; answers arrive while tasks wait in queue.
+    void SendProbe(const StringVector& hashes)
+    {
+        std::vector<SocketFrameHandler::Ptr> clients;
+        {
+            std::lock_guard<std::mutex> lock(m_clientsMutex);
+            clients.assign(m_clients.cbegin(), m_clients.cend());
+        }
+        for (size_t clientIndex = 0; clientIndex < clients.size(); ++clientIndex) {
+            RemoteToolInputProbe::Ptr probe(new RemoteToolInputProbe());
+            probe->m_hashes    = hashes;
+            auto frameCallback = [this, clientIndex](SocketFrame::Ptr responseFrame, SocketFrameHandler::ReplyState state, const std::string&) {
+                RemoteToolInputProbeResponse::Ptr result = std::dynamic_pointer_cast<RemoteToolInputProbeResponse>(responseFrame);
+                if (state != SocketFrameHandler::ReplyState::Success || !result)
+                    return;
+                std::lock_guard<std::mutex> lock(m_inputOwnersMutex);
+                for (const auto& hash : result->m_available)
+                    m_inputOwners[hash].insert(clientIndex);
+            };
+            clients[clientIndex]->QueueFrame(probe, frameCallback, m_parent->m_config.m_queueTimeout);
+        }
+    }
+
+    /// Sends dictionary to one server; frame goes ahead of requests which use it.
+    void SendDictionary(SocketFrameHandler& handler, size_t clientIndex, const CompressionDictionary::Ptr& dictionary)
+    {
+        RemoteToolDictionary::Ptr frame(new RemoteToolDictionary());
+        frame->m_id        = dictionary->GetId();
+        frame->m_data      = dictionary->GetData();
+        auto frameCallback = [this, clientIndex](SocketFrame::Ptr responseFrame, SocketFrameHandler::ReplyState state, const std::string&) {
+            RemoteToolDictionaryResponse::Ptr result = std::dynamic_pointer_cast<RemoteToolDictionaryResponse>(responseFrame);
+            if (state != SocketFrameHandler::ReplyState::Success || !result || result->m_accepted)
+                return;
+            Syslogger(Syslogger::Warning) << "Tool server " << clientIndex << " does not support compression dictionary.";
+            std::lock_guard<std::mutex> lock(m_dictionaryMutex);
+            m_dictionaryRejected.insert(clientIndex);
+        };
+        handler.QueueFrame(frame, frameCallback, m_parent->m_config.m_requestTimeout);
+    }
+
+    /// Called when server is connected, before it gets any task.
+    void OnClientConnected(SocketFrameHandler& handler, size_t clientIndex)
+    {
+        {
+            // server could be restarted, so it has no chunks.
+            std::lock_guard<std::mutex> lock(m_sentChunksMutex);
+            m_sentChunks.erase(clientIndex);
+        }
+        std::lock_guard<std::mutex> lock(m_dictionaryMutex);
+        if (m_dictionary)
+            SendDictionary(handler, clientIndex, m_dictionary);
+    }
+
+    /// Sends dictionary to connected servers; new connections get it in OnClientConnected.
+    void PublishDictionary(const CompressionDictionary::Ptr& dictionary)
+    {
+        std::lock_guard<std::mutex>          lock(m_dictionaryMutex);
+        std::vector<SocketFrameHandler::Ptr> clients;
+        {
+            std::lock_guard<std::mutex> lock2(m_clientsMutex);
+            clients.assign(m_clients.cbegin(), m_clients.cend());
+        }
+        for (size_t clientIndex = 0; clientIndex < clients.size(); ++clientIndex)
+            SendDictionary(*clients[clientIndex], clientIndex, dictionary);
+        m_dictionary = dictionary;
+        m_dictionarySamples.clear();
+        Syslogger(Syslogger::Notice) << "Using compression dictionary " << dictionary->GetId().substr(0, 8) << ", " << dictionary->GetData().size() << " bytes.";
+    }
+
+    void LoadDictionary()
+    {
+        const std::string& path = m_parent->m_config.m_compressionDictionary;
+        if (path.empty() || !CompressionDictionary::IsSupported())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_dictionaryMutex);
+            if (m_dictionary)
+                return;
+        }
+        ByteArrayHolder data;
+        if (!FileInfo(path).Exists() || !FileInfo(path).ReadFile(data))
+            return;
+        if (auto dictionary = CompressionDictionary::Create(data))
+            PublishDictionary(dictionary);
+        else
+            Syslogger(Syslogger::Warning) << "Invalid compression dictionary " << path << ", it will be trained again.";
+    }
+
+    /// Collects training samples; when there are enough, dictionary is trained in background.
+    void AddDictionarySample(const ByteArrayHolder& input)
+    {
+        std::vector<ByteArrayHolder> samples;
+        {
+            std::lock_guard<std::mutex> lock(m_dictionaryMutex);
+            if (m_dictionary || m_dictionaryTraining)
+                return;
+            const size_t size = std::min(input.size(), g_dictionarySampleMaxSize);
+            m_dictionarySamples.push_back(ByteArrayHolder(ByteArray(input.ref().cbegin(), input.ref().cbegin() + size)));
+            m_dictionarySamplesSize += size;
+            if (m_dictionarySamples.size() < g_dictionarySamples && m_dictionarySamplesSize < g_dictionaryTrainingSize)
+                return;
+            m_dictionaryTraining = true;
+            samples.swap(m_dictionarySamples);
+            m_dictionarySamplesSize = 0;
+            m_trainingPool          = std::make_unique<ThreadPool>(1);
+        }
+        // training takes seconds; results of running tasks are still written meanwhile.
+        m_trainingPool->Enqueue([this, samples] {
+            const TimePoint start(true);
+            auto            dictionary = CompressionDictionary::Train(samples, g_dictionaryMaxSize);
+            if (!dictionary)
+                return; // samples are not collected again, build continues without dictionary.
+            Syslogger(Syslogger::Info) << "Compression dictionary trained on " << samples.size() << " inputs in " << start.GetElapsedTime().ToProfilingTime();
+            const std::string& path = m_parent->m_config.m_compressionDictionary;
+            if (!FileInfo(path).WriteFile(dictionary->GetData()))
+                Syslogger(Syslogger::Warning) << "Failed to save compression dictionary to " << path;
+            PublishDictionary(dictionary);
+        });
+    }
+
+    struct TaskInput {
+        ByteArrayHolder   m_data;
+        CompressionInfo   m_compression;
+        std::string       m_dictionaryId;
+        ChunkedInput::Ptr m_chunks; //!< Input is compressed when request is sent, m_data is empty
+    };
+
+    /// Reads and compresses task input; until dictionary is ready, input is kept as training sample.
+    bool ReadInput(const std::string& filename, TaskInput& input)
+    {
+        CompressionDictionary::Ptr dictionary;
+        bool                       sample = false;
+        ChooseCompression(input, dictionary, sample);
+
+        const TimePoint start(true);
+        if (!m_parent->m_config.m_uploadChunks && !dictionary && !sample && input.m_compression.m_type != Mernel::CompressionType::None)
+            return ReadInputMapped(filename, input, start);
+
+        ByteArrayHolder uncompressedData;
+        if (!FileInfo(filename).ReadFile(uncompressedData))
+            return false;
+        return CompressInput(uncompressedData, input, dictionary, sample, start, filename);
+    }
+
+    /// Same as ReadInput, for input which is already in memory (e.g. preprocessor output).
+    bool PrepareInput(const ByteArrayHolder& uncompressedData, TaskInput& input)
+    {
+        CompressionDictionary::Ptr dictionary;
+        bool                       sample = false;
+        ChooseCompression(input, dictionary, sample);
+        return CompressInput(uncompressedData, input, dictionary, sample, TimePoint(true), "input in memory");
+    }
+
+    void ChooseCompression(TaskInput& input, CompressionDictionary::Ptr& dictionary, bool& sample)
+    {
+        const auto& config = m_parent->m_config;
+        if (config.m_uploadChunks) {
+            input.m_compression = config.m_compression;
+            return;
+        }
+        input.m_compression = m_compressionTuner ? m_compressionTuner->Choose() : config.m_compression;
+        if (!config.m_compressionDictionary.empty() && input.m_compression.m_type == Mernel::CompressionType::ZStd && CompressionDictionary::IsSupported()) {
+            std::lock_guard<std::mutex> lock(m_dictionaryMutex);
+            dictionary = m_dictionary;
+            sample     = !dictionary && !m_dictionaryTraining;
+        }
+    }
+
+    bool CompressInput(const ByteArrayHolder& uncompressedData, TaskInput& input, const CompressionDictionary::Ptr& dictionary, bool sample, const TimePoint& start, const std::string& name)
+    {
+        if (m_parent->m_config.m_uploadChunks) {
+            input.m_chunks = ChunkedInput::Split(uncompressedData);
+            return true;
+        }
+        try {
+            if (dictionary) {
+                dictionary->Compress(uncompressedData, input.m_data, input.m_compression.m_level);
+                input.m_dictionaryId = dictionary->GetId();
+            } else if (input.m_compression.m_type == Mernel::CompressionType::None) {
+                input.m_data = uncompressedData;
+            } else {
+                ChunkedCompression::Compress(uncompressedData, input.m_data, input.m_compression);
+            }
+        }
+        catch (std::exception& e) {
+            Syslogger(Syslogger::Err) << "Error on compress:" << e.what() << " for " << name;
+            return false;
+        }
+        if (m_compressionTuner)
+            m_compressionTuner->AddCompression(input.m_compression, uncompressedData.size(), input.m_data.size(), start.GetElapsedTime());
+        if (sample)
+            AddDictionarySample(uncompressedData);
+        return true;
+    }
+
+    /// Compresses input straight from mapped file, so uncompressed input is never copied whole to memory.
+    bool ReadInputMapped(const std::string& filename, TaskInput& input, const TimePoint& start)
+    {
+        ChunkedCompression::Compressor compressor(input.m_compression);
+        size_t                         uncompressedSize = 0;
+        try {
+            const bool read = FileInfo(filename).ReadMapped([&](const uint8_t* data, size_t size) {
+                compressor.Add(data, size);
+                uncompressedSize = size;
+            });
+            if (!read)
+                return false;
+            compressor.Finish(input.m_data);
+        }
+        catch (std::exception& e) {
+            Syslogger(Syslogger::Err) << "Error on reading:" << e.what() << " for " << filename;
+            return false;
+        }
+        if (m_compressionTuner)
+            m_compressionTuner->AddCompression(input.m_compression, uncompressedSize, input.m_data.size(), start.GetElapsedTime());
+        return true;
+    }
+
+    /// Hash of input for local cache, taken from mapped file without reading it into memory.
+    bool HashInputFile(const std::string& filename, std::string& inputId)
+    {
+        Sha256 hash;
+        if (!FileInfo(filename).ReadMapped([&hash](const uint8_t* data, size_t size) { hash.Update(data, size); }))
+            return false;
+        inputId = hash.GetHexDigest();
+        return true;
+    }
+
+    /// Puts read input into request of task.
+    void SetRequestInput(RemoteToolRequestWrap& task, const TaskInput& input)
+    {
+        const auto& config       = m_parent->m_config;
+        const bool  uploadByHash = config.m_uploadByHashMinKB > 0 && input.m_data.size() >= size_t(config.m_uploadByHashMinKB) * 1024;
+        auto&       request      = *task.m_toolRequest;
+        request.m_fileData       = input.m_data;
+        request.m_inputHash      = uploadByHash ? Sha256::Hash(input.m_data) : std::string();
+        request.m_dictionaryId   = input.m_dictionaryId;
+        request.m_chunkHashes    = input.m_chunks ? input.m_chunks->GetHashes() : StringVector();
+        request.m_compression    = input.m_compression;
+        task.m_chunkedInput      = input.m_chunks;
+    }
+
+    /// Reads input of task which was queued over queued input limit.
+    bool LoadDeferredInput(RemoteToolRequestWrap& task)
+    {
+        const TimePoint start(true);
+        TaskInput       input;
+        if (!ReadInput(task.m_deferredInput, input))
+            return false;
+        SetRequestInput(task, input);
+        task.m_deferredInput.clear();
+        m_parent->m_deferredInputs++;
+        std::lock_guard<std::mutex> lock(m_parent->m_sessionInfoMutex);
+        m_parent->m_totalCompressionTime += start.GetElapsedTime();
+        return true;
+    }
+
+    /// Copy of request without input data.
+    static RemoteToolRequest::Ptr CopyRequestHeader(const RemoteToolRequest& request)
+    {
+        RemoteToolRequest::Ptr copy(new RemoteToolRequest());
+        copy->m_clientId    = request.m_clientId;
+        copy->m_sessionId   = request.m_sessionId;
+        copy->m_taskId      = request.m_taskId;
+        copy->m_invocation  = request.m_invocation;
+        copy->m_compression = request.m_compression;
+        return copy;
+    }
+
+    /// Copy of request with input data, which is shared, not copied.
+    static RemoteToolRequest::Ptr CopyRequest(const RemoteToolRequest& request)
+    {
+        RemoteToolRequest::Ptr copy = CopyRequestHeader(request);
+        copy->m_fileData            = request.m_fileData;
+        copy->m_inputHash           = request.m_inputHash;
+        copy->m_dictionaryId        = request.m_dictionaryId;
+        copy->m_chunkHashes         = request.m_chunkHashes;
+        copy->m_chunkSizes          = request.m_chunkSizes;
+        return copy;
+    }
+
+    /// Recompresses input without dictionary, for server which does not have it.
+    RemoteToolRequest::Ptr WithoutDictionary(const RemoteToolRequest::Ptr& request)
+    {
+        CompressionDictionary::Ptr dictionary;
+        {
+            std::lock_guard<std::mutex> lock(m_dictionaryMutex);
+            dictionary = m_dictionary;
+        }
+        if (request->m_dictionaryId.empty() || !dictionary || dictionary->GetId() != request->m_dictionaryId)
+            return request;
+
+        RemoteToolRequest::Ptr plain = CopyRequestHeader(*request);
+        try {
+            ByteArrayHolder uncompressedData;
+            dictionary->Uncompress(request->m_fileData, uncompressedData);
+            ChunkedCompression::Compress(uncompressedData, plain->m_fileData, plain->m_compression);
+        }
+        catch (std::exception& e) {
+            Syslogger(Syslogger::Err) << "Error on recompress:" << e.what();
+            return request;
+        }
+        if (!request->m_inputHash.empty())
+            plain->m_inputHash = Sha256::Hash(plain->m_fileData);
+        return plain;
+    }
+
+    /// Request with chunks which were not sent to server yet; with all of them, if server reported missing one.
+    /// Chunks put in request are added to frameChunks; they are recorded as sent when frame is queued.
+    RemoteToolRequest::Ptr GetChunkedRequest(const RemoteToolRequestWrap& task, size_t clientIndex, std::set<std::string>& frameChunks)
+    {
+        const auto&            chunks  = task.m_chunkedInput->GetChunks();
+        const ByteArray&       data    = task.m_chunkedInput->GetData().ref();
+        RemoteToolRequest::Ptr request = CopyRequestHeader(*task.m_toolRequest);
+        request->m_chunkHashes         = task.m_toolRequest->m_chunkHashes;
+        request->m_chunkSizes.resize(chunks.size());
+        ByteArray             missing;
+        std::set<std::string> requestChunks; // server stores chunk when it is read, so repeated one is sent once.
+        {
+            std::lock_guard<std::mutex> lock(m_sentChunksMutex);
+            const auto&                 sent = m_sentChunks[clientIndex];
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                const auto& hash = chunks[i].m_hash;
+                const bool  skip = sent.count(hash) || frameChunks.count(hash) || !requestChunks.insert(hash).second;
+                if (skip && !task.m_uploadFull)
+                    continue;
+                request->m_chunkSizes[i] = static_cast<uint32_t>(chunks[i].m_size);
+                missing.insert(missing.end(), data.cbegin() + chunks[i].m_offset, data.cbegin() + chunks[i].m_offset + chunks[i].m_size);
+            }
+        }
+        m_parent->m_chunksSkippedBytes += data.size() - missing.size();
+
+        const TimePoint start(true);
+        try {
+            if (request->m_compression.m_type == Mernel::CompressionType::None)
+                request->m_fileData = ByteArrayHolder(std::move(missing));
+            else if (!missing.empty())
+                ChunkedCompression::Compress(ByteArrayHolder(std::move(missing)), request->m_fileData, request->m_compression);
+            frameChunks.insert(requestChunks.cbegin(), requestChunks.cend());
+        }
+        catch (std::exception& e) {
+            // server will report invalid input; chunks are not recorded as sent.
+            Syslogger(Syslogger::Err) << "Error on compress:" << e.what() << " for " << task.m_originalFilename;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_parent->m_sessionInfoMutex);
+            m_parent->m_totalCompressionTime += start.GetElapsedTime();
+        }
+        m_parent->m_sentBytes += request->m_fileData.size();
+        return request;
+    }
+
+    /// Request without input data, if chosen server has it.
+    RemoteToolRequest::Ptr GetRequestToSend(const RemoteToolRequestWrap& task, size_t clientIndex, std::set<std::string>& frameChunks)
+    {
+        if (task.m_chunkedInput)
+            return GetChunkedRequest(task, clientIndex, frameChunks);
+
+        auto request = task.m_toolRequest;
+        if (!request->m_dictionaryId.empty()) {
+            std::unique_lock<std::mutex> lock(m_dictionaryMutex);
+            const bool                   rejected = m_dictionaryRejected.count(clientIndex) > 0;
+            lock.unlock();
+            if (rejected)
+                request = WithoutDictionary(request);
+        }
+        bool available = false;
+        if (!request->m_inputHash.empty() && !task.m_uploadFull) {
+            std::lock_guard<std::mutex> lock(m_inputOwnersMutex);
+            auto                        it = m_inputOwners.find(request->m_inputHash);
+            available                      = it != m_inputOwners.end() && it->second.count(clientIndex) > 0;
+        }
+        if (!available) {
+            m_parent->m_sentBytes += request->m_fileData.size();
+            return request;
+        }
+        m_parent->m_uploadSavedBytes += request->m_fileData.size();
+        RemoteToolRequest::Ptr requestByHash = CopyRequestHeader(*request);
+        requestByHash->m_inputHash           = request->m_inputHash;
+        requestByHash->m_dictionaryId        = request->m_dictionaryId;
+        return requestByHash;
     }
 
     bool ProcessTasks()
     {
         RemoteToolRequestWrap task;
+        StringVector          probeHashes;
         {
             std::lock_guard<std::mutex> lock(m_requestsMutex);
             if (m_requests.empty())
@@ -82,6 +562,7 @@ public:
                         info.m_stdOutput = "Timeout expired.";
                         it->m_callback(info);
                     }
+                    m_queuedInputBytes -= GetInputSize(*it);
                     it = m_requests.erase(it);
                 } else {
                     it++;
@@ -91,70 +572,304 @@ public:
             if (m_requests.empty())
                 return true;
 
+            for (auto& request : m_requests) {
+                if (!request.m_probed && !request.m_toolRequest->m_inputHash.empty()) {
+                    request.m_probed = true;
+                    probeHashes.push_back(request.m_toolRequest->m_inputHash);
+                }
+            }
             task = *m_requests.begin();
         }
+        if (!probeHashes.empty())
+            SendProbe(probeHashes);
 
         size_t clientIndex = m_balancer.FindFreeClient(task.m_invocation.m_id.m_toolId);
         if (clientIndex == std::numeric_limits<size_t>::max())
             return true;
 
+        std::vector<RemoteToolRequestWrap> batch;
+        {
+            std::lock_guard<std::mutex> lock(m_requestsMutex);
+            if (m_requests.empty() || m_requests.front().m_taskIndex != task.m_taskIndex)
+                return false; // tasks were cancelled meanwhile.
+            m_requests.pop_front();
+            batch.push_back(task);
+            const size_t batchSize = GetBatchSize(task, clientIndex);
+            for (auto it = m_requests.begin(); it != m_requests.end() && batch.size() < batchSize;) {
+                if (IsSmallTask(*it) && it->m_invocation.m_id.m_toolId == task.m_invocation.m_id.m_toolId) {
+                    batch.push_back(*it);
+                    it = m_requests.erase(it);
+                } else {
+                    it++;
+                }
+            }
+            for (const auto& item : batch)
+                m_queuedInputBytes -= GetInputSize(item);
+        }
+
+        // server slots are taken now, so it does not get more tasks while deferred inputs are read.
+        for (size_t i = 0; i < batch.size(); ++i)
+            m_balancer.StartTask(clientIndex);
+        m_pendingTasks -= static_cast<int>(batch.size());
+        {
+            std::lock_guard<std::mutex> lock(m_inFlightMutex);
+            for (const auto& item : batch)
+                m_inFlightTasks[item.m_taskIndex] = clientIndex;
+        }
+
+        const bool deferred = std::any_of(batch.cbegin(), batch.cend(), [](const RemoteToolRequestWrap& item) { return !item.m_deferredInput.empty(); });
+        if (!deferred) {
+            SendBatch(batch, clientIndex);
+            return false;
+        }
+        // task over queued input limit is compressed just before it is sent; that is done on output pool,
+        // so other tasks are dispatched meanwhile.
+        m_outputPool->Enqueue([this, batch, clientIndex]() mutable {
+            LoadDeferredInputs(batch, clientIndex);
+            if (!batch.empty())
+                SendBatch(batch, clientIndex);
+        });
+        return false;
+    }
+
+    /// Reads inputs of batch which were deferred; task fails if its input file is gone meanwhile.
+    void LoadDeferredInputs(std::vector<RemoteToolRequestWrap>& batch, size_t clientIndex)
+    {
+        for (auto it = batch.begin(); it != batch.end();) {
+            if (!m_cancelled && (it->m_deferredInput.empty() || LoadDeferredInput(*it))) {
+                it++;
+                continue;
+            }
+            m_balancer.FinishTask(clientIndex);
+            {
+                std::lock_guard<std::mutex> lock(m_inFlightMutex);
+                m_inFlightTasks.erase(it->m_taskIndex);
+            }
+            if (!m_cancelled)
+                it->m_callback(RemoteToolClient::TaskExecutionInfo("failed to read " + it->m_deferredInput));
+            it = batch.erase(it);
+        }
+    }
+
+    /// Sends tasks which are already counted as started on server.
+    void SendBatch(std::vector<RemoteToolRequestWrap>& batch, size_t clientIndex)
+    {
         SocketFrameHandler::Ptr handler;
+        std::mutex*             sendMutex = nullptr;
         {
             std::lock_guard<std::mutex> lock2(m_clientsMutex);
-            handler = m_clients[clientIndex];
+            handler   = m_clients[clientIndex];
+            sendMutex = &m_sendMutexes[clientIndex];
         }
-        auto frameCallback = [this, task, clientIndex](SocketFrame::Ptr responseFrame, SocketFrameHandler::ReplyState state, const std::string& errorInfo) {
-            m_balancer.FinishTask(clientIndex);
-            const std::string outputFilename = task.m_originalFilename;
-            Syslogger(Syslogger::Info) << "RECIEVING [" << task.m_taskIndex << "]:" << outputFilename;
-            RemoteToolClient::TaskExecutionInfo info;
-            bool                                retry = false;
-            if (state == SocketFrameHandler::ReplyState::Timeout) {
-                info.m_stdOutput = "Timeout expired:" + outputFilename + ", start:" + task.m_start.ToString()
-                                   + " exp:" + task.m_expirationMoment.ToString() + ", remain:" + std::to_string(task.m_attemptsRemain)
-                                   + ", balancer.free:" + std::to_string(m_balancer.GetFreeThreads()) + ", extraInfo:" + errorInfo;
-                retry = true;
-            } else if (state == SocketFrameHandler::ReplyState::Error) {
-                info.m_stdOutput = "Internal error. " + errorInfo;
-                retry            = true;
-            } else {
+        // batches are sent from several threads; server reads requests in order, so chunk is recorded as sent
+        // only when frame with it is queued ahead of requests which skip it.
+        std::lock_guard<std::mutex> sendLock(*sendMutex);
+        std::set<std::string>       frameChunks;
+        const TimePoint             dispatched(true);
+        for (auto& item : batch)
+            item.m_dispatched = dispatched;
+
+        if (batch.size() == 1) {
+            auto request       = GetRequestToSend(batch[0], clientIndex, frameChunks);
+            auto frameCallback = [this, task = batch[0], clientIndex, sentBytes = request->m_fileData.size()](SocketFrame::Ptr responseFrame, SocketFrameHandler::ReplyState state, const std::string& errorInfo) {
                 RemoteToolResponse::Ptr result = std::dynamic_pointer_cast<RemoteToolResponse>(responseFrame);
-                info.m_toolExecutionTime       = result->m_executionTime;
-                info.m_networkRequestTime      = task.m_start.GetElapsedTime();
+                TimePoint               transferTime;
+                if (result) {
+                    transferTime = task.m_dispatched.GetElapsedTime() - result->m_executionTime - result->m_queueTime;
+                    if (m_compressionTuner)
+                        m_compressionTuner->AddTransfer(sentBytes + result->m_fileData.size(), transferTime);
+                }
+                FinishTask(task, clientIndex, result, state, errorInfo, transferTime);
+            };
+            handler->QueueFrame(request, frameCallback, batch[0].m_requestTimeout);
+            AddSentChunks(clientIndex, frameChunks);
+            return;
+        }
 
-                info.m_result    = result->m_result;
-                info.m_stdOutput = result->m_stdOut;
-                std::replace(info.m_stdOutput.begin(), info.m_stdOutput.end(), '\r', ' ');
+        RemoteToolBatchRequest::Ptr batchRequest(new RemoteToolBatchRequest());
+        size_t                      sentBytes = 0;
+        for (const auto& item : batch) {
+            batchRequest->m_requests.push_back(GetRequestToSend(item, clientIndex, frameChunks));
+            sentBytes += batchRequest->m_requests.back()->m_fileData.size();
+        }
+        // reply comes when the slowest item is done; items may wait for each other and for tasks queued on server.
+        const size_t waves = m_balancer.GetExecutionWaves(clientIndex, batch.size());
+        Syslogger(Syslogger::Info) << "SENDING batch of " << batch.size() << " tasks, first [" << batch[0].m_taskIndex << "], waves: " << waves;
+        auto frameCallback = [this, batch, clientIndex, sentBytes](SocketFrame::Ptr responseFrame, SocketFrameHandler::ReplyState state, const std::string& errorInfo) {
+            RemoteToolBatchResponse::Ptr result = std::dynamic_pointer_cast<RemoteToolBatchResponse>(responseFrame);
+            std::string                  error  = errorInfo;
+            if (state == SocketFrameHandler::ReplyState::Success && (!result || result->m_responses.size() != batch.size())) {
+                state = SocketFrameHandler::ReplyState::Error;
+                error = "Invalid batch response.";
+                result.reset();
+            }
+            // reply is sent when the slowest task is done, so transfer time is measured against it.
+            TimePoint serverTime;
+            if (result) {
+                for (const auto& response : result->m_responses)
+                    serverTime = std::max(serverTime, response->m_executionTime + response->m_queueTime);
+            }
+            const TimePoint transferTime = batch[0].m_dispatched.GetElapsedTime() - serverTime;
+            if (result && m_compressionTuner) {
+                size_t recievedBytes = 0;
+                for (const auto& response : result->m_responses)
+                    recievedBytes += response->m_fileData.size();
+                m_compressionTuner->AddTransfer(sentBytes + recievedBytes, transferTime);
+            }
+            for (size_t i = 0; i < batch.size(); ++i)
+                FinishTask(batch[i], clientIndex, result ? result->m_responses[i] : nullptr, state, error, transferTime);
+        };
+        handler->QueueFrame(batchRequest, frameCallback, batch[0].m_requestTimeout * static_cast<int64_t>(waves));
+        AddSentChunks(clientIndex, frameChunks);
+    }
 
-                if (info.m_result && !outputFilename.empty()) {
-                    this->m_parent->m_recievedBytes += result->m_fileData.size();
+    void AddSentChunks(size_t clientIndex, const std::set<std::string>& frameChunks)
+    {
+        if (frameChunks.empty())
+            return;
+        std::lock_guard<std::mutex> lock(m_sentChunksMutex);
+        auto&                       sent = m_sentChunks[clientIndex];
+        if (sent.size() > g_maxSentChunks)
+            sent.clear();
+        sent.insert(frameChunks.cbegin(), frameChunks.cend());
+    }
 
-                    auto      pp = [this](ByteArray& data) { this->m_parent->m_config.m_postProcess.Apply(data); };
-                    TimePoint start(true);
-                    info.m_result = FileInfo(outputFilename).WriteCompressed(result->m_fileData, result->m_compression, true, pp);
-                    this->m_parent->m_totalCompressionTime += start.GetElapsedTime();
-                }
+    bool WriteOutput(const std::string& outputFilename, const RemoteToolResponse& result)
+    {
+        m_parent->m_recievedBytes += result.m_fileData.size();
+
+        FileInfo::PostProcessor pp;
+        if (!m_parent->m_config.m_postProcess.m_items.empty())
+            pp = [this](ByteArray& data) { m_parent->m_config.m_postProcess.Apply(data); };
+        TimePoint start(true);
+
+        // written in place, as compiler does itself; temp copy and rename are not needed for object file.
+        const bool written = FileInfo(outputFilename).WriteCompressed(result.m_fileData, result.m_compression, false, pp);
+        std::lock_guard<std::mutex> lock(m_parent->m_sessionInfoMutex);
+        m_parent->m_totalCompressionTime += start.GetElapsedTime();
+        return written;
+    }
+
+    bool IsSmallTask(const RemoteToolRequestWrap& task) const
+    {
+        // size of chunks to send is not known before server is chosen, so whole uncompressed input is compared;
+        // same for input which is not read yet.
+        const size_t inputSize = task.m_deferredInput.empty() ? GetInputSize(task) : task.m_deferredSize;
+        return inputSize < size_t(m_parent->m_config.m_batchInputLimitKB) * 1024;
+    }
+
+    /// How many tasks to send in one request; called under m_requestsMutex, after first task is taken from queue.
+    size_t GetBatchSize(const RemoteToolRequestWrap& task, size_t clientIndex) const
+    {
+        // tasks are dispatched as soon as they queued, so batches appear only when
+        // tasks come faster than they could be sent one by one.
+        const size_t maxBatch = static_cast<size_t>(m_parent->m_config.m_maxBatchTasks);
+        if (maxBatch <= 1 || m_requests.empty() || !IsSmallTask(task))
+            return 1;
+
+        // queue is split between servers by their free threads, so one big batch won't leave others idle.
+        // When all servers are busy, tasks wait in server queue anyway, so least loaded one gets full batch.
+        const size_t clientFree = m_balancer.GetFreeThreads(clientIndex);
+        const size_t totalFree  = m_balancer.GetFreeThreads();
+        const size_t queued     = m_requests.size() + 1;
+        const size_t share      = totalFree ? (queued * clientFree + totalFree - 1) / totalFree : queued;
+        return std::clamp<size_t>(share, 1, maxBatch);
+    }
+
+    void FinishTask(const RemoteToolRequestWrap& task, size_t clientIndex, const RemoteToolResponse::Ptr& result, SocketFrameHandler::ReplyState state, const std::string& errorInfo, const TimePoint& transferTime)
+    {
+        m_balancer.FinishTask(clientIndex);
+        {
+            std::lock_guard<std::mutex> lock(m_inFlightMutex);
+            m_inFlightTasks.erase(task.m_taskIndex);
+        }
+        if (m_cancelled)
+            return;
+
+        if (state == SocketFrameHandler::ReplyState::Success && result && result->m_inputRequired) {
+            Syslogger(Syslogger::Info) << "Input required [" << task.m_taskIndex << "]:" << task.m_originalFilename;
+            if (task.m_chunkedInput) {
+                // server dropped some chunks; which ones is not known.
+                std::lock_guard<std::mutex> lock(m_sentChunksMutex);
+                m_sentChunks.erase(clientIndex);
             }
-            m_parent->UpdateSessionInfo(info);
-            if (task.m_attemptsRemain > 0 && retry) {
-                Syslogger(Syslogger::Warning) << info.m_stdOutput << " Retrying (" << task.m_attemptsRemain << " attempts remain), args:" << task.m_invocation.GetArgsString();
+            if (!task.m_toolRequest->m_inputHash.empty()) {
+                // server evicted input; others which reported it are still asked by hash.
+                std::lock_guard<std::mutex> lock(m_inputOwnersMutex);
+                auto                        it = m_inputOwners.find(task.m_toolRequest->m_inputHash);
+                if (it != m_inputOwners.end() && it->second.erase(clientIndex) && it->second.empty())
+                    m_inputOwners.erase(it);
+            }
+            if (task.m_attemptsRemain > 0) {
+                // server may also miss dictionary, if it was restarted and client did not reconnect yet.
+                // Time in flight is not counted against queue timeout.
                 auto taskCopy = task;
                 taskCopy.m_attemptsRemain--;
-                taskCopy.m_taskIndex        = this->m_parent->m_taskIndex++;
-                taskCopy.m_expirationMoment = TimePoint(true) + m_parent->m_config.m_queueTimeout;
-                this->QueueTask(taskCopy);
-            } else {
-                task.m_callback(info);
+                taskCopy.m_uploadFull       = true;
+                taskCopy.m_toolRequest      = WithoutDictionary(task.m_toolRequest);
+                taskCopy.m_expirationMoment = task.m_expirationMoment + task.m_dispatched.GetElapsedTime();
+                QueueTask(taskCopy, true);
+                return;
             }
-        };
-        m_balancer.StartTask(clientIndex);
-        m_pendingTasks--;
-        handler->QueueFrame(task.m_toolRequest, frameCallback, task.m_requestTimeout);
-        {
-            std::lock_guard<std::mutex> lock(m_requestsMutex);
-            m_requests.pop_front();
+            RemoteToolClient::TaskExecutionInfo info;
+            info.m_stdOutput = "Tool server did not accept input: " + task.m_originalFilename;
+            m_parent->UpdateSessionInfo(info);
+            task.m_callback(info);
+            return;
+        }
+
+        const std::string outputFilename = task.m_originalFilename;
+        Syslogger(Syslogger::Info) << "RECIEVING [" << task.m_taskIndex << "]:" << outputFilename;
+        RemoteToolClient::TaskExecutionInfo info;
+        bool                                retry = false;
+        if (state == SocketFrameHandler::ReplyState::Timeout) {
+            info.m_stdOutput = "Timeout expired:" + outputFilename + ", start:" + task.m_start.ToString()
+                               + " exp:" + task.m_expirationMoment.ToString() + ", remain:" + std::to_string(task.m_attemptsRemain)
+                               + ", balancer.free:" + std::to_string(m_balancer.GetFreeThreads()) + ", extraInfo:" + errorInfo;
+            retry = true;
+            // server may still be executing it; free its slot before we retry elsewhere.
+            SendCancel(clientIndex, task.m_taskIndex);
+        } else if (state == SocketFrameHandler::ReplyState::Error || !result) {
+            info.m_stdOutput = "Internal error. " + errorInfo;
+            retry            = true;
+        } else {
+            info.m_toolExecutionTime  = result->m_executionTime;
+            info.m_networkRequestTime = task.m_start.GetElapsedTime();
+            m_balancer.UpdateTaskTimings(clientIndex, transferTime, result->m_executionTime);
+
+            info.m_result    = result->m_result;
+            info.m_stdOutput = result->m_stdOut;
+            std::replace(info.m_stdOutput.begin(), info.m_stdOutput.end(), '\r', ' ');
+
+            if (info.m_result && !outputFilename.empty()) {
+                // network thread is free to recieve next replies while output is written.
+                m_outputPool->Enqueue([this, task, result, info]() mutable {
+                    if (m_cancelled)
+                        return;
+                    info.m_result = WriteOutput(task.m_originalFilename, *result);
+                    // compiler output is not stored, so results with warnings are not cached to keep them visible.
+                    if (info.m_result && !task.m_cacheKey.empty() && info.m_stdOutput.empty())
+                        m_localCache->PutFile(task.m_cacheKey, task.m_originalFilename);
+                    m_parent->UpdateSessionInfo(info);
+                    task.m_callback(info);
+                });
+                return;
+            }
+        }
+        m_parent->UpdateSessionInfo(info);
+        if (task.m_attemptsRemain > 0 && retry) {
+            Syslogger(Syslogger::Warning) << info.m_stdOutput << " Retrying (" << task.m_attemptsRemain << " attempts remain), args:" << task.m_invocation.GetArgsString();
+            // request frame may still be referenced with old id (e.g. by pending cancel), so new id goes to copy.
+            auto taskCopy = task;
+            taskCopy.m_attemptsRemain--;
+            taskCopy.m_taskIndex             = this->m_parent->m_taskIndex++;
+            taskCopy.m_toolRequest           = CopyRequest(*task.m_toolRequest);
+            taskCopy.m_toolRequest->m_taskId = taskCopy.m_taskIndex;
+            taskCopy.m_expirationMoment      = TimePoint(true) + m_parent->m_config.m_queueTimeout;
+            this->QueueTask(taskCopy);
+        } else {
+            task.m_callback(info);
         }
-        return false;
     }
 };
 
@@ -181,6 +896,8 @@ RemoteToolClient::~RemoteToolClient()
     for (auto& client : m_impl->m_clients)
         client->Stop();
 
+    m_impl->m_trainingPool.reset();
+    m_impl->m_outputPool.reset();
     m_impl.reset();
 
     Syslogger() << "/RemoteToolClient::~RemoteToolClient()";
@@ -204,13 +921,28 @@ int RemoteToolClient::GetFreeRemoteThreads() const
 
 void RemoteToolClient::Start(const StringVector& requiredToolIds)
 {
-    m_started = true;
+    m_started           = true;
+    m_impl->m_cancelled = false;
     m_start = m_lastFinish    = TimePoint(true);
     m_sessionInfo             = ToolServerSessionInfo();
     m_sessionInfo.m_sessionId = m_sessionId = m_start.GetUS();
     m_sessionInfo.m_clientId                = m_config.m_clientId;
     m_impl->m_balancer.SetRequiredTools(requiredToolIds);
     m_impl->m_balancer.SetSessionId(m_sessionId);
+    m_impl->m_balancer.SetMaxPrefetch(static_cast<uint16_t>(m_config.m_maxPrefetchTasks));
+    {
+        std::lock_guard<std::mutex> lock(m_impl->m_inputOwnersMutex);
+        m_impl->m_inputOwners.clear();
+    }
+    if (!m_impl->m_outputPool)
+        m_impl->m_outputPool = std::make_unique<ThreadPool>(static_cast<size_t>(m_config.m_outputThreadCount));
+    else
+        m_impl->m_outputPool->SetThreadCount(static_cast<size_t>(m_config.m_outputThreadCount));
+    if (!m_config.m_localCacheDir.empty() && !m_impl->m_localCache)
+        m_impl->m_localCache = std::make_unique<ResultCache>(m_config.m_localCacheDir, int64_t(m_config.m_localCacheSizeMB) * 1024 * 1024);
+    if (m_config.m_adaptiveCompression && !m_impl->m_compressionTuner)
+        m_impl->m_compressionTuner = std::make_unique<CompressionTuner>(m_config.m_compression);
+    m_impl->LoadDictionary();
     m_requiredToolIds = requiredToolIds;
 
     const auto& initialToolServers = m_config.m_initialToolServers;
@@ -242,6 +974,11 @@ void RemoteToolClient::FinishSession()
     m_impl->m_coordinator.SendToolServerSessionInfo(m_sessionInfo, true);
 }
 
+void RemoteToolClient::CancelTasks()
+{
+    m_impl->CancelTasks();
+}
+
 void RemoteToolClient::SetRemoteAvailableCallback(RemoteToolClient::RemoteAvailableCallback callback)
 {
     m_remoteAvailableCallback = std::move(callback);
@@ -263,22 +1000,32 @@ void RemoteToolClient::AddClient(const ToolServerInfo& info, bool start)
     Syslogger() << "RemoteToolClient::AddClient " << info.m_connectionHost << ":" << info.m_connectionPort;
 
     SocketFrameHandlerSettings settings;
-    settings.m_channelProtocolVersion       = RemoteToolRequest::s_version + RemoteToolResponse::s_version;
+    settings.m_channelProtocolVersion       = g_remoteToolProtocolVersion;
     settings.m_recommendedRecieveBufferSize = g_recommendedBufferSize;
     settings.m_recommendedSendBufferSize    = g_recommendedBufferSize;
     settings.m_segmentSize                  = 8192;
     settings.m_hasConnStatus                = true;
     SocketFrameHandler::Ptr handler(new SocketFrameHandler(settings));
     handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolResponse>::Create());
+    handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolBatchResponse>::Create());
+    handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolInputProbeResponse>::Create());
+    handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolDictionaryResponse>::Create());
     handler->RegisterFrameReader(SocketFrameReaderTemplate<ToolsVersionResponse>::Create());
     handler->SetTcpChannel(info.m_connectionHost, info.m_connectionPort);
 
-    handler->SetChannelNotifier([&balancer, index, this](bool state) {
+    handler->SetChannelNotifier([&balancer, index, this, handlerPtr = handler.get()](bool state) {
+        if (state)
+            m_impl->OnClientConnected(*handlerPtr, index);
         balancer.SetClientActive(index, state);
         AvailableCheck();
     });
     handler->SetConnectionStatusNotifier([&balancer, index, this](SocketFrameHandler::ConnectionStatus status) {
-        balancer.SetServerSideLoad(index, status.uniqueRepliesQueued);
+        ToolBalancer::ServerSideLoad load;
+        load.m_repliesQueued      = status.uniqueRepliesQueued;
+        load.m_outputBytesPending = status.outputBytesPending;
+        load.m_queuedTasks        = status.queuedTasks;
+        load.m_runningTasks       = status.runningTasks;
+        balancer.SetServerSideLoad(index, load);
         AvailableCheck();
     });
     auto versionFrameCallback = [&balancer, index, this, info](SocketFrame::Ptr responseFrame, SocketFrameHandler::ReplyState state, const std::string& errorInfo) {
@@ -303,38 +1050,89 @@ void RemoteToolClient::AddClient(const ToolServerInfo& info, bool start)
 }
 
 void RemoteToolClient::InvokeTool(const ToolCommandline& invocation, const InvokeCallback& callback)
+{
+    Invoke(invocation, nullptr, callback);
+}
+
+void RemoteToolClient::InvokeTool(const ToolCommandline& invocation, const ByteArrayHolder& inputData, const InvokeCallback& callback)
+{
+    Invoke(invocation, &inputData, callback);
+}
+
+void RemoteToolClient::Invoke(const ToolCommandline& invocation, const ByteArrayHolder* inputData, const InvokeCallback& callback)
 {
     TimePoint         start(true);
-    const std::string inputFilename = invocation.GetInput();
-    ByteArrayHolder   inputData;
-    if (!inputFilename.empty() && !FileInfo(inputFilename).ReadCompressed(inputData, m_config.m_compression)) {
-        callback(RemoteToolClient::TaskExecutionInfo("failed to read " + inputFilename));
-        return;
-    }
-    m_totalCompressionTime += start.GetElapsedTime();
+    const std::string inputFilename  = invocation.GetInput();
+    const std::string outputFilename = invocation.GetOutput();
 
     auto tool = m_invocationToolProvider->GetTool(invocation.m_id);
     assert(tool);
+    RemoteToolRequestWrap  wrap;
     RemoteToolRequest::Ptr toolRequest(new RemoteToolRequest());
-    toolRequest->m_invocation  = tool->PrepareRemote(invocation);
-    toolRequest->m_fileData    = inputData;
-    toolRequest->m_compression = m_config.m_compression;
-    toolRequest->m_sessionId   = m_sessionId;
-    toolRequest->m_clientId    = m_config.m_clientId;
+    wrap.m_toolRequest        = toolRequest;
+    toolRequest->m_invocation = tool->PrepareRemote(invocation);
+    toolRequest->m_sessionId  = m_sessionId;
+    toolRequest->m_clientId   = m_config.m_clientId;
+
+    // cache is looked up by hash of uncompressed input, so hit does not pay for compression.
+    std::string cacheKey;
+    if (m_impl->m_localCache && !outputFilename.empty()) {
+        std::string inputId;
+        if (inputData) {
+            inputId = Sha256::Hash(*inputData);
+        } else if (!inputFilename.empty() && !m_impl->HashInputFile(inputFilename, inputId)) {
+            callback(RemoteToolClient::TaskExecutionInfo("failed to read " + inputFilename));
+            return;
+        }
+        cacheKey = GetLocalCacheKey(tool->GetId().m_toolId, *toolRequest, inputId);
+        if (m_impl->m_localCache->Materialize(cacheKey, outputFilename)) {
+            Syslogger(Syslogger::Info) << "Local cache hit: " << outputFilename;
+            TaskExecutionInfo info;
+            info.m_result             = true;
+            info.m_cached             = true;
+            info.m_networkRequestTime = start.GetElapsedTime();
+            callback(info);
+            return;
+        }
+    }
+
+    RemoteToolClientImpl::TaskInput input;
+    input.m_compression = m_config.m_compression;
+    // when queue already holds too much input, it stays in file until task is sent.
+    const bool deferred = !inputData && !inputFilename.empty() && m_impl->IsOverInputLimit();
+    bool       read     = true;
+    if (inputData)
+        read = m_impl->PrepareInput(*inputData, input);
+    else if (deferred)
+        read = FileInfo(inputFilename).Exists();
+    else if (!inputFilename.empty())
+        read = m_impl->ReadInput(inputFilename, input);
+    if (!read) {
+        callback(RemoteToolClient::TaskExecutionInfo(inputData ? "failed to compress input" : "failed to read " + inputFilename));
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sessionInfoMutex);
+        m_totalCompressionTime += start.GetElapsedTime();
+    }
+    if (deferred) {
+        wrap.m_deferredInput = inputFilename;
+        wrap.m_deferredSize  = FileInfo(inputFilename).GetFileSize();
+    } else {
+        m_impl->SetRequestInput(wrap, input);
+    }
 
-    RemoteToolRequestWrap wrap;
     wrap.m_start            = start;
-    wrap.m_toolRequest      = toolRequest;
     wrap.m_taskIndex        = m_taskIndex++;
+    toolRequest->m_taskId   = wrap.m_taskIndex;
     wrap.m_invocation       = toolRequest->m_invocation;
-    wrap.m_originalFilename = invocation.GetOutput();
+    wrap.m_originalFilename = outputFilename;
+    wrap.m_cacheKey         = cacheKey;
     wrap.m_callback         = callback;
     wrap.m_expirationMoment = TimePoint(true) + m_config.m_queueTimeout;
     wrap.m_attemptsRemain   = m_config.m_invocationAttempts;
     wrap.m_requestTimeout   = m_config.m_requestTimeout;
 
-    m_sentBytes += inputData.size();
-
     Syslogger(Syslogger::Info) << "QueueFrame [" << wrap.m_taskIndex << "] -> " << toolRequest->m_invocation.m_id.m_toolId
                                << " " << toolRequest->m_invocation.GetArgsString()
                                << ", balancerFree:" << m_impl->m_balancer.GetFreeThreads()
@@ -344,16 +1142,67 @@ void RemoteToolClient::InvokeTool(const ToolCommandline& invocation, const Invok
     m_impl->QueueTask(wrap);
 }
 
+std::string RemoteToolClient::GetLocalCacheSummary() const
+{
+    if (!m_impl->m_localCache)
+        return "";
+
+    const auto     stats   = m_impl->m_localCache->GetStats();
+    const uint64_t lookups = stats.m_hits + stats.m_misses;
+    if (!lookups)
+        return "";
+
+    std::ostringstream os;
+    os << "local cache hits: " << stats.m_hits << "/" << lookups << " (" << (stats.m_hits * 100 / lookups) << "%), "
+       << stats.m_entries << " objects, " << stats.m_size / (1024 * 1024) << " MiB";
+    return os.str();
+}
+
 std::string RemoteToolClient::GetSessionInformation() const
 {
     std::ostringstream os;
     os << m_sessionInfo.ToString(false, true);
     os << " sent KiB: " << m_sentBytes / 1024 << ", ";
     os << " recieved KiB: " << m_recievedBytes / 1024 << ", ";
+    if (m_uploadSavedBytes)
+        os << " not uploaded (server had input) KiB: " << m_uploadSavedBytes / 1024 << ", ";
+    if (m_chunksSkippedBytes)
+        os << " not uploaded (server had chunks, uncompressed) KiB: " << m_chunksSkippedBytes / 1024 << ", ";
+    {
+        std::lock_guard<std::mutex> lock(m_impl->m_dictionaryMutex);
+        if (m_impl->m_dictionary)
+            os << " dictionary: " << m_impl->m_dictionary->GetId().substr(0, 8) << ", ";
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_impl->m_requestsMutex);
+        os << " queued inputs peak KiB: " << m_impl->m_queuedInputPeak / 1024 << ", ";
+    }
+    if (m_deferredInputs)
+        os << " read when sent (over queuedInputLimitMB): " << m_deferredInputs << " inputs, ";
     os << " compression time: " << m_totalCompressionTime.ToProfilingTime() << ", ";
+    if (m_impl->m_compressionTuner)
+        os << m_impl->m_compressionTuner->GetSummary();
     return os.str();
 }
 
+std::string RemoteToolClient::GetLocalCacheKey(const std::string& toolId, const RemoteToolRequest& request, const std::string& inputHash) const
+{
+    // remote invocation has file names without directories, so same source built in other dir gets same key.
+    const auto versionIt = m_toolVersionMap.find(toolId);
+    Sha256     hash;
+    hash.UpdateField("WuildObject2");
+    hash.UpdateField(request.m_invocation.m_id.m_toolId);
+    hash.UpdateField(versionIt != m_toolVersionMap.cend() ? versionIt->second : std::string());
+    for (const auto& arg : request.m_invocation.m_arglist.m_args)
+        hash.UpdateField(arg);
+    for (const auto& item : m_config.m_postProcess.m_items) {
+        hash.UpdateField(std::string(item.m_needle.cbegin(), item.m_needle.cend()));
+        hash.UpdateField(std::string(item.m_replacement.cbegin(), item.m_replacement.cend()));
+    }
+    hash.UpdateField(inputHash);
+    return hash.GetHexDigest();
+}
+
 void RemoteToolClient::UpdateSessionInfo(const RemoteToolClient::TaskExecutionInfo& executionResult)
 {
     std::lock_guard<std::mutex> lock(m_sessionInfoMutex);
@@ -416,13 +1265,17 @@ bool RemoteToolClient::CheckRemoteToolVersions(const IVersionChecker::VersionMap
 std::string RemoteToolClient::TaskExecutionInfo::GetProfilingStr() const
 {
     std::ostringstream os;
-    auto               cus             = m_toolExecutionTime.GetUS();
-    auto               nus             = m_networkRequestTime.GetUS();
-    auto               overheadPercent = ((nus - cus) * 100) / (cus ? cus : 1);
-    os << "compilationTime: " << cus << " us., "
-       << "networkTime: " << nus << " us., "
-       << "overhead: " << overheadPercent << "%";
+    os << "compilationTime: " << m_toolExecutionTime.GetUS() << " us., "
+       << "networkTime: " << m_networkRequestTime.GetUS() << " us., "
+       << "overhead: " << GetOverheadPercent() << "%";
     return os.str();
 }
 
+int64_t RemoteToolClient::TaskExecutionInfo::GetOverheadPercent() const
+{
+    auto cus = m_toolExecutionTime.GetUS();
+    auto nus = m_networkRequestTime.GetUS();
+    return ((nus - cus) * 100) / (cus ? cus : 1);
+}
+
 }
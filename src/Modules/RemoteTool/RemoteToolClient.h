@@ -27,6 +27,7 @@
 
 namespace Wuild {
 class RemoteToolClientImpl;
+class RemoteToolRequest;
 
 /**
  * @brief Transforms local tool execution command to remote.
@@ -43,9 +44,11 @@ public:
         TimePoint   m_toolExecutionTime;
         TimePoint   m_networkRequestTime;
         std::string GetProfilingStr() const;
+        int64_t     GetOverheadPercent() const;
 
         std::string m_stdOutput;
         bool        m_result = false;
+        bool        m_cached = false; //!< Output is taken from local cache, nothing was sent
 
         TaskExecutionInfo(const std::string& stdOutput = std::string())
             : m_stdOutput(stdOutput)
@@ -69,17 +72,28 @@ public:
     void Start(const StringVector& requiredToolIds = StringVector());
     void FinishSession();
 
+    /// Drops queued tasks and asks servers to cancel running ones. Callbacks for them will not be called.
+    void CancelTasks();
+
     void SetRemoteAvailableCallback(RemoteAvailableCallback callback);
 
     /// Starts new remote task.
     void InvokeTool(const ToolCommandline& invocation, const InvokeCallback& callback);
 
+    /// Starts new remote task with uncompressed input in memory; input file of invocation is not read.
+    void InvokeTool(const ToolCommandline& invocation, const ByteArrayHolder& inputData, const InvokeCallback& callback);
+
     std::string GetSessionInformation() const;
 
+    /// Hit rate of local object cache; empty if cache is disabled or not used.
+    std::string GetLocalCacheSummary() const;
+
 protected:
-    void UpdateSessionInfo(const TaskExecutionInfo& executionResult);
-    void AvailableCheck();
-    bool CheckRemoteToolVersions(const IVersionChecker::VersionMap& versionMap, const std::string& hostname);
+    void        Invoke(const ToolCommandline& invocation, const ByteArrayHolder* inputData, const InvokeCallback& callback);
+    void        UpdateSessionInfo(const TaskExecutionInfo& executionResult);
+    std::string GetLocalCacheKey(const std::string& toolId, const RemoteToolRequest& request, const std::string& inputHash) const;
+    void        AvailableCheck();
+    bool        CheckRemoteToolVersions(const IVersionChecker::VersionMap& versionMap, const std::string& hostname);
 
     ThreadLoop m_thread;
 
@@ -93,6 +107,9 @@ protected:
     TimePoint                  m_totalCompressionTime;
     std::atomic<std::uint64_t> m_sentBytes{ 0 };
     std::atomic<std::uint64_t> m_recievedBytes{ 0 };
+    std::atomic<std::uint64_t> m_uploadSavedBytes{ 0 };   //!< Inputs sent by hash only
+    std::atomic<std::uint64_t> m_chunksSkippedBytes{ 0 }; //!< Input chunks which server already had
+    std::atomic<std::uint64_t> m_deferredInputs{ 0 };     //!< Inputs read when task was sent, over queued input limit
     ToolServerSessionInfo      m_sessionInfo;
     std::mutex                 m_sessionInfoMutex;
     std::mutex                 m_availableCheckMutex;
@@ -21,15 +21,26 @@ namespace Wuild {
 void RemoteToolRequest::LogTo(std::ostream& os) const
 {
     SocketFrame::LogTo(os);
-    os << " " << m_invocation.m_id.m_toolId << " args:" << m_invocation.GetArgsString();
+    os << " [" << m_taskId << "] " << m_invocation.m_id.m_toolId << " args:" << m_invocation.GetArgsString();
     os << " file: [" << m_fileData.size() << ", COMP:" << uint32_t(m_compression.m_type) << "]";
+    if (!m_inputHash.empty())
+        os << " hash: " << m_inputHash.substr(0, 8);
+    if (!m_dictionaryId.empty())
+        os << " dict: " << m_dictionaryId.substr(0, 8);
+    if (!m_chunkHashes.empty())
+        os << " chunks: " << m_chunkHashes.size();
 }
 
 SocketFrame::State RemoteToolRequest::ReadInternal(ByteOrderDataStreamReader& stream)
 {
     stream >> m_clientId;
     stream >> m_sessionId;
+    stream >> m_taskId;
     stream >> m_fileData;
+    stream >> m_inputHash;
+    stream >> m_dictionaryId;
+    stream >> m_chunkHashes;
+    stream >> m_chunkSizes;
     stream >> m_invocation.m_arglist.m_args;
     stream >> m_invocation.m_id.m_toolId;
     stream >> m_compression;
@@ -41,7 +52,12 @@ SocketFrame::State RemoteToolRequest::WriteInternal(ByteOrderDataStreamWriter& s
 {
     stream << m_clientId;
     stream << m_sessionId;
+    stream << m_taskId;
     stream << m_fileData;
+    stream << m_inputHash;
+    stream << m_dictionaryId;
+    stream << m_chunkHashes;
+    stream << m_chunkSizes;
     stream << m_invocation.m_arglist.m_args;
     stream << m_invocation.m_id.m_toolId;
     stream << m_compression;
@@ -51,7 +67,7 @@ SocketFrame::State RemoteToolRequest::WriteInternal(ByteOrderDataStreamWriter& s
 void RemoteToolResponse::LogTo(std::ostream& os) const
 {
     SocketFrame::LogTo(os);
-    os << " -> " << (m_result ? "OK" : "FAIL") << " ["
+    os << " -> " << (m_result ? "OK" : (m_inputRequired ? "INPUT REQUIRED" : "FAIL")) << " ["
        << m_fileData.size() << ", COMP:" << uint32_t(m_compression.m_type) << "], std["
        << m_stdOut.size() << "]";
 }
@@ -59,9 +75,11 @@ void RemoteToolResponse::LogTo(std::ostream& os) const
 SocketFrame::State RemoteToolResponse::ReadInternal(ByteOrderDataStreamReader& stream)
 {
     stream >> m_result;
+    stream >> m_inputRequired;
     stream >> m_fileData;
     stream >> m_stdOut;
     stream >> m_executionTime;
+    stream >> m_queueTime;
     stream >> m_compression;
     return stOk;
 }
@@ -69,13 +87,165 @@ SocketFrame::State RemoteToolResponse::ReadInternal(ByteOrderDataStreamReader& s
 SocketFrame::State RemoteToolResponse::WriteInternal(ByteOrderDataStreamWriter& stream) const
 {
     stream << m_result;
+    stream << m_inputRequired;
     stream << m_fileData;
     stream << m_stdOut;
     stream << m_executionTime;
+    stream << m_queueTime;
     stream << m_compression;
     return stOk;
 }
 
+void RemoteToolCancel::LogTo(std::ostream& os) const
+{
+    SocketFrame::LogTo(os);
+    os << " cancel [" << m_taskId << "]";
+}
+
+SocketFrame::State RemoteToolCancel::ReadInternal(ByteOrderDataStreamReader& stream)
+{
+    stream >> m_sessionId;
+    stream >> m_taskId;
+    return stOk;
+}
+
+SocketFrame::State RemoteToolCancel::WriteInternal(ByteOrderDataStreamWriter& stream) const
+{
+    stream << m_sessionId;
+    stream << m_taskId;
+    return stOk;
+}
+
+void RemoteToolBatchRequest::LogTo(std::ostream& os) const
+{
+    SocketFrame::LogTo(os);
+    os << " batch [" << m_requests.size() << "]";
+}
+
+SocketFrame::State RemoteToolBatchRequest::ReadInternal(ByteOrderDataStreamReader& stream)
+{
+    uint32_t count = 0;
+    stream >> count;
+    m_requests.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        RemoteToolRequest::Ptr request(new RemoteToolRequest());
+        if (request->ReadInternal(stream) != stOk)
+            return stBroken;
+        m_requests.push_back(request);
+    }
+    return stOk;
+}
+
+SocketFrame::State RemoteToolBatchRequest::WriteInternal(ByteOrderDataStreamWriter& stream) const
+{
+    stream << static_cast<uint32_t>(m_requests.size());
+    for (const auto& request : m_requests)
+        request->WriteInternal(stream);
+    return stOk;
+}
+
+void RemoteToolBatchResponse::LogTo(std::ostream& os) const
+{
+    SocketFrame::LogTo(os);
+    os << " -> batch [" << m_responses.size() << "]";
+}
+
+SocketFrame::State RemoteToolBatchResponse::ReadInternal(ByteOrderDataStreamReader& stream)
+{
+    uint32_t count = 0;
+    stream >> count;
+    m_responses.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        RemoteToolResponse::Ptr response(new RemoteToolResponse());
+        if (response->ReadInternal(stream) != stOk)
+            return stBroken;
+        m_responses.push_back(response);
+    }
+    return stOk;
+}
+
+SocketFrame::State RemoteToolBatchResponse::WriteInternal(ByteOrderDataStreamWriter& stream) const
+{
+    stream << static_cast<uint32_t>(m_responses.size());
+    for (const auto& response : m_responses)
+        response->WriteInternal(stream);
+    return stOk;
+}
+
+void RemoteToolInputProbe::LogTo(std::ostream& os) const
+{
+    SocketFrame::LogTo(os);
+    os << " probe [" << m_hashes.size() << "]";
+}
+
+SocketFrame::State RemoteToolInputProbe::ReadInternal(ByteOrderDataStreamReader& stream)
+{
+    stream >> m_hashes;
+    return stOk;
+}
+
+SocketFrame::State RemoteToolInputProbe::WriteInternal(ByteOrderDataStreamWriter& stream) const
+{
+    stream << m_hashes;
+    return stOk;
+}
+
+void RemoteToolInputProbeResponse::LogTo(std::ostream& os) const
+{
+    SocketFrame::LogTo(os);
+    os << " -> probe available [" << m_available.size() << "]";
+}
+
+SocketFrame::State RemoteToolInputProbeResponse::ReadInternal(ByteOrderDataStreamReader& stream)
+{
+    stream >> m_available;
+    return stOk;
+}
+
+SocketFrame::State RemoteToolInputProbeResponse::WriteInternal(ByteOrderDataStreamWriter& stream) const
+{
+    stream << m_available;
+    return stOk;
+}
+
+void RemoteToolDictionary::LogTo(std::ostream& os) const
+{
+    SocketFrame::LogTo(os);
+    os << " dictionary " << m_id.substr(0, 8) << " [" << m_data.size() << "]";
+}
+
+SocketFrame::State RemoteToolDictionary::ReadInternal(ByteOrderDataStreamReader& stream)
+{
+    stream >> m_id;
+    stream >> m_data;
+    return stOk;
+}
+
+SocketFrame::State RemoteToolDictionary::WriteInternal(ByteOrderDataStreamWriter& stream) const
+{
+    stream << m_id;
+    stream << m_data;
+    return stOk;
+}
+
+void RemoteToolDictionaryResponse::LogTo(std::ostream& os) const
+{
+    SocketFrame::LogTo(os);
+    os << " -> dictionary " << (m_accepted ? "accepted" : "rejected");
+}
+
+SocketFrame::State RemoteToolDictionaryResponse::ReadInternal(ByteOrderDataStreamReader& stream)
+{
+    stream >> m_accepted;
+    return stOk;
+}
+
+SocketFrame::State RemoteToolDictionaryResponse::WriteInternal(ByteOrderDataStreamWriter& stream) const
+{
+    stream << m_accepted;
+    return stOk;
+}
+
 SocketFrame::State ToolsVersionResponse::ReadInternal(ByteOrderDataStreamReader& stream)
 {
     stream >> m_versions;
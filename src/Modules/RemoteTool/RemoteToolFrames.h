@@ -23,15 +23,20 @@ namespace Wuild {
 
 class RemoteToolRequest : public SocketFrameExt {
 public:
-    static const uint32_t s_version     = 2;
+    static const uint32_t s_version     = 8;
     static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 1;
     using Ptr                           = std::shared_ptr<RemoteToolRequest>;
 
-    std::string     m_clientId;
-    uint64_t        m_sessionId;
-    ToolCommandline m_invocation;
-    ByteArrayHolder m_fileData;
-    CompressionInfo m_compression;
+    std::string           m_clientId;
+    uint64_t              m_sessionId;
+    uint64_t              m_taskId = 0; //!< Unique within session, used for cancellation.
+    ToolCommandline       m_invocation;
+    ByteArrayHolder       m_fileData;     //!< Empty if server reported it has input with m_inputHash; with chunks, only ones server does not have
+    std::string           m_inputHash;    //!< SHA-256 of m_fileData; empty = client does not use hash-first upload
+    std::string           m_dictionaryId; //!< m_fileData is zstd frame compressed with this dictionary; empty = m_compression is used
+    StringVector          m_chunkHashes;  //!< Not empty = input is sent by chunks, see ChunkedInput
+    std::vector<uint32_t> m_chunkSizes;   //!< For each chunk, its size in uncompressed m_fileData; 0 = not sent, server has it
+    CompressionInfo       m_compression;
 
     uint8_t FrameTypeId() const override { return s_frameTypeId; }
 
@@ -42,15 +47,17 @@ public:
 
 class RemoteToolResponse : public SocketFrameExt {
 public:
-    static const uint32_t s_version     = 2;
+    static const uint32_t s_version     = 5;
     static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 2;
     using Ptr                           = std::shared_ptr<RemoteToolResponse>;
 
-    bool            m_result = true;
+    bool            m_result        = true;
+    bool            m_inputRequired = false; //!< Request had no input data and server does not have it anymore
     ByteArrayHolder m_fileData;
     CompressionInfo m_compression;
     std::string     m_stdOut;
     TimePoint       m_executionTime;
+    TimePoint       m_queueTime; //!< Time spent in server queue
 
     void    LogTo(std::ostream& os) const override;
     uint8_t FrameTypeId() const override { return s_frameTypeId; }
@@ -59,6 +66,115 @@ public:
     State WriteInternal(ByteOrderDataStreamWriter& stream) const override;
 };
 
+class RemoteToolCancel : public SocketFrameExt {
+public:
+    static const uint32_t s_version     = 1;
+    static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 5;
+    using Ptr                           = std::shared_ptr<RemoteToolCancel>;
+
+    uint64_t m_sessionId = 0;
+    uint64_t m_taskId    = 0;
+
+    uint8_t FrameTypeId() const override { return s_frameTypeId; }
+
+    void  LogTo(std::ostream& os) const override;
+    State ReadInternal(ByteOrderDataStreamReader& stream) override;
+    State WriteInternal(ByteOrderDataStreamWriter& stream) const override;
+};
+
+/// Several small invocations sent at once; server executes them in parallel and sends one RemoteToolBatchResponse.
+class RemoteToolBatchRequest : public SocketFrameExt {
+public:
+    static const uint32_t s_version     = 1;
+    static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 6;
+    using Ptr                           = std::shared_ptr<RemoteToolBatchRequest>;
+
+    std::vector<RemoteToolRequest::Ptr> m_requests;
+
+    uint8_t FrameTypeId() const override { return s_frameTypeId; }
+
+    void  LogTo(std::ostream& os) const override;
+    State ReadInternal(ByteOrderDataStreamReader& stream) override;
+    State WriteInternal(ByteOrderDataStreamWriter& stream) const override;
+};
+
+class RemoteToolBatchResponse : public SocketFrameExt {
+public:
+    static const uint32_t s_version     = 1;
+    static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 7;
+    using Ptr                           = std::shared_ptr<RemoteToolBatchResponse>;
+
+    std::vector<RemoteToolResponse::Ptr> m_responses; //!< Same order as in request
+
+    uint8_t FrameTypeId() const override { return s_frameTypeId; }
+
+    void  LogTo(std::ostream& os) const override;
+    State ReadInternal(ByteOrderDataStreamReader& stream) override;
+    State WriteInternal(ByteOrderDataStreamWriter& stream) const override;
+};
+
+/// Asks server which of the inputs it already has, so request could be sent without input data.
+class RemoteToolInputProbe : public SocketFrameExt {
+public:
+    static const uint32_t s_version     = 1;
+    static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 8;
+    using Ptr                           = std::shared_ptr<RemoteToolInputProbe>;
+
+    StringVector m_hashes;
+
+    uint8_t FrameTypeId() const override { return s_frameTypeId; }
+
+    void  LogTo(std::ostream& os) const override;
+    State ReadInternal(ByteOrderDataStreamReader& stream) override;
+    State WriteInternal(ByteOrderDataStreamWriter& stream) const override;
+};
+
+class RemoteToolInputProbeResponse : public SocketFrameExt {
+public:
+    static const uint32_t s_version     = 1;
+    static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 9;
+    using Ptr                           = std::shared_ptr<RemoteToolInputProbeResponse>;
+
+    StringVector m_available; //!< Hashes from probe which server has
+
+    uint8_t FrameTypeId() const override { return s_frameTypeId; }
+
+    void  LogTo(std::ostream& os) const override;
+    State ReadInternal(ByteOrderDataStreamReader& stream) override;
+    State WriteInternal(ByteOrderDataStreamWriter& stream) const override;
+};
+
+class RemoteToolDictionary : public SocketFrameExt {
+public:
+    static const uint32_t s_version     = 1;
+    static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 10;
+    using Ptr                           = std::shared_ptr<RemoteToolDictionary>;
+
+    std::string     m_id; //!< SHA-256 of m_data
+    ByteArrayHolder m_data;
+
+    uint8_t FrameTypeId() const override { return s_frameTypeId; }
+
+    void  LogTo(std::ostream& os) const override;
+    State ReadInternal(ByteOrderDataStreamReader& stream) override;
+    State WriteInternal(ByteOrderDataStreamWriter& stream) const override;
+};
+
+class RemoteToolDictionaryResponse : public SocketFrameExt {
+public:
+    static const uint32_t s_version     = 1;
+    static const uint8_t  s_frameTypeId = s_minimalUserFrameId + 11;
+    using Ptr                           = std::shared_ptr<RemoteToolDictionaryResponse>;
+
+    bool m_accepted = false; //!< False if server is built without dictionary support
+
+    uint8_t FrameTypeId() const override { return s_frameTypeId; }
+
+    void  LogTo(std::ostream& os) const override;
+    State ReadInternal(ByteOrderDataStreamReader& stream) override;
+    State WriteInternal(ByteOrderDataStreamWriter& stream) const override;
+};
+
 class ToolsVersionRequest : public SocketFrameExt {
 public:
     static const uint32_t s_version     = 1;
@@ -85,4 +201,10 @@ public:
     State WriteInternal(ByteOrderDataStreamWriter& stream) const override;
 };
 
+/// Channel protocol version for both sides of remote tool connection.
+const uint32_t g_remoteToolProtocolVersion = RemoteToolRequest::s_version + RemoteToolResponse::s_version
+                                             + RemoteToolBatchRequest::s_version + RemoteToolBatchResponse::s_version
+                                             + RemoteToolInputProbe::s_version + RemoteToolInputProbeResponse::s_version
+                                             + RemoteToolDictionary::s_version + RemoteToolDictionaryResponse::s_version;
+
 }
@@ -13,13 +13,24 @@
 
 #include "RemoteToolServer.h"
 
+#include "ChunkedInput.h"
+#include "InputStore.h"
 #include "RemoteToolFrames.h"
+#include "ThreadCountScaler.h"
 
+#include <ResultCache.h>
+#include <ByteOrderStream.h>
+#include <ChunkedCompression.h>
+#include <CompressionDictionary.h>
+#include <Sha256.h>
 #include <SocketFrameService.h>
 #include <CoordinatorClient.h>
+#include <Application.h>
+#include <ThreadLoop.h>
 #include <ThreadUtils.h>
 
 #include <algorithm>
+#include <condition_variable>
 #include <utility>
 #include <memory>
 
@@ -27,6 +38,40 @@ namespace Wuild {
 
 static const size_t g_recommendedBufferSize = 64 * 1024;
 
+/// Executor may call task callback after server is destroyed (e.g. on interrupt), so callback enters gate before using server.
+class CallbackGate {
+public:
+    bool Enter()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed)
+            return false;
+        m_running++;
+        return true;
+    }
+
+    void Leave()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running--;
+        m_cond.notify_all();
+    }
+
+    /// Waits for callbacks which already entered.
+    void Close()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_cond.wait(lock, [this] { return !m_running; });
+    }
+
+private:
+    std::mutex              m_mutex;
+    std::condition_variable m_cond;
+    bool                    m_closed  = false;
+    size_t                  m_running = 0;
+};
+
 class RemoteToolServerImpl {
 public:
     std::mutex                             m_infoMutex;
@@ -36,6 +81,158 @@ public:
     ILocalExecutor::Ptr                    m_executor;
     std::mutex                             m_sessionsIdsMutex;
     std::map<SocketFrameHandler*, int64_t> m_sessionsIds;
+
+    std::unique_ptr<ResultCache> m_resultCache;
+    std::unique_ptr<InputStore>  m_inputStore;
+
+    std::mutex                                        m_dictionariesMutex;
+    std::map<std::string, CompressionDictionary::Ptr> m_dictionaries; //!< Sent by clients, by id
+
+    std::unique_ptr<ThreadCountScaler> m_threadScaler;
+    ThreadLoop                         m_threadScalerLoop;
+    TimePoint                          m_threadScalerUpdate;
+
+    using TaskKey = std::pair<int64_t, uint64_t>; // session id, task id.
+    std::mutex                                m_activeTasksMutex;
+    std::map<TaskKey, LocalExecutorTask::Ptr> m_activeTasks;
+    std::shared_ptr<CallbackGate>             m_callbackGate = std::make_shared<CallbackGate>();
+
+    void CancelTask(const TaskKey& key)
+    {
+        LocalExecutorTask::Ptr task;
+        {
+            std::lock_guard<std::mutex> lock(m_activeTasksMutex);
+            auto                        it = m_activeTasks.find(key);
+            if (it == m_activeTasks.end())
+                return;
+            task = it->second;
+        }
+        m_executor->CancelTask(task);
+    }
+
+    bool AddDictionary(const RemoteToolDictionary& frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_dictionariesMutex);
+            if (m_dictionaries.count(frame.m_id))
+                return true;
+        }
+        auto dictionary = CompressionDictionary::Create(frame.m_data);
+        if (!dictionary || dictionary->GetId() != frame.m_id)
+            return false;
+        std::lock_guard<std::mutex> lock(m_dictionariesMutex);
+        m_dictionaries[frame.m_id] = dictionary;
+        return true;
+    }
+
+    /// Replaces input compressed with client dictionary by uncompressed one.
+    bool UncompressWithDictionary(const std::string& dictionaryId, ByteArrayHolder& data)
+    {
+        CompressionDictionary::Ptr dictionary;
+        {
+            std::lock_guard<std::mutex> lock(m_dictionariesMutex);
+            auto                        it = m_dictionaries.find(dictionaryId);
+            if (it == m_dictionaries.end())
+                return false;
+            dictionary = it->second;
+        }
+        ByteArrayHolder uncompressedData;
+        try {
+            dictionary->Uncompress(data, uncompressedData);
+        }
+        catch (std::exception& e) {
+            Syslogger(Syslogger::Err) << "Error on uncompress:" << e.what();
+            return false;
+        }
+        data = uncompressedData;
+        return true;
+    }
+
+    /// Hash of input as compiler gets it; empty if input is broken.
+    static std::string HashUncompressedInput(const ByteArrayHolder& data, const CompressionInfo& compression)
+    {
+        if (compression.m_type == Mernel::CompressionType::None)
+            return Sha256::Hash(data);
+
+        // decompressed data is not kept, so queued tasks hold only compressed input.
+        Sha256 hash;
+        try {
+            ChunkedCompression::Uncompress(data, compression, [&hash](const ByteArrayHolder& chunk) { hash.Update(chunk); });
+        }
+        catch (std::exception& e) {
+            Syslogger(Syslogger::Err) << "Error on uncompress:" << e.what();
+            return std::string();
+        }
+        return hash.GetHexDigest();
+    }
+
+    enum class ChunksState
+    {
+        Ok,
+        Missing, //!< Chunk was not sent and is not stored; client will send all of them
+        Invalid,
+    };
+
+    /// Reassembles uncompressed input from chunks in request and ones stored from previous requests.
+    /// New chunks are stored after their hashes are verified, so input is the same as on client.
+    ChunksState AssembleChunks(const RemoteToolRequest& request, ByteArrayHolder& data)
+    {
+        const auto& hashes = request.m_chunkHashes;
+        const auto& sizes  = request.m_chunkSizes;
+        if (sizes.size() != hashes.size())
+            return ChunksState::Invalid;
+
+        ByteArrayHolder sent;
+        if (request.m_compression.m_type == Mernel::CompressionType::None || !request.m_fileData.size()) {
+            sent = request.m_fileData;
+        } else {
+            try {
+                ChunkedCompression::Uncompress(request.m_fileData, sent, request.m_compression);
+            }
+            catch (std::exception& e) {
+                Syslogger(Syslogger::Err) << "Error on uncompress:" << e.what();
+                return ChunksState::Invalid;
+            }
+        }
+
+        ByteArray out;
+        size_t    offset = 0;
+        for (size_t i = 0; i < hashes.size(); ++i) {
+            if (!sizes[i]) {
+                ByteArrayHolder chunk;
+                if (!m_inputStore->Get(hashes[i], chunk))
+                    return ChunksState::Missing;
+                out.insert(out.end(), chunk.ref().cbegin(), chunk.ref().cend());
+                continue;
+            }
+            if (offset + sizes[i] > sent.size())
+                return ChunksState::Invalid;
+            const uint8_t* chunkData = sent.data() + offset;
+            offset += sizes[i];
+            if (Sha256().Update(chunkData, sizes[i]).GetHexDigest() != hashes[i])
+                return ChunksState::Invalid;
+            out.insert(out.end(), chunkData, chunkData + sizes[i]);
+            m_inputStore->Put(hashes[i], ByteArrayHolder(ByteArray(chunkData, chunkData + sizes[i])));
+        }
+        if (offset != sent.size())
+            return ChunksState::Invalid;
+        data = ByteArrayHolder(std::move(out));
+        return ChunksState::Ok;
+    }
+
+    void CancelSession(int64_t sessionId)
+    {
+        std::vector<LocalExecutorTask::Ptr> tasks;
+        {
+            std::lock_guard<std::mutex> lock(m_activeTasksMutex);
+            for (auto it = m_activeTasks.lower_bound(TaskKey(sessionId, 0)); it != m_activeTasks.end() && it->first.first == sessionId; ++it)
+                tasks.push_back(it->second);
+        }
+        if (!tasks.empty())
+            Syslogger(Syslogger::Notice) << "Session " << sessionId << " disconnected, cancelling " << tasks.size() << " tasks.";
+        for (const auto& task : tasks)
+            m_executor->CancelTask(task);
+    }
 };
 
 RemoteToolServer::RemoteToolServer(ILocalExecutor::Ptr executor, const IVersionChecker::VersionMap& versionMap)
@@ -47,7 +244,9 @@ RemoteToolServer::RemoteToolServer(ILocalExecutor::Ptr executor, const IVersionC
 
 RemoteToolServer::~RemoteToolServer()
 {
+    m_impl->m_threadScalerLoop.Stop();
     m_impl->m_server.reset();
+    m_impl->m_callbackGate->Close();
 }
 
 bool RemoteToolServer::SetConfig(const RemoteToolServer::Config& config)
@@ -70,13 +269,25 @@ void RemoteToolServer::Start()
     info.m_toolServerId   = m_config.m_serverName;
     info.m_toolIds        = m_impl->m_executor->GetToolIds();
     m_impl->m_executor->SetThreadCount(m_config.m_threadCount);
+    m_impl->m_executor->SetIoThreadCount(m_config.m_ioThreadCount);
+    if (!m_config.m_memoryStagingDir.empty()) {
+        // listen port makes dir unique for each server on the host.
+        const auto stagingPath = m_config.m_memoryStagingDir + "/Wuild/ToolServer_" + std::to_string(m_config.m_listenPort);
+        m_impl->m_executor->SetMemoryStaging(stagingPath, int64_t(m_config.m_memoryStagingReserveMB) * 1024 * 1024);
+    }
+    m_impl->m_executor->SetMemoryAdmission(int64_t(m_config.m_memoryAdmissionReserveMB) * 1024 * 1024);
+    m_impl->m_executor->SetToolWarmup(TimePoint(m_config.m_toolWarmupIntervalS));
+    m_impl->m_executor->SetCpuAffinity(m_config.m_cpuAffinity);
+    if (!m_config.m_resultCacheDir.empty())
+        m_impl->m_resultCache = std::make_unique<ResultCache>(m_config.m_resultCacheDir, int64_t(m_config.m_resultCacheSizeMB) * 1024 * 1024);
+    m_impl->m_inputStore = std::make_unique<InputStore>(int64_t(m_config.m_inputCacheSizeMB) * 1024 * 1024);
 
     m_impl->m_coordinator.SetToolServerInfo(info);
     if (!m_impl->m_coordinator.SetConfig(m_config.m_coordinator))
         return;
 
     SocketFrameHandlerSettings settings;
-    settings.m_channelProtocolVersion       = RemoteToolRequest::s_version + RemoteToolResponse::s_version;
+    settings.m_channelProtocolVersion       = g_remoteToolProtocolVersion;
     settings.m_recommendedRecieveBufferSize = g_recommendedBufferSize;
     settings.m_recommendedSendBufferSize    = g_recommendedBufferSize;
     settings.m_segmentSize                  = 8192;
@@ -84,29 +295,69 @@ void RemoteToolServer::Start()
     m_impl->m_server                        = std::make_unique<SocketFrameService>(settings, m_config.m_listenPort, m_config.m_hostsWhiteList);
 
     m_impl->m_server->SetHandlerInitCallback([this](SocketFrameHandler* handler) {
+        handler->SetConnectionStatusProvider([this](SocketFrameHandler::ConnectionStatus& status) {
+            // m_runningTasks counts all accepted tasks, including queued ones.
+            const size_t queued  = m_impl->m_executor->GetQueueSize();
+            const size_t started = m_runningTasks;
+            status.queuedTasks   = static_cast<uint16_t>(queued);
+            status.runningTasks  = static_cast<uint16_t>(started > queued ? started - queued : 0);
+        });
         handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolRequest>::Create([this, handler](const RemoteToolRequest& inputMessage, SocketFrameHandler::OutputCallback outputCallback) {
-            const auto sessionId = inputMessage.m_sessionId;
-            {
-                std::lock_guard<std::mutex> lock(m_impl->m_sessionsIdsMutex);
-                m_impl->m_sessionsIds[handler] = sessionId;
-            }
-            StartTask(inputMessage.m_clientId, sessionId);
-            LocalExecutorTask::Ptr taskCC(new LocalExecutorTask());
-            taskCC->m_invocation       = inputMessage.m_invocation;
-            taskCC->m_inputData        = inputMessage.m_fileData;
-            taskCC->m_compressionInput = inputMessage.m_compression;
-            auto compressionOut = taskCC->m_compressionOutput = m_config.m_useClientCompression ? inputMessage.m_compression : m_config.m_compression;
-            taskCC->m_callback                                = [outputCallback, this, sessionId, compressionOut](LocalExecutorResult::Ptr result) {
-                FinishTask(sessionId, false);
-                RemoteToolResponse::Ptr response(new RemoteToolResponse());
-                response->m_result        = result->m_result;
-                response->m_stdOut        = result->m_stdOut;
-                response->m_fileData      = result->m_outputData;
-                response->m_compression   = compressionOut;
-                response->m_executionTime = result->m_executionTime;
-                outputCallback(response);
+            ExecuteRequest(inputMessage, handler, [outputCallback](RemoteToolResponse::Ptr response) {
+                if (response) // otherwise client is not waiting for reply anymore.
+                    outputCallback(response);
+            });
+        }));
+
+        handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolBatchRequest>::Create([this, handler](const RemoteToolBatchRequest& inputMessage, SocketFrameHandler::OutputCallback outputCallback) {
+            struct BatchState {
+                std::mutex                   m_mutex;
+                RemoteToolBatchResponse::Ptr m_response{ new RemoteToolBatchResponse() };
+                size_t                       m_remaining = 0;
             };
-            m_impl->m_executor->AddTask(taskCC);
+            auto state         = std::make_shared<BatchState>();
+            state->m_remaining = inputMessage.m_requests.size();
+            state->m_response->m_responses.resize(inputMessage.m_requests.size());
+            if (inputMessage.m_requests.empty()) {
+                outputCallback(state->m_response);
+                return;
+            }
+            // items are executed in parallel on executor slots; reply is sent when the last one is done.
+            // Item cancelled by client gets placeholder, so results of others are still sent.
+            for (size_t i = 0; i < inputMessage.m_requests.size(); ++i) {
+                ExecuteRequest(*inputMessage.m_requests[i], handler, [outputCallback, state, i](RemoteToolResponse::Ptr response) {
+                    std::unique_lock<std::mutex> lock(state->m_mutex);
+                    if (!response) {
+                        response.reset(new RemoteToolResponse());
+                        response->m_result = false;
+                        response->m_stdOut = "Cancelled.";
+                    }
+                    state->m_response->m_responses[i] = response;
+                    if (--state->m_remaining > 0)
+                        return;
+                    lock.unlock();
+                    outputCallback(state->m_response);
+                });
+            }
+        }));
+
+        handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolInputProbe>::Create([this](const RemoteToolInputProbe& inputMessage, SocketFrameHandler::OutputCallback outputCallback) {
+            RemoteToolInputProbeResponse::Ptr response(new RemoteToolInputProbeResponse());
+            for (const auto& hash : inputMessage.m_hashes) {
+                if (m_impl->m_inputStore->Has(hash))
+                    response->m_available.push_back(hash);
+            }
+            outputCallback(response);
+        }));
+
+        handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolDictionary>::Create([this](const RemoteToolDictionary& inputMessage, SocketFrameHandler::OutputCallback outputCallback) {
+            RemoteToolDictionaryResponse::Ptr response(new RemoteToolDictionaryResponse());
+            response->m_accepted = m_impl->AddDictionary(inputMessage);
+            outputCallback(response);
+        }));
+
+        handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolCancel>::Create([this](const RemoteToolCancel& inputMessage, SocketFrameHandler::OutputCallback) {
+            m_impl->CancelTask(RemoteToolServerImpl::TaskKey(inputMessage.m_sessionId, inputMessage.m_taskId));
         }));
 
         handler->RegisterFrameReader(SocketFrameReaderTemplate<ToolsVersionRequest>::Create([this](const ToolsVersionRequest&, SocketFrameHandler::OutputCallback outputCallback) {
@@ -123,12 +374,25 @@ void RemoteToolServer::Start()
             sessionId = m_impl->m_sessionsIds[handler];
             m_impl->m_sessionsIds.erase(handler);
         }
+        m_impl->CancelSession(sessionId);
         FinishTask(sessionId, true);
     });
 
     m_impl->m_server->Start();
 
     m_impl->m_coordinator.Start();
+
+    m_impl->m_threadScaler = std::make_unique<ThreadCountScaler>(m_config, static_cast<int>(std::thread::hardware_concurrency()));
+    if (m_impl->m_threadScaler->IsEnabled()) {
+        m_impl->m_threadScalerLoop.Exec([this]() -> bool {
+            if (!m_impl->m_threadScalerUpdate || m_impl->m_threadScalerUpdate.GetElapsedTime() > TimePoint(m_config.m_threadScalingIntervalS)) {
+                m_impl->m_threadScalerUpdate = TimePoint(true);
+                UpdateThreadCount();
+            }
+            return true;
+        },
+                                        100000 /*us*/);
+    }
 }
 
 ToolServerInfo::ConnectedClientInfo& GetClientInfo(ToolServerInfo& info, int64_t sessionId)
@@ -144,6 +408,159 @@ ToolServerInfo::ConnectedClientInfo& GetClientInfo(ToolServerInfo& info, int64_t
     return *info.m_connectedClients.rbegin();
 }
 
+void RemoteToolServer::ExecuteRequest(const RemoteToolRequest& request, SocketFrameHandler* handler, std::function<void(std::shared_ptr<RemoteToolResponse>)> callback)
+{
+    ByteArrayHolder fileData         = request.m_fileData;
+    auto            compressionInput = request.m_compression;
+    if (!request.m_chunkHashes.empty()) {
+        const auto state = m_impl->AssembleChunks(request, fileData);
+        if (state != RemoteToolServerImpl::ChunksState::Ok) {
+            // evicted chunk is resent by client with all others.
+            RemoteToolResponse::Ptr response(new RemoteToolResponse());
+            response->m_result        = false;
+            response->m_inputRequired = state == RemoteToolServerImpl::ChunksState::Missing;
+            if (!response->m_inputRequired)
+                response->m_stdOut = "Invalid input chunks.";
+            callback(response);
+            return;
+        }
+        compressionInput.m_type = Mernel::CompressionType::None;
+    } else if (!request.m_inputHash.empty() && !fileData.size()) {
+        if (!m_impl->m_inputStore->Get(request.m_inputHash, fileData)) {
+            // evicted since client probed it; client will resend request with data.
+            RemoteToolResponse::Ptr response(new RemoteToolResponse());
+            response->m_result        = false;
+            response->m_inputRequired = true;
+            callback(response);
+            return;
+        }
+    } else if (!request.m_inputHash.empty() && m_impl->m_inputStore->IsEnabled()) {
+        // client hash is not trusted, otherwise one client could substitute input for others.
+        if (Sha256::Hash(fileData) == request.m_inputHash)
+            m_impl->m_inputStore->Put(request.m_inputHash, fileData);
+        else
+            Syslogger(Syslogger::Warning) << "Input hash mismatch for " << request.m_invocation.GetArgsString() << " from " << request.m_clientId;
+    }
+
+    if (!request.m_dictionaryId.empty()) {
+        // dictionary is sent before requests on same connection, so it is missing only if server was restarted.
+        if (!m_impl->UncompressWithDictionary(request.m_dictionaryId, fileData)) {
+            RemoteToolResponse::Ptr response(new RemoteToolResponse());
+            response->m_result        = false;
+            response->m_inputRequired = true;
+            callback(response);
+            return;
+        }
+        compressionInput.m_type = Mernel::CompressionType::None;
+    }
+
+    std::string cacheKey;
+    if (m_impl->m_resultCache) {
+        // broken input is not cached, executor reports it.
+        const std::string inputHash = m_impl->HashUncompressedInput(fileData, compressionInput);
+        if (!inputHash.empty()) {
+            cacheKey                         = GetCacheKey(request, inputHash);
+            RemoteToolResponse::Ptr response = LoadCachedResponse(cacheKey);
+            {
+                std::lock_guard<std::mutex> lock(m_impl->m_infoMutex);
+                UpdateInfo();
+            }
+            if (response) {
+                callback(response);
+                return;
+            }
+        }
+    }
+
+    const auto sessionId = request.m_sessionId;
+    const auto taskKey   = RemoteToolServerImpl::TaskKey(sessionId, request.m_taskId);
+    {
+        std::lock_guard<std::mutex> lock(m_impl->m_sessionsIdsMutex);
+        m_impl->m_sessionsIds[handler] = sessionId;
+    }
+    StartTask(request.m_clientId, sessionId);
+    LocalExecutorTask::Ptr taskCC(new LocalExecutorTask());
+    taskCC->m_invocation       = request.m_invocation;
+    taskCC->m_inputData        = fileData;
+    taskCC->m_compressionInput = compressionInput;
+    taskCC->m_shareGroup       = request.m_clientId.empty() ? std::to_string(sessionId) : request.m_clientId;
+    auto weightIt              = m_config.m_clientWeights.find(request.m_clientId);
+    taskCC->m_shareWeight      = weightIt != m_config.m_clientWeights.cend() ? weightIt->second : m_config.m_defaultClientWeight;
+    auto compressionOut = taskCC->m_compressionOutput = m_config.m_useClientCompression ? request.m_compression : m_config.m_compression;
+    auto gate           = m_impl->m_callbackGate;
+    taskCC->m_callback  = [callback, this, gate, sessionId, taskKey, compressionOut, cacheKey](LocalExecutorResult::Ptr result) {
+        if (!gate->Enter())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_impl->m_activeTasksMutex);
+            m_impl->m_activeTasks.erase(taskKey);
+        }
+        FinishTask(sessionId, false);
+        if (result->m_cancelled) {
+            callback(nullptr);
+        } else {
+            RemoteToolResponse::Ptr response(new RemoteToolResponse());
+            response->m_result        = result->m_result;
+            response->m_stdOut        = result->m_stdOut;
+            response->m_fileData      = result->m_outputData;
+            response->m_compression   = compressionOut;
+            response->m_executionTime = result->m_executionTime;
+            response->m_queueTime     = result->m_queueTime;
+            if (response->m_result && !cacheKey.empty())
+                StoreCachedResponse(cacheKey, *response);
+            callback(response);
+        }
+        gate->Leave();
+    };
+    {
+        std::lock_guard<std::mutex> lock(m_impl->m_activeTasksMutex);
+        m_impl->m_activeTasks[taskKey] = taskCC;
+    }
+    m_impl->m_executor->AddTask(taskCC);
+}
+
+std::string RemoteToolServer::GetCacheKey(const RemoteToolRequest& request, const std::string& inputHash) const
+{
+    // input is hashed uncompressed, so clients with different compression settings share results.
+    const auto& toolId    = request.m_invocation.m_id.m_toolId;
+    const auto  versionIt = m_toolVersionMap.find(toolId);
+    Sha256      hash;
+    hash.UpdateField("WuildResult3");
+    hash.UpdateField(toolId);
+    hash.UpdateField(versionIt != m_toolVersionMap.cend() ? versionIt->second : std::string());
+    for (const auto& arg : request.m_invocation.m_arglist.m_args)
+        hash.UpdateField(arg);
+    hash.UpdateField(inputHash);
+    return hash.GetHexDigest();
+}
+
+RemoteToolResponse::Ptr RemoteToolServer::LoadCachedResponse(const std::string& cacheKey)
+{
+    ByteArrayHolder data;
+    if (!m_impl->m_resultCache->Get(cacheKey, data))
+        return nullptr;
+
+    RemoteToolResponse::Ptr   response(new RemoteToolResponse());
+    ByteOrderBuffer           buffer(data);
+    ByteOrderDataStreamReader stream(buffer);
+    if (response->ReadInternal(stream) != SocketFrame::stOk || buffer.EofRead()) {
+        Syslogger(Syslogger::Warning) << "Broken result cache entry " << cacheKey;
+        return nullptr;
+    }
+    // nothing was executed or queued for this request.
+    response->m_executionTime = TimePoint();
+    response->m_queueTime     = TimePoint();
+    return response;
+}
+
+void RemoteToolServer::StoreCachedResponse(const std::string& cacheKey, const RemoteToolResponse& response)
+{
+    ByteOrderBuffer           buffer;
+    ByteOrderDataStreamWriter stream(buffer);
+    response.WriteInternal(stream);
+    m_impl->m_resultCache->Put(cacheKey, ByteArrayHolder(ByteArray(buffer.begin(), buffer.end())));
+}
+
 void RemoteToolServer::StartTask(const std::string& clientId, int64_t sessionId)
 {
     std::lock_guard<std::mutex> lock(m_impl->m_infoMutex);
@@ -173,14 +590,40 @@ void RemoteToolServer::FinishTask(int64_t sessionId, bool remove)
     UpdateInfo();
 }
 
+void RemoteToolServer::UpdateThreadCount()
+{
+    // m_runningTasks counts all accepted tasks, including queued ones.
+    const size_t  queued   = m_impl->m_executor->GetQueueSize();
+    const size_t  started  = m_runningTasks;
+    const int     running  = static_cast<int>(started > queued ? started - queued : 0);
+    TimePoint     now(true);
+    const std::tm local    = now.ToLocal().GetTm();
+    const int     previous = m_impl->m_threadScaler->GetThreadCount();
+    const int     threads  = m_impl->m_threadScaler->Update(Application::GetLoadAverage(), running, local.tm_hour * 60 + local.tm_min);
+    if (threads == previous)
+        return;
+
+    Syslogger(Syslogger::Info) << "Thread count changed: " << previous << " -> " << threads;
+    m_impl->m_executor->SetThreadCount(threads);
+    std::lock_guard<std::mutex> lock(m_impl->m_infoMutex);
+    m_impl->m_info.m_totalThreads = static_cast<uint16_t>(threads);
+    UpdateInfo();
+}
+
 void RemoteToolServer::UpdateInfo()
 {
     ToolServerInfo& info = m_impl->m_info;
     if (info.m_connectedClients.empty())
         m_runningTasks = 0;
 
-    info.m_runningTasks = m_runningTasks;
-    info.m_queuedTasks  = m_impl->m_executor->GetQueueSize();
+    info.m_runningTasks         = m_runningTasks;
+    info.m_queuedTasks          = m_impl->m_executor->GetQueueSize();
+    info.m_memoryLimitedThreads = static_cast<uint16_t>(m_impl->m_executor->GetMemoryLimitedThreads());
+    if (m_impl->m_resultCache) {
+        const auto stats   = m_impl->m_resultCache->GetStats();
+        info.m_cacheHits   = static_cast<uint32_t>(stats.m_hits);
+        info.m_cacheMisses = static_cast<uint32_t>(stats.m_misses);
+    }
     m_impl->m_coordinator.SetToolServerInfo(info);
 }
 
@@ -23,6 +23,9 @@
 
 namespace Wuild {
 class RemoteToolServerImpl;
+class RemoteToolRequest;
+class RemoteToolResponse;
+class SocketFrameHandler;
 /// Listening port for incoming tool execution tasks and transforms it to LocalExecutor.
 class RemoteToolServer {
 public:
@@ -37,9 +40,16 @@ public:
     void Start();
 
 protected:
+    /// Passes request to executor; callback gets nullptr when task is cancelled.
+    void ExecuteRequest(const RemoteToolRequest& request, SocketFrameHandler* handler, std::function<void(std::shared_ptr<RemoteToolResponse>)> callback);
+    std::string                         GetCacheKey(const RemoteToolRequest& request, const std::string& inputHash) const;
+    std::shared_ptr<RemoteToolResponse> LoadCachedResponse(const std::string& cacheKey);
+    void                                StoreCachedResponse(const std::string& cacheKey, const RemoteToolResponse& response);
+
     void StartTask(const std::string& clientId, int64_t sessionId);
     void FinishTask(int64_t sessionId, bool remove);
     void UpdateInfo();
+    void UpdateThreadCount();
 
     std::unique_ptr<RemoteToolServerImpl> m_impl;
     std::atomic<uint16_t>                 m_runningTasks{ 0 };
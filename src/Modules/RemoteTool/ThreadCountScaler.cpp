@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+
+#include "ThreadCountScaler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Wuild {
+
+ThreadCountScaler::ThreadCountScaler(const RemoteToolServerConfig& config, int cpuCount)
+    : m_config(config)
+    , m_cpuCount(std::max(cpuCount, 1))
+    , m_threadCount(config.m_threadCount)
+{
+}
+
+bool ThreadCountScaler::IsEnabled() const
+{
+    return m_config.m_minThreadCount > 0 || !m_config.m_threadSchedule.empty();
+}
+
+int ThreadCountScaler::Update(double loadAverage, int ownRunningTasks, int minuteOfDay)
+{
+    const int maxThreads = GetMaxThreadCount(minuteOfDay);
+    int       target     = maxThreads;
+    if (m_config.m_minThreadCount > 0 && loadAverage >= 0) {
+        const double foreignLoad = std::max(loadAverage - ownRunningTasks, 0.);
+        const int    freeCpus    = m_cpuCount - static_cast<int>(std::lround(foreignLoad));
+        target                   = std::clamp(freeCpus, std::min(m_config.m_minThreadCount, maxThreads), maxThreads);
+    }
+    if (target > m_threadCount)
+        target = std::min(target, m_threadCount + std::max(1, m_threadCount / 4));
+
+    m_threadCount = target;
+    return m_threadCount;
+}
+
+int ThreadCountScaler::GetMaxThreadCount(int minuteOfDay) const
+{
+    for (const auto& schedule : m_config.m_threadSchedule) {
+        const bool inRange = schedule.m_fromMinute <= schedule.m_toMinute
+                                 ? (minuteOfDay >= schedule.m_fromMinute && minuteOfDay < schedule.m_toMinute)
+                                 : (minuteOfDay >= schedule.m_fromMinute || minuteOfDay < schedule.m_toMinute);
+        if (inRange)
+            return schedule.m_threadCount;
+    }
+    return m_config.m_threadCount;
+}
+
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+
+#pragma once
+
+#include <RemoteToolServerConfig.h>
+
+namespace Wuild {
+/// Calculates tool server thread count for machines which are shared with other work (e.g. developer workstations).
+///
+/// Upper bound is threadCount, or thread count of schedule entry for current time of day.
+/// When minThreadCount is set, CPUs busy with other processes (load average minus own tasks) are left to them,
+/// but thread count does not go below minThreadCount. Decrease is applied at once; increase is gradual,
+/// as load average lags behind and own finished tasks may look like foreign load for a while.
+class ThreadCountScaler {
+public:
+    ThreadCountScaler(const RemoteToolServerConfig& config, int cpuCount);
+
+    /// False if thread count is always threadCount.
+    bool IsEnabled() const;
+
+    /// Recalculates thread count. loadAverage < 0 means unknown; then only schedule is applied.
+    int Update(double loadAverage, int ownRunningTasks, int minuteOfDay);
+
+    int GetThreadCount() const { return m_threadCount; }
+
+private:
+    int GetMaxThreadCount(int minuteOfDay) const;
+
+    const RemoteToolServerConfig m_config;
+    const int                    m_cpuCount;
+    int                          m_threadCount;
+};
+
+}
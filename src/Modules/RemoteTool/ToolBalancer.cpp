@@ -20,6 +20,11 @@
 
 namespace Wuild {
 
+namespace {
+const uint32_t g_maxOutputBytesPending = 8 * 1024 * 1024; //!< Server can't send results faster than that.
+const double   g_decreaseFactor        = 0.75;
+}
+
 ToolBalancer::ToolBalancer() = default;
 
 ToolBalancer::~ToolBalancer() = default;
@@ -34,6 +39,17 @@ void ToolBalancer::SetSessionId(int64_t sessionId)
     m_sessionId = sessionId;
 }
 
+void ToolBalancer::SetMaxPrefetch(uint16_t maxPrefetch)
+{
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    m_maxPrefetch = maxPrefetch;
+    for (ClientInfo& client : m_clients) {
+        client.UpdatePrefetch(m_maxPrefetch);
+        client.UpdateLoad(m_sessionId);
+    }
+    RecalcAvailable();
+}
+
 ToolBalancer::ClientStatus ToolBalancer::UpdateClient(const ToolServerInfo& toolServer, size_t& index)
 {
     if (!m_requiredToolIds.empty() && !toolServer.m_toolIds.empty()) {
@@ -90,13 +106,13 @@ void ToolBalancer::SetClientCompatible(size_t index, bool isCompatible)
     RecalcAvailable();
 }
 
-void ToolBalancer::SetServerSideLoad(size_t index, uint16_t load)
+void ToolBalancer::SetServerSideLoad(size_t index, const ServerSideLoad& load)
 {
     std::lock_guard<std::mutex> lock(m_clientsMutex);
     ClientInfo&                 info = m_clients[index];
-    info.m_serverSideQueuePrev       = info.m_serverSideQueue;
-    info.m_serverSideQueue           = load;
-    info.m_serverSideQueueAvg        = (info.m_serverSideQueue + info.m_serverSideQueuePrev) / 2;
+    info.m_serverSideLoad            = load;
+    info.m_hasServerSideLoad         = true;
+    info.UpdateInflightLimit();
     info.UpdateLoad(m_sessionId);
     RecalcAvailable();
 }
@@ -144,6 +160,41 @@ void ToolBalancer::FinishTask(size_t index)
     RecalcAvailable();
 }
 
+void ToolBalancer::UpdateTaskTimings(size_t index, const TimePoint& transferTime, const TimePoint& executionTime)
+{
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    ClientInfo&                 info = m_clients[index];
+    // exponential moving average, 1/8 weight for new sample.
+    auto average = [](TimePoint& avg, const TimePoint& sample) {
+        const int64_t sampleUS = std::max(sample.GetUS(), int64_t(0));
+        avg.SetUS(avg ? (avg.GetUS() * 7 + sampleUS) / 8 : sampleUS);
+    };
+    average(info.m_avgTransferTime, transferTime);
+    average(info.m_avgExecutionTime, executionTime);
+    info.UpdatePrefetch(m_maxPrefetch);
+    info.UpdateLoad(m_sessionId);
+    RecalcAvailable();
+}
+
+uint16_t ToolBalancer::GetFreeThreads(size_t index) const
+{
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    const ClientInfo&           client = m_clients[index];
+    if (!client.m_active || !client.m_compatible)
+        return 0;
+    return client.GetCapacity() - client.m_busyTotal;
+}
+
+size_t ToolBalancer::GetExecutionWaves(size_t index, size_t tasks) const
+{
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    const ClientInfo&           client  = m_clients[index];
+    const uint16_t              limited = std::min(client.m_toolServer.m_memoryLimitedThreads, client.m_toolServer.m_totalThreads);
+    const size_t                threads = std::max(client.m_toolServer.m_totalThreads - limited, 1);
+    const size_t                queued  = client.m_hasServerSideLoad ? client.m_serverSideLoad.m_queuedTasks : 0;
+    return std::max<size_t>((tasks + queued + threads - 1) / threads, 1);
+}
+
 bool ToolBalancer::IsAllChecked() const
 {
     std::lock_guard<std::mutex> lock(m_clientsMutex);
@@ -161,13 +212,29 @@ std::vector<uint16_t> ToolBalancer::TestGetBusy() const
     return result;
 }
 
+std::vector<uint16_t> ToolBalancer::TestGetPrefetch() const
+{
+    std::vector<uint16_t> result;
+    for (const ClientInfo& client : m_clients)
+        result.push_back(client.m_prefetch);
+    return result;
+}
+
+std::vector<uint16_t> ToolBalancer::TestGetInflightLimit() const
+{
+    std::vector<uint16_t> result;
+    for (const ClientInfo& client : m_clients)
+        result.push_back(static_cast<uint16_t>(client.m_inflightLimit));
+    return result;
+}
+
 void ToolBalancer::RecalcAvailable()
 {
     uint16_t free = 0, used = 0, total = 0;
     for (const ClientInfo& client : m_clients) {
         if (client.m_active && client.m_compatible) {
             total += client.m_toolServer.m_totalThreads;
-            free += client.m_toolServer.m_totalThreads - client.m_busyTotal;
+            free += client.GetCapacity() - client.m_busyTotal;
             used += client.m_busyMine;
         }
     }
@@ -179,27 +246,79 @@ void ToolBalancer::RecalcAvailable()
 void ToolBalancer::ClientInfo::UpdateLoad(int64_t mySessionId)
 {
     m_busyOthers = 0;
-    for (const ToolServerInfo::ConnectedClientInfo& client : m_toolServer.m_connectedClients) {
-        if (client.m_sessionId && client.m_sessionId != mySessionId)
-            m_busyOthers += client.m_usedThreads;
+    if (m_hasServerSideLoad) {
+        // server status is much fresher than coordinator info.
+        const int serverTasks = m_serverSideLoad.m_queuedTasks + m_serverSideLoad.m_runningTasks;
+        m_busyOthers          = static_cast<uint16_t>(std::max(serverTasks - int(m_busyMine), 0));
+    } else {
+        for (const ToolServerInfo::ConnectedClientInfo& client : m_toolServer.m_connectedClients) {
+            if (client.m_sessionId && client.m_sessionId != mySessionId)
+                m_busyOthers += client.m_usedThreads;
+        }
     }
     if (m_busyOthers > 0)
         m_busyOthers--; // reduce other's load for more greedy behaviour.
 
-    if (m_serverSideQueueAvg >= m_busyMine - 1) {
-        // if server has large queue, lower free threads.
-        m_busyByNetworkLoad++;
-        m_busyByNetworkLoad = std::min(m_busyByNetworkLoad, m_toolServer.m_totalThreads);
-    }
-    if (m_serverSideQueueAvg == 0 && m_busyByNetworkLoad) {
-        // if server has empty queue, remove penalty
-        m_busyByNetworkLoad--;
+    // withhold threads so my free threads on server never exceed in-flight limit.
+    m_busyByNetworkLoad = 0;
+    if (m_inflightLimit > 0) {
+        const int withheld  = GetCapacity() - m_busyOthers - static_cast<int>(m_inflightLimit);
+        m_busyByNetworkLoad = static_cast<uint16_t>(std::max(withheld, 0));
     }
 
     m_busyTotal = m_busyOthers + m_busyMine + m_busyByNetworkLoad;
-    m_busyTotal = std::min(m_busyTotal, m_toolServer.m_totalThreads);
+    m_busyTotal = std::min(m_busyTotal, GetCapacity());
 
     m_clientLoad = m_toolServer.m_totalThreads ? (m_busyTotal * m_eachTaskWeight / m_toolServer.m_totalThreads) : 0;
 }
 
+uint16_t ToolBalancer::ClientInfo::GetCapacity() const
+{
+    // server which is short of memory won't start more tasks, so don't queue them there.
+    const uint16_t limited = std::min(m_toolServer.m_memoryLimitedThreads, m_toolServer.m_totalThreads);
+    if (limited)
+        return m_toolServer.m_totalThreads - limited;
+    return m_toolServer.m_totalThreads + m_prefetch;
+}
+
+void ToolBalancer::ClientInfo::UpdatePrefetch(uint16_t maxPrefetch)
+{
+    // While server compiles one task (avgExecution), each of its threads needs the next input
+    // to arrive; that takes avgTransfer, so we need threads * transfer / execution tasks in advance.
+    const int64_t executionUS = m_avgExecutionTime.GetUS();
+    if (!maxPrefetch || executionUS <= 0) {
+        m_prefetch = 0;
+        return;
+    }
+    const int64_t needed = (m_toolServer.m_totalThreads * m_avgTransferTime.GetUS() + executionUS - 1) / executionUS;
+    m_prefetch           = static_cast<uint16_t>(std::clamp<int64_t>(needed, 0, maxPrefetch));
+}
+
+void ToolBalancer::ClientInfo::UpdateInflightLimit()
+{
+    const int threads  = m_toolServer.m_totalThreads;
+    const int capacity = GetCapacity();
+    if (!threads)
+        return;
+
+    // Server is congested when it has more than a whole round of tasks waiting (except prefetch we expect),
+    // or it can't send results back fast enough.
+    const bool congested = m_serverSideLoad.m_queuedTasks > std::max(threads, int(m_prefetch))
+                           || m_serverSideLoad.m_outputBytesPending > g_maxOutputBytesPending
+                           || m_serverSideLoad.m_repliesQueued > threads / 2 + 1;
+    if (congested) {
+        // previous decrease is not in effect yet - wait for my excessive tasks to drain.
+        if (m_inflightLimit > 0 && m_busyMine > m_inflightLimit)
+            return;
+        const double current    = m_inflightLimit > 0 ? m_inflightLimit : std::max(1, int(m_busyMine));
+        m_inflightLimit = std::max(1.0, current * g_decreaseFactor);
+        return;
+    }
+    if (m_inflightLimit > 0 && m_busyMine + 1 >= m_inflightLimit) {
+        m_inflightLimit += std::max(1, threads / 8);
+        if (m_inflightLimit >= capacity)
+            m_inflightLimit = 0; // limit is not needed anymore.
+    }
+}
+
 }
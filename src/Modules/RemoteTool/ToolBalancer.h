@@ -27,6 +27,10 @@ namespace Wuild {
  *
  * To recieve balancer most suitable client, call FindFreeClient.
  * StartTask and FinishTask updates load cache.
+ * UpdateTaskTimings feeds measured transfer and compilation times, so each server
+ * could get some tasks queued beyond its thread count (prefetch), and never idle waiting for input.
+ * SetServerSideLoad feeds server backpressure; in-flight limit per server is adjusted by AIMD:
+ * multiplicative decrease when server is congested, additive increase while limit is fully used.
  * Get*Threads funcation used for overall statistics.
  */
 class ToolBalancer {
@@ -38,47 +42,69 @@ public:
         Updated
     };
 
+    /// Server-side backpressure, recieved with connection status.
+    struct ServerSideLoad {
+        uint16_t m_repliesQueued      = 0;
+        uint32_t m_outputBytesPending = 0;
+        uint16_t m_queuedTasks        = 0;
+        uint16_t m_runningTasks       = 0;
+    };
+
 public:
     ToolBalancer();
     ~ToolBalancer();
 
     void SetRequiredTools(const StringVector& requiredToolIds);
     void SetSessionId(int64_t sessionId);
+    void SetMaxPrefetch(uint16_t maxPrefetch);
 
     ClientStatus UpdateClient(const ToolServerInfo& toolServer, size_t& index);
     void         SetClientActive(size_t index, bool isActive);
     void         SetClientCompatible(size_t index, bool isCompatible);
-    void         SetServerSideLoad(size_t index, uint16_t load);
+    void         SetServerSideLoad(size_t index, const ServerSideLoad& load);
 
     size_t FindFreeClient(const std::string& toolId) const;
     void   StartTask(size_t index);
     void   FinishTask(size_t index);
+    void   UpdateTaskTimings(size_t index, const TimePoint& transferTime, const TimePoint& executionTime);
 
     uint16_t GetTotalThreads() const { return m_totalRemoteThreads; }
     uint16_t GetFreeThreads() const { return m_freeRemoteThreads; }
     uint16_t GetUsedThreads() const { return m_usedThreads; }
+    uint16_t GetFreeThreads(size_t index) const;
+
+    /// How many task durations it takes server to run given tasks after ones already queued there.
+    size_t GetExecutionWaves(size_t index, size_t tasks) const;
 
     bool IsAllChecked() const;
 
     /// Used for tests.
     std::vector<uint16_t> TestGetBusy() const;
+    std::vector<uint16_t> TestGetPrefetch() const;
+    std::vector<uint16_t> TestGetInflightLimit() const;
 
 protected:
     struct ClientInfo {
         ToolServerInfo m_toolServer;
-        bool           m_checked             = false;
-        bool           m_active              = false;
-        bool           m_compatible          = false;
-        uint16_t       m_serverSideQueue     = 0;
-        uint16_t       m_serverSideQueuePrev = 0;
-        uint16_t       m_serverSideQueueAvg  = 0;
-        uint16_t       m_busyMine            = 0;
-        uint16_t       m_busyOthers          = 0;
-        uint16_t       m_busyTotal           = 0;
-        uint16_t       m_busyByNetworkLoad   = 0;
-        int64_t        m_clientLoad          = 0;
-        int            m_eachTaskWeight      = 32768; //TODO: priority? configaration?
+        bool           m_checked           = false;
+        bool           m_active            = false;
+        bool           m_compatible        = false;
+        ServerSideLoad m_serverSideLoad;
+        bool           m_hasServerSideLoad = false;
+        double         m_inflightLimit     = 0; //!< AIMD limit for my tasks on server; 0 = not limited.
+        uint16_t       m_busyMine          = 0;
+        uint16_t       m_busyOthers        = 0;
+        uint16_t       m_busyTotal         = 0;
+        uint16_t       m_busyByNetworkLoad = 0; //!< Threads withheld by in-flight limit
+        uint16_t       m_prefetch          = 0; //!< Tasks allowed to be queued beyond m_totalThreads
+        TimePoint      m_avgTransferTime;         //!< Round-trip minus server-side time
+        TimePoint      m_avgExecutionTime;
+        int64_t        m_clientLoad        = 0;
+        int            m_eachTaskWeight    = 32768; //TODO: priority? configaration?
         void           UpdateLoad(int64_t mySessionId);
+        void           UpdatePrefetch(uint16_t maxPrefetch);
+        void           UpdateInflightLimit();
+        uint16_t       GetCapacity() const;
     };
 
 protected:
@@ -88,7 +114,8 @@ protected:
     std::atomic<uint16_t> m_freeRemoteThreads{ 0 };
     std::atomic<uint16_t> m_usedThreads{ 0 };
 
-    int64_t m_sessionId = 0;
+    int64_t  m_sessionId   = 0;
+    uint16_t m_maxPrefetch = 0;
 
     std::deque<ClientInfo> m_clients;
     StringVector           m_requiredToolIds;
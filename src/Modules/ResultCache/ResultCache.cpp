@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "ResultCache.h"
+
+#include <FileUtils.h>
+#include <Syslogger.h>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "MernelPlatform/FsUtils.hpp"
+
+namespace Wuild {
+
+ResultCache::ResultCache(std::string dir, int64_t maxSize)
+    : m_dir(std::move(dir))
+    , m_maxSize(maxSize)
+{
+    FileInfo(m_dir).Mkdirs();
+
+    // entries are stored in subdirs by first two key chars.
+    std::vector<std::tuple<Mernel::std_fs::file_time_type, std::string, int64_t>> existing;
+    std::error_code                                                                code;
+    for (auto it = Mernel::std_fs::recursive_directory_iterator(Mernel::string2path(m_dir), code); !code && it != Mernel::std_fs::recursive_directory_iterator(); it.increment(code)) {
+        if (!it->is_regular_file(code))
+            continue;
+        const std::string name = Mernel::path2string(it->path().filename());
+        if (name.size() <= 2 || name.find('.') != std::string::npos) {
+            Mernel::std_fs::remove(it->path(), code); // unfinished write.
+            continue;
+        }
+        existing.emplace_back(it->last_write_time(code), name, static_cast<int64_t>(it->file_size(code)));
+    }
+    std::sort(existing.begin(), existing.end(), [](const auto& l, const auto& r) { return std::get<0>(l) > std::get<0>(r); });
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& item : existing) {
+        m_recent.push_back(std::get<1>(item));
+        m_entries[std::get<1>(item)] = Entry{ std::get<2>(item), std::prev(m_recent.end()) };
+        m_stats.m_size += std::get<2>(item);
+    }
+    m_stats.m_entries = m_entries.size();
+    Evict();
+    Syslogger(Syslogger::Info) << "Result cache " << m_dir << ": " << m_stats.m_entries << " entries, " << m_stats.m_size / (1024 * 1024) << " MiB";
+}
+
+bool ResultCache::Get(const std::string& key, ByteArrayHolder& data)
+{
+    if (!Lookup(key))
+        return false;
+
+    const bool found = FileInfo(GetEntryPath(key)).ReadFile(data) && data.size();
+    FinishLookup(key, found);
+    return found;
+}
+
+bool ResultCache::Materialize(const std::string& key, const std::string& destination)
+{
+    if (!Lookup(key))
+        return false;
+
+    const bool found = FileInfo(GetEntryPath(key)).CopyTo(destination);
+    FinishLookup(key, found);
+    return found;
+}
+
+void ResultCache::Put(const std::string& key, const ByteArrayHolder& data)
+{
+    if (!StartPut(key))
+        return;
+
+    // temp copy and rename: entry may be read by other thread as soon as it appears.
+    const bool written = FileInfo(GetEntryPath(key)).WriteFile(data, true);
+    FinishPut(key, written ? static_cast<int64_t>(data.size()) : -1);
+}
+
+void ResultCache::PutFile(const std::string& key, const std::string& source)
+{
+    if (!StartPut(key))
+        return;
+
+    const std::string entryPath = GetEntryPath(key);
+    const std::string tmpPath   = entryPath + ".tmp";
+    std::error_code   code;
+    int64_t           size = -1;
+    if (FileInfo(source).CopyTo(tmpPath)) {
+        Mernel::std_fs::rename(Mernel::string2path(tmpPath), Mernel::string2path(entryPath), code);
+        if (!code)
+            size = static_cast<int64_t>(FileInfo(entryPath).GetFileSize());
+        else
+            FileInfo(tmpPath).Remove();
+    }
+    FinishPut(key, size);
+}
+
+ResultCache::Stats ResultCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+std::string ResultCache::GetEntryPath(const std::string& key) const
+{
+    return m_dir + "/" + key.substr(0, 2) + "/" + key;
+}
+
+bool ResultCache::Lookup(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto                        it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        m_stats.m_misses++;
+        return false;
+    }
+    m_recent.splice(m_recent.begin(), m_recent, it->second.m_recent);
+    return true;
+}
+
+void ResultCache::FinishLookup(const std::string& key, bool found)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (found) {
+        m_stats.m_hits++;
+        return;
+    }
+
+    // removed by someone else.
+    m_stats.m_misses++;
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_stats.m_size -= it->second.m_size;
+        m_recent.erase(it->second.m_recent);
+        m_entries.erase(it);
+        m_stats.m_entries = m_entries.size();
+    }
+}
+
+bool ResultCache::StartPut(const std::string& key)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_entries.count(key) || !m_writing.insert(key).second)
+            return false;
+    }
+    FileInfo(FileInfo(GetEntryPath(key)).GetDir()).Mkdirs();
+    return true;
+}
+
+void ResultCache::FinishPut(const std::string& key, int64_t size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_writing.erase(key);
+    if (size < 0)
+        return;
+    m_recent.push_front(key);
+    m_entries[key] = Entry{ size, m_recent.begin() };
+    m_stats.m_size += size;
+    m_stats.m_entries = m_entries.size();
+    Evict();
+}
+
+void ResultCache::Evict()
+{
+    while (m_stats.m_size > m_maxSize && !m_recent.empty()) {
+        const std::string key = m_recent.back();
+        auto              it  = m_entries.find(key);
+        m_stats.m_size -= it->second.m_size;
+        m_entries.erase(it);
+        m_recent.pop_back();
+        FileInfo(GetEntryPath(key)).Remove();
+    }
+    m_stats.m_entries = m_entries.size();
+}
+
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+#include <CommonTypes.h>
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace Wuild {
+/**
+ * Content-addressed store of tool results on disk, bounded by total size.
+ *
+ * Each entry is a file named by its key (usually SHA-256 hex digest of everything which affects result).
+ * Least recently used entries are evicted when size limit is exceeded. Recency is not stored on disk,
+ * so after restart entries are ordered by their creation time.
+ */
+class ResultCache {
+public:
+    struct Stats {
+        uint64_t m_hits    = 0;
+        uint64_t m_misses  = 0;
+        size_t   m_entries = 0;
+        int64_t  m_size    = 0; //!< Bytes on disk
+    };
+
+public:
+    /// Loads existing entries from dir; maxSize is in bytes.
+    ResultCache(std::string dir, int64_t maxSize);
+
+    bool Get(const std::string& key, ByteArrayHolder& data);
+
+    /// Copies entry to destination file; see FileInfo::CopyTo.
+    bool Materialize(const std::string& key, const std::string& destination);
+
+    /// Does nothing if key already exists.
+    void Put(const std::string& key, const ByteArrayHolder& data);
+
+    /// Same as Put, but data is copied from existing file.
+    void PutFile(const std::string& key, const std::string& source);
+
+    Stats GetStats() const;
+
+private:
+    std::string GetEntryPath(const std::string& key) const;
+    bool        Lookup(const std::string& key);
+    void        FinishLookup(const std::string& key, bool found);
+    bool        StartPut(const std::string& key);
+    void        FinishPut(const std::string& key, int64_t size); //!< size < 0 = write failed
+    void        Evict();                                         //!< Called under m_mutex
+
+    struct Entry {
+        int64_t                          m_size = 0;
+        std::list<std::string>::iterator m_recent;
+    };
+
+    const std::string            m_dir;
+    const int64_t                m_maxSize;
+    mutable std::mutex           m_mutex;
+    std::map<std::string, Entry> m_entries;
+    std::list<std::string>       m_recent;  //!< Keys, most recently used first
+    std::set<std::string>        m_writing; //!< Keys being written by Put
+    Stats                        m_stats;
+};
+
+}
@@ -18,8 +18,11 @@
 #include "TcpSocket.h"
 #include "FileUtils.h"
 
+#include <algorithm>
 #include <csignal>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <sys/stat.h>
 
 #ifndef _WIN32
@@ -159,6 +162,47 @@ std::string Application::GetTempDir(bool autoCreate) const
     return dirName;
 }
 
+int64_t Application::GetAvailableMemory()
+{
+#ifdef __linux__
+    std::ifstream meminfo("/proc/meminfo");
+    std::string   line;
+    int64_t       available = -1;
+    while (std::getline(meminfo, line)) {
+        // "MemAvailable:   12345678 kB"
+        if (line.compare(0, 13, "MemAvailable:") == 0) {
+            available = std::atoll(line.c_str() + 13) * 1024;
+            break;
+        }
+    }
+    // container limit: memory.max is "max" when not limited; inactive page cache is reclaimed before hitting it.
+    std::ifstream cgroupMax("/sys/fs/cgroup/memory.max"), cgroupCurrent("/sys/fs/cgroup/memory.current");
+    int64_t       limit = 0, current = 0;
+    if (available >= 0 && (cgroupMax >> limit) && (cgroupCurrent >> current)) {
+        std::ifstream cgroupStat("/sys/fs/cgroup/memory.stat");
+        while (std::getline(cgroupStat, line)) {
+            if (line.compare(0, 14, "inactive_file ") == 0) {
+                current -= std::atoll(line.c_str() + 14);
+                break;
+            }
+        }
+        available = std::min(available, std::max<int64_t>(limit - current, 0));
+    }
+    return available;
+#endif
+    return -1;
+}
+
+double Application::GetLoadAverage()
+{
+#ifndef _WIN32
+    double load = 0.;
+    if (getloadavg(&load, 1) == 1)
+        return load;
+#endif
+    return -1.;
+}
+
 std::string Application::GetAppDataDir(bool autoCreate)
 {
     std::string orgPrefix = ".";
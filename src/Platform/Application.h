@@ -17,6 +17,7 @@
 #include <map>
 #include <vector>
 #include <atomic>
+#include <cstdint>
 
 namespace Wuild {
 /// Class provides some environment checking and signals handling .
@@ -59,6 +60,13 @@ public:
     /// Return user home directory
     std::string GetHomeDir() const { return m_homeDir; }
 
+    /// Memory available for new allocations without swapping, in bytes; cgroup v2 limit of process is taken into account.
+    /// Returns -1 if unknown (non-Linux).
+    static int64_t GetAvailableMemory();
+
+    /// System load average over last minute (runnable processes). Returns -1 if unknown (Windows).
+    static double GetLoadAverage();
+
     /// Return application data folder. %LOCALAPPDATA%/organization on windows, ~/.organization on Unix.
     std::string GetAppDataDir(bool autoCreate = true);
 
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "ChunkedCompression.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace Wuild {
+
+namespace {
+const uint8_t g_magic[4]  = { 'W', 'Z', 'C', '1' };
+const size_t  g_headerSize = sizeof(g_magic) + sizeof(uint32_t);
+
+ThreadPool& GetPool()
+{
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u));
+    return pool;
+}
+
+void WriteUint32(ByteArray& data, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        data.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+uint32_t ReadUint32(const uint8_t* data)
+{
+    return uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24;
+}
+
+struct ChunkIndex {
+    size_t m_size           = 0;
+    size_t m_compressedSize = 0;
+    size_t m_offset         = 0;
+};
+
+/// Empty if data is not a container.
+std::vector<ChunkIndex> ReadIndex(const ByteArrayHolder& data)
+{
+    if (data.size() < g_headerSize || memcmp(data.data(), g_magic, sizeof(g_magic)) != 0)
+        return {};
+    const size_t count  = ReadUint32(data.data() + sizeof(g_magic));
+    size_t       offset = g_headerSize + count * 2 * sizeof(uint32_t);
+    if (count < 2 || offset > data.size())
+        return {};
+
+    std::vector<ChunkIndex> index(count);
+    const uint8_t*          entry = data.data() + g_headerSize;
+    for (auto& chunk : index) {
+        chunk.m_size           = ReadUint32(entry);
+        chunk.m_compressedSize = ReadUint32(entry + sizeof(uint32_t));
+        chunk.m_offset         = offset;
+        offset += chunk.m_compressedSize;
+        entry += 2 * sizeof(uint32_t);
+        if (offset > data.size())
+            return {};
+    }
+    if (offset != data.size())
+        return {};
+    return index;
+}
+
+/// Results of jobs on pool, taken in order of submission.
+struct ChunkResults {
+    std::mutex                   m_mutex;
+    std::condition_variable      m_cond;
+    std::vector<ByteArrayHolder> m_results;
+    std::vector<bool>            m_done;
+    std::string                  m_error;
+
+    size_t Add()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_results.emplace_back();
+        m_done.push_back(false);
+        return m_results.size() - 1;
+    }
+
+    void Set(size_t index, const ByteArrayHolder& result, const std::string& error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_results[index] = result;
+            m_done[index]    = true;
+            if (m_error.empty())
+                m_error = error;
+        }
+        m_cond.notify_all();
+    }
+
+    /// Throws if any job failed.
+    ByteArrayHolder Take(size_t index)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this, index] { return m_done[index]; });
+        if (!m_error.empty())
+            throw std::runtime_error(m_error);
+        ByteArrayHolder result = m_results[index];
+        m_results[index]       = ByteArrayHolder();
+        return result;
+    }
+};
+}
+
+struct ChunkedCompression::Compressor::State : public ChunkResults {
+    std::vector<uint32_t> m_sizes;
+};
+
+ChunkedCompression::Compressor::Compressor(Mernel::CompressionInfo compressionInfo)
+    : m_compressionInfo(compressionInfo)
+    , m_state(std::make_shared<State>())
+{
+}
+
+void ChunkedCompression::Compressor::Add(const uint8_t* data, size_t size)
+{
+    while (size) {
+        // full chunk is submitted only when there is more data, so data of one chunk is never put in container.
+        if (m_pending.size() == s_chunkSize && m_compressionInfo.m_type != Mernel::CompressionType::None)
+            Submit();
+        const size_t part = m_compressionInfo.m_type == Mernel::CompressionType::None ? size : std::min(size, s_chunkSize - m_pending.size());
+        m_pending.insert(m_pending.end(), data, data + part);
+        data += part;
+        size -= part;
+    }
+}
+
+void ChunkedCompression::Compressor::Finish(ByteArrayHolder& output)
+{
+    if (m_state->m_sizes.empty()) {
+        ByteArrayHolder input(std::move(m_pending));
+        if (m_compressionInfo.m_type == Mernel::CompressionType::None)
+            output = input;
+        else
+            Mernel::compressDataBuffer(input, output, m_compressionInfo);
+        return;
+    }
+    if (!m_pending.empty())
+        Submit();
+
+    const size_t count = m_state->m_sizes.size();
+    ByteArray    result(g_magic, g_magic + sizeof(g_magic));
+    WriteUint32(result, static_cast<uint32_t>(count));
+    std::vector<ByteArrayHolder> chunks;
+    for (size_t i = 0; i < count; ++i) {
+        chunks.push_back(m_state->Take(i));
+        WriteUint32(result, m_state->m_sizes[i]);
+        WriteUint32(result, static_cast<uint32_t>(chunks.back().size()));
+    }
+    for (const auto& chunk : chunks)
+        result.insert(result.end(), chunk.ref().cbegin(), chunk.ref().cend());
+    output = ByteArrayHolder(std::move(result));
+}
+
+void ChunkedCompression::Compressor::Submit()
+{
+    ByteArrayHolder input(std::move(m_pending));
+    m_pending.clear();
+    m_state->m_sizes.push_back(static_cast<uint32_t>(input.size()));
+    const size_t index = m_state->Add();
+    GetPool().Enqueue([state = m_state, index, input, compressionInfo = m_compressionInfo] {
+        ByteArrayHolder compressed;
+        std::string     error;
+        try {
+            Mernel::compressDataBuffer(input, compressed, compressionInfo);
+        }
+        catch (std::exception& e) {
+            error = e.what();
+        }
+        state->Set(index, compressed, error);
+    });
+}
+
+void ChunkedCompression::Compress(const ByteArrayHolder& input, ByteArrayHolder& output, Mernel::CompressionInfo compressionInfo)
+{
+    if (input.size() <= s_chunkSize || compressionInfo.m_type == Mernel::CompressionType::None) {
+        Mernel::compressDataBuffer(input, output, compressionInfo);
+        return;
+    }
+    Compressor compressor(compressionInfo);
+    compressor.Add(input.data(), input.size());
+    compressor.Finish(output);
+}
+
+void ChunkedCompression::Uncompress(const ByteArrayHolder& input, ByteArrayHolder& output, Mernel::CompressionInfo compressionInfo)
+{
+    if (compressionInfo.m_type == Mernel::CompressionType::None || !IsChunked(input)) {
+        Mernel::uncompressDataBuffer(input, output, compressionInfo);
+        return;
+    }
+    ByteArray result;
+    Uncompress(input, compressionInfo, [&result](const ByteArrayHolder& chunk) {
+        result.insert(result.end(), chunk.ref().cbegin(), chunk.ref().cend());
+    });
+    output = ByteArrayHolder(std::move(result));
+}
+
+void ChunkedCompression::Uncompress(const ByteArrayHolder& input, Mernel::CompressionInfo compressionInfo, const ChunkConsumer& consumer)
+{
+    const auto index = compressionInfo.m_type == Mernel::CompressionType::None ? std::vector<ChunkIndex>() : ReadIndex(input);
+    if (index.empty()) {
+        ByteArrayHolder output;
+        Mernel::uncompressDataBuffer(input, output, compressionInfo);
+        consumer(output);
+        return;
+    }
+
+    // few chunks ahead of consumer are decompressed, so uncompressed data is not kept all at once.
+    auto         results = std::make_shared<ChunkResults>();
+    const size_t window  = GetPool().GetThreadCount() * 2;
+    auto         submit  = [&input, &index, &results, compressionInfo](size_t i) {
+        results->Add();
+        const ChunkIndex chunk = index[i];
+        ByteArrayHolder  compressed(ByteArray(input.data() + chunk.m_offset, input.data() + chunk.m_offset + chunk.m_compressedSize));
+        GetPool().Enqueue([results, i, chunk, compressed, compressionInfo] {
+            ByteArrayHolder uncompressed;
+            std::string     error;
+            try {
+                Mernel::uncompressDataBuffer(compressed, uncompressed, compressionInfo);
+                if (uncompressed.size() != chunk.m_size)
+                    error = "Chunk size mismatch";
+            }
+            catch (std::exception& e) {
+                error = e.what();
+            }
+            results->Set(i, uncompressed, error);
+        });
+    };
+    size_t next = 0;
+    for (; next < index.size() && next < window; ++next)
+        submit(next);
+    for (size_t i = 0; i < index.size(); ++i) {
+        ByteArrayHolder chunk = results->Take(i);
+        if (next < index.size())
+            submit(next++);
+        consumer(chunk);
+    }
+}
+
+bool ChunkedCompression::IsChunked(const ByteArrayHolder& data)
+{
+    return !ReadIndex(data).empty();
+}
+
+}
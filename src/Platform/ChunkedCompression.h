@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+#include "CommonTypes.h"
+#include "MernelPlatform/Compression.hpp"
+
+#include <functional>
+#include <memory>
+
+namespace Wuild {
+
+/// Compression of big buffers by independent chunks, on shared thread pool.
+///
+/// Data bigger than s_chunkSize is stored as container: "WZC1", chunk count, then uncompressed and compressed size
+/// of each chunk (all uint32 little endian), then chunks compressed with Mernel functions. Smaller data is compressed
+/// as one buffer, same as before, so container is used only when there are at least two chunks to work on in parallel.
+/// Both forms are read by Uncompress; CompressionType::None data is never put in container.
+/// All functions throw std::runtime_error on failure, same as Mernel compression functions.
+class ChunkedCompression {
+public:
+    static const size_t s_chunkSize = 4 * 1024 * 1024;
+
+    using ChunkConsumer = std::function<void(const ByteArrayHolder& chunk)>;
+
+    /// Streaming compression: chunk is compressed on pool as soon as it is filled, while next data is added.
+    class Compressor {
+    public:
+        explicit Compressor(Mernel::CompressionInfo compressionInfo);
+
+        void Add(const uint8_t* data, size_t size);
+        void Finish(ByteArrayHolder& output);
+
+    private:
+        struct State;
+        void Submit();
+
+        Mernel::CompressionInfo m_compressionInfo;
+        ByteArray               m_pending;
+        std::shared_ptr<State>  m_state;
+    };
+
+public:
+    static void Compress(const ByteArrayHolder& input, ByteArrayHolder& output, Mernel::CompressionInfo compressionInfo);
+    static void Uncompress(const ByteArrayHolder& input, ByteArrayHolder& output, Mernel::CompressionInfo compressionInfo);
+
+    /// Streaming decompression: consumer gets uncompressed chunks in order, next ones are decompressed meanwhile.
+    static void Uncompress(const ByteArrayHolder& input, Mernel::CompressionInfo compressionInfo, const ChunkConsumer& consumer);
+
+    static bool IsChunked(const ByteArrayHolder& data);
+};
+
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "CompressionDictionary.h"
+
+#include "Sha256.h"
+#include "Syslogger.h"
+
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+namespace Wuild {
+
+#ifdef HAS_ZSTD
+namespace {
+// contexts keep their buffers between calls, so they are reused by each thread.
+ZSTD_CCtx* GetCompressContext()
+{
+    thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+    return context.get();
+}
+
+ZSTD_DCtx* GetDecompressContext()
+{
+    thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+    return context.get();
+}
+}
+
+struct CompressionDictionary::Impl {
+    ZSTD_DDict*                m_ddict = nullptr;
+    std::mutex                 m_cdictsMutex;
+    std::map<int, ZSTD_CDict*> m_cdicts; //!< Digested dictionary for each used level
+
+    ~Impl()
+    {
+        ZSTD_freeDDict(m_ddict);
+        for (auto& cdict : m_cdicts)
+            ZSTD_freeCDict(cdict.second);
+    }
+};
+#else
+struct CompressionDictionary::Impl {
+};
+#endif
+
+CompressionDictionary::CompressionDictionary(const ByteArrayHolder& data)
+    : m_id(Sha256::Hash(data))
+    , m_data(data)
+    , m_impl(new Impl())
+{
+}
+
+CompressionDictionary::~CompressionDictionary() = default;
+
+bool CompressionDictionary::IsSupported()
+{
+#ifdef HAS_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+CompressionDictionary::Ptr CompressionDictionary::Create(const ByteArrayHolder& data)
+{
+#ifdef HAS_ZSTD
+    std::shared_ptr<CompressionDictionary> dictionary(new CompressionDictionary(data));
+    dictionary->m_impl->m_ddict = ZSTD_createDDict(data.data(), data.size());
+    if (!dictionary->m_impl->m_ddict)
+        return nullptr;
+    return dictionary;
+#else
+    (void) data;
+    return nullptr;
+#endif
+}
+
+CompressionDictionary::Ptr CompressionDictionary::Train(const std::vector<ByteArrayHolder>& samples, size_t maxSize)
+{
+#ifdef HAS_ZSTD
+    ByteArray           buffer;
+    std::vector<size_t> sizes;
+    for (const auto& sample : samples) {
+        if (!sample.size())
+            continue;
+        buffer.insert(buffer.end(), sample.ref().cbegin(), sample.ref().cend());
+        sizes.push_back(sample.size());
+    }
+    ByteArray    dictionary(maxSize);
+    const size_t size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), buffer.data(), sizes.data(), static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(size)) {
+        Syslogger(Syslogger::Warning) << "Failed to train dictionary on " << sizes.size() << " samples: " << ZDICT_getErrorName(size);
+        return nullptr;
+    }
+    dictionary.resize(size);
+    return Create(ByteArrayHolder(std::move(dictionary)));
+#else
+    (void) samples;
+    (void) maxSize;
+    return nullptr;
+#endif
+}
+
+void CompressionDictionary::Compress(const ByteArrayHolder& input, ByteArrayHolder& output, int level) const
+{
+#ifdef HAS_ZSTD
+    ZSTD_CDict* cdict = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->m_cdictsMutex);
+        auto&                       levelDict = m_impl->m_cdicts[level];
+        if (!levelDict)
+            levelDict = ZSTD_createCDict(m_data.data(), m_data.size(), level);
+        cdict = levelDict;
+    }
+    if (!cdict)
+        throw std::runtime_error("Failed to prepare zstd dictionary");
+
+    ByteArray& out = output.ref();
+    out.resize(ZSTD_compressBound(input.size()));
+    const size_t size = ZSTD_compress_usingCDict(GetCompressContext(), out.data(), out.size(), input.data(), input.size(), cdict);
+    if (ZSTD_isError(size))
+        throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(size));
+    out.resize(size);
+#else
+    (void) input;
+    (void) output;
+    (void) level;
+    throw std::runtime_error("zstd dictionaries are not supported by this build");
+#endif
+}
+
+void CompressionDictionary::Uncompress(const ByteArrayHolder& input, ByteArrayHolder& output) const
+{
+#ifdef HAS_ZSTD
+    const unsigned long long contentSize = ZSTD_getFrameContentSize(input.data(), input.size());
+    if (contentSize == ZSTD_CONTENTSIZE_ERROR || contentSize == ZSTD_CONTENTSIZE_UNKNOWN)
+        throw std::runtime_error("Invalid zstd frame");
+    // size comes from peer, so it is checked before allocation.
+    if (contentSize > s_maxUncompressedSize)
+        throw std::runtime_error("zstd frame is too large: " + std::to_string(contentSize) + " bytes");
+
+    ByteArray& out = output.ref();
+    out.resize(static_cast<size_t>(contentSize));
+    const size_t size = ZSTD_decompress_usingDDict(GetDecompressContext(), out.data(), out.size(), input.data(), input.size(), m_impl->m_ddict);
+    if (ZSTD_isError(size))
+        throw std::runtime_error(std::string("zstd decompression failed: ") + ZSTD_getErrorName(size));
+    if (size != out.size())
+        throw std::runtime_error("zstd frame size mismatch");
+#else
+    (void) input;
+    (void) output;
+    throw std::runtime_error("zstd dictionaries are not supported by this build");
+#endif
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+#include "CommonTypes.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Wuild {
+
+/// Zstd dictionary trained on similar inputs, e.g. preprocessed sources of one project.
+///
+/// Compressed data is a single zstd frame. Available only when built with zstd (HAS_ZSTD);
+/// otherwise IsSupported() is false and no dictionary can be created.
+class CompressionDictionary {
+    struct Impl;
+    explicit CompressionDictionary(const ByteArrayHolder& data);
+
+public:
+    using Ptr = std::shared_ptr<const CompressionDictionary>;
+
+    static constexpr size_t s_maxUncompressedSize = 1024 * 1024 * 1024; //!< Uncompress rejects larger frames
+
+    static bool IsSupported();
+
+    /// Returns nullptr if dictionary data is invalid.
+    static Ptr Create(const ByteArrayHolder& data);
+
+    /// Returns nullptr if samples are too few or too small to train.
+    static Ptr Train(const std::vector<ByteArrayHolder>& samples, size_t maxSize);
+
+    ~CompressionDictionary();
+
+    const std::string&     GetId() const { return m_id; } //!< SHA-256 of dictionary data
+    const ByteArrayHolder& GetData() const { return m_data; }
+
+    /// Both throw std::runtime_error on failure, same as Mernel compression functions.
+    void Compress(const ByteArrayHolder& input, ByteArrayHolder& output, int level) const;
+    void Uncompress(const ByteArrayHolder& input, ByteArrayHolder& output) const;
+
+private:
+    std::string           m_id;
+    ByteArrayHolder       m_data;
+    std::unique_ptr<Impl> m_impl;
+};
+
+}
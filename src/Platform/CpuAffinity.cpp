@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "CpuAffinity.h"
+
+#include "StringUtils.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <tuple>
+
+#include "MernelPlatform/FsUtils.hpp"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace Wuild {
+
+namespace {
+#ifdef __linux__
+int ReadSysInt(const std::string& path, int defaultValue)
+{
+    std::ifstream file(path);
+    int           value = defaultValue;
+    file >> value;
+    return file ? value : defaultValue;
+}
+
+/// Parses kernel cpu list, e.g. "0-15,64-79".
+CpuSet ParseCpuList(const std::string& list)
+{
+    CpuSet       result;
+    StringVector ranges;
+    StringUtils::SplitString(list, ranges, ',', true, true);
+    for (const auto& range : ranges) {
+        const auto dash  = range.find('-');
+        const int  first = std::atoi(range.c_str());
+        const int  last  = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+        for (int cpu = first; cpu <= last; ++cpu)
+            result.push_back(cpu);
+    }
+    return result;
+}
+#endif
+}
+
+std::vector<CpuInfo> GetAvailableCpus()
+{
+    std::vector<CpuInfo> result;
+#ifdef __linux__
+    cpu_set_t available;
+    CPU_ZERO(&available);
+    if (sched_getaffinity(0, sizeof(available), &available) != 0)
+        return result;
+
+    std::map<int, int> nodeByCpu;
+    std::error_code    code;
+    for (const auto& entry : Mernel::std_fs::directory_iterator("/sys/devices/system/node", code)) {
+        const std::string name = Mernel::path2string(entry.path().filename());
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0 || !isdigit(name[4]))
+            continue;
+        std::ifstream cpuList(Mernel::path2string(entry.path()) + "/cpulist");
+        std::string   list;
+        std::getline(cpuList, list);
+        for (int cpu : ParseCpuList(list))
+            nodeByCpu[cpu] = std::atoi(name.c_str() + 4);
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &available))
+            continue;
+        const std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        CpuInfo           info;
+        info.m_cpu     = cpu;
+        info.m_core    = ReadSysInt(topology + "core_id", cpu);
+        info.m_package = ReadSysInt(topology + "physical_package_id", 0);
+        info.m_node    = nodeByCpu.count(cpu) ? nodeByCpu[cpu] : 0;
+        result.push_back(info);
+    }
+#endif
+    return result;
+}
+
+std::vector<CpuSet> PlanCpuSlots(const std::vector<CpuInfo>& cpus, CpuAffinity policy, size_t slots)
+{
+    std::vector<CpuSet> result;
+    if (policy == CpuAffinity::None || cpus.empty())
+        return result;
+
+    std::vector<CpuSet> ordered;
+    if (policy == CpuAffinity::Numa) {
+        std::map<int, CpuSet> nodes;
+        for (const auto& cpu : cpus)
+            nodes[cpu.m_node].push_back(cpu.m_cpu);
+        for (const auto& node : nodes) {
+            // each CPU contributes one entry, so nodes get slots proportionally to their size.
+            for (size_t i = 0; i < node.second.size(); ++i)
+                ordered.push_back(node.second);
+        }
+        for (size_t i = 0; i < slots; ++i)
+            result.push_back(ordered[i * ordered.size() / slots]);
+        return result;
+    }
+
+    // SMT siblings of physical core go together.
+    std::map<std::tuple<int, int, int>, CpuSet> cores;
+    for (const auto& cpu : cpus)
+        cores[std::make_tuple(cpu.m_node, cpu.m_package, cpu.m_core)].push_back(cpu.m_cpu);
+
+    if (policy == CpuAffinity::Core) {
+        for (const auto& core : cores)
+            ordered.push_back(core.second);
+    } else {
+        std::map<int, std::vector<CpuSet>> packages;
+        for (const auto& core : cores)
+            packages[std::get<1>(core.first)].push_back(core.second);
+        for (size_t index = 0; ordered.size() < cores.size(); ++index) {
+            for (const auto& package : packages) {
+                if (index < package.second.size())
+                    ordered.push_back(package.second[index]);
+            }
+        }
+    }
+    // more slots than cores: SMT siblings are shared by several slots.
+    for (size_t i = 0; i < slots; ++i)
+        result.push_back(ordered[i % ordered.size()]);
+    return result;
+}
+
+void CpuSlots::Replan(const std::vector<CpuSet>& plan)
+{
+    if (m_slots.size() < plan.size())
+        m_slots.resize(plan.size());
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        Slot& slot     = m_slots[i];
+        slot.m_retired = i >= plan.size();
+        slot.m_planned.clear();
+        if (slot.m_retired)
+            continue;
+        if (slot.m_busy && slot.m_cpus != plan[i])
+            slot.m_planned = plan[i];
+        else if (!slot.m_busy)
+            slot.m_cpus = plan[i];
+    }
+    TrimRetired();
+}
+
+bool CpuSlots::Acquire(size_t& slot, CpuSet& cpus)
+{
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        if (m_slots[i].m_busy || m_slots[i].m_retired)
+            continue;
+        m_slots[i].m_busy = true;
+        slot              = i;
+        cpus              = m_slots[i].m_cpus;
+        return true;
+    }
+    return false;
+}
+
+void CpuSlots::Release(size_t slot)
+{
+    if (slot >= m_slots.size())
+        return;
+    Slot& released  = m_slots[slot];
+    released.m_busy = false;
+    if (!released.m_planned.empty()) {
+        released.m_cpus = std::move(released.m_planned);
+        released.m_planned.clear();
+    }
+    TrimRetired();
+}
+
+size_t CpuSlots::GetBusyCount() const
+{
+    return std::count_if(m_slots.cbegin(), m_slots.cend(), [](const Slot& slot) { return slot.m_busy; });
+}
+
+void CpuSlots::TrimRetired()
+{
+    // only tail is removed, so indices of busy slots stay valid.
+    while (!m_slots.empty() && m_slots.back().m_retired && !m_slots.back().m_busy)
+        m_slots.pop_back();
+}
+
+bool SetThreadCpuAffinity(const CpuSet& cpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+        CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void) cpus;
+    return false;
+#endif
+}
+
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+
+#include "CommonTypes.h"
+
+namespace Wuild {
+/// Placement of processes on logical CPUs.
+enum class CpuAffinity
+{
+    None,   //!< Leave placement to OS scheduler
+    Core,   //!< Each slot on its own physical core (with SMT siblings), filling socket by socket
+    Numa,   //!< Each slot on all CPUs of one NUMA node, nodes get slots proportionally to their size
+    Spread, //!< Each slot on its own physical core, interleaving sockets
+};
+
+using CpuSet = std::vector<int>;
+
+/// Logical CPU location.
+struct CpuInfo {
+    int m_cpu     = 0; //!< Logical CPU number, as used by OS
+    int m_core    = 0; //!< Physical core id, unique within package
+    int m_package = 0; //!< Socket
+    int m_node    = 0; //!< NUMA node
+};
+
+/// Logical CPUs available to process, with their topology. Empty if not supported on platform (only Linux is).
+std::vector<CpuInfo> GetAvailableCpus();
+
+/// Splits CPUs between process slots according to policy. Returns empty vector for CpuAffinity::None.
+std::vector<CpuSet> PlanCpuSlots(const std::vector<CpuInfo>& cpus, CpuAffinity policy, size_t slots);
+
+/// Restricts calling thread to CPUs; processes started from thread inherit that. Returns false if not supported or failed.
+bool SetThreadCpuAffinity(const CpuSet& cpus);
+
+/// Process slots with CPUs from PlanCpuSlots, which can be replanned while processes run.
+///
+/// Running process keeps its slot and CPUs: on Replan only free slots take new CPUs, busy ones take them when released,
+/// and slots beyond new plan are removed once released. Not thread safe, owner guards it.
+class CpuSlots {
+public:
+    void Replan(const std::vector<CpuSet>& plan);
+
+    /// Takes free slot; false if there is none (e.g. no pinning).
+    bool Acquire(size_t& slot, CpuSet& cpus);
+    void Release(size_t slot);
+
+    size_t GetSize() const { return m_slots.size(); } //!< Including busy slots which are beyond current plan
+    size_t GetBusyCount() const;
+
+private:
+    struct Slot {
+        CpuSet m_cpus;
+        CpuSet m_planned; //!< Taken when busy slot is released; empty = no change
+        bool   m_busy    = false;
+        bool   m_retired = false; //!< Beyond current plan, removed when released
+    };
+    void TrimRetired();
+
+    std::vector<Slot> m_slots;
+};
+
+}
@@ -13,6 +13,7 @@
 
 #include "FileUtils.h"
 
+#include "ChunkedCompression.h"
 #include "Syslogger.h"
 #include "ThreadUtils.h"
 
@@ -38,13 +39,21 @@
 #include <direct.h>
 #else
 #include <unistd.h>
+#include <fcntl.h>
 #include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
 inline int GetLastError()
 {
     return errno;
 }
 #endif
 
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
 namespace {
 const size_t CHUNK = 16384;
 #ifdef _WIN32
@@ -52,6 +61,63 @@ static const char PATH_LIST_SEPARTOR = ';';
 #else
 const char PATH_LIST_SEPARTOR = ':';
 #endif
+
+/// Read-only view of whole regular file; IsValid() is false if file can't be mapped.
+class MappedView {
+public:
+    MappedView(const std::string& path)
+    {
+#ifdef _WIN32
+        auto fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0) {
+            // view keeps mapping and file open after handles are closed.
+            if (auto mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL)) {
+                m_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                m_size = m_data ? static_cast<size_t>(fileSize.QuadPart) : 0;
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(fileHandle);
+#else
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                madvise(data, st.st_size, MADV_SEQUENTIAL);
+                m_data = static_cast<const uint8_t*>(data);
+                m_size = st.st_size;
+            }
+        }
+        close(fd);
+#endif
+    }
+    ~MappedView()
+    {
+        if (!m_data)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+#else
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    }
+    MappedView(const MappedView&)            = delete;
+    MappedView& operator=(const MappedView&) = delete;
+
+    bool           IsValid() const { return m_data != nullptr; }
+    const uint8_t* GetData() const { return m_data; }
+    size_t         GetSize() const { return m_size; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t         m_size = 0;
+};
 }
 
 namespace Wuild {
@@ -175,17 +241,12 @@ std::string FileInfo::GetPlatformShortName() const
 
 bool FileInfo::ReadCompressed(ByteArrayHolder& data, CompressionInfo compressionInfo)
 {
-    std::ifstream inFile;
-    inFile.open(GetPath().c_str(), std::ios::binary | std::ios::in);
-    if (!inFile)
-        return false;
-
-    ByteArrayHolder uncompressedData;
-    if (!ReadFile(uncompressedData))
-        return false;
-
+    // compressed straight from mapped file; big file is compressed by chunks, so only one chunk is copied at a time.
+    ChunkedCompression::Compressor compressor(compressionInfo);
     try {
-        Mernel::compressDataBuffer(uncompressedData, data, compressionInfo);
+        if (!ReadMapped([&compressor](const uint8_t* in, size_t size) { compressor.Add(in, size); }))
+            return false;
+        compressor.Finish(data);
     }
     catch (std::exception& e) {
         Syslogger(Syslogger::Err) << "Error on reading:" << e.what() << " for " << GetPath();
@@ -200,9 +261,12 @@ bool FileInfo::ReadCompressed(ByteArrayHolder& data, CompressionInfo compression
 
 bool FileInfo::WriteCompressed(const ByteArrayHolder& data, CompressionInfo compressionInfo, bool createTmpCopy, PostProcessor pp)
 {
+    if (compressionInfo.m_type == Mernel::CompressionType::None && !pp)
+        return this->WriteFile(data, createTmpCopy);
+
     ByteArrayHolder uncompData;
     try {
-        Mernel::uncompressDataBuffer(data, uncompData, compressionInfo);
+        ChunkedCompression::Uncompress(data, uncompData, compressionInfo);
         if (pp)
             pp(uncompData.ref());
     }
@@ -215,24 +279,41 @@ bool FileInfo::WriteCompressed(const ByteArrayHolder& data, CompressionInfo comp
 
 bool FileInfo::ReadFile(ByteArrayHolder& data)
 {
+    // file size is known from mapping, so buffer is allocated once, without spare capacity.
+    ByteArray& dest = data.ref();
+    return ReadMapped([&dest](const uint8_t* in, size_t size) { dest.insert(dest.end(), in, in + size); });
+}
+
+bool FileInfo::ReadMapped(const MappedReader& reader)
+{
+    {
+        MappedView view(GetPath());
+        if (view.IsValid()) {
+            reader(view.GetData(), view.GetSize());
+            return true;
+        }
+    }
+
+    // size is known only for regular file; short read means it was changed or read failed.
+    std::error_code code;
+    const bool      regular      = Mernel::std_fs::is_regular_file(m_impl->m_path, code);
+    const auto      expectedSize = regular ? Mernel::std_fs::file_size(m_impl->m_path, code) : 0;
+    if (code)
+        return false;
+
     FILE* f = fopen(GetPath().c_str(), "rb");
     if (!f)
         return false;
 
-    ByteArray& dest = data.ref();
-
+    ByteArray     buffer;
     unsigned char in[CHUNK];
-    do {
-        auto avail_in = fread(in, 1, CHUNK, f);
-        if (!avail_in || ferror(f))
-            break;
-        dest.insert(dest.end(), in, in + avail_in);
-        if (feof(f))
-            break;
-
-    } while (true);
-
+    while (const auto avail_in = fread(in, 1, CHUNK, f))
+        buffer.insert(buffer.end(), in, in + avail_in);
+    const bool failed = ferror(f);
     fclose(f);
+    if (failed || (regular && buffer.size() != expectedSize))
+        return false;
+    reader(buffer.data(), buffer.size());
     return true;
 }
 
@@ -248,6 +329,8 @@ bool FileInfo::WriteFile(const ByteArrayHolder& data, bool createTmpCopy)
         outFile.open(writePath, std::ios::binary | std::ios::out);
         outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
         outFile.close();
+        if (!outFile)
+            throw std::runtime_error("Failed to write data");
 #else
         auto fileHandle = CreateFileA(writePath.c_str(),     // file name
                                       GENERIC_WRITE,         // open for write
@@ -285,6 +368,8 @@ bool FileInfo::WriteFile(const ByteArrayHolder& data, bool createTmpCopy)
     }
     catch (std::exception& e) {
         Syslogger(Syslogger::Err) << "Error on writing:" << e.what() << " for " << writePath;
+        if (!createTmpCopy)
+            this->Remove(); // don't leave truncated file which looks up to date.
         return false;
     }
     if (createTmpCopy) {
@@ -298,6 +383,31 @@ bool FileInfo::WriteFile(const ByteArrayHolder& data, bool createTmpCopy)
     return true;
 }
 
+bool FileInfo::CopyTo(const std::string& destination)
+{
+    FileInfo(destination).Remove();
+#ifdef FICLONE
+    const int source = open(GetPath().c_str(), O_RDONLY);
+    if (source >= 0) {
+        const int  dest   = open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        const bool cloned = dest >= 0 && ioctl(dest, FICLONE, source) == 0;
+        if (dest >= 0)
+            close(dest);
+        close(source);
+        if (cloned)
+            return true;
+    }
+#endif
+    std::error_code code;
+    Mernel::std_fs::copy_file(m_impl->m_path, Mernel::string2path(destination), Mernel::std_fs::copy_options::overwrite_existing, code);
+    if (code) {
+        Syslogger(Syslogger::Err) << "Failed to copy " << GetPath() << " to " << destination << ": " << code.message();
+        FileInfo(destination).Remove();
+        return false;
+    }
+    return true;
+}
+
 bool FileInfo::Exists()
 {
     std::error_code code;
@@ -34,6 +34,7 @@ public:
     static std::string ToPlatformPath(std::string path);
 
     using PostProcessor = std::function<void(ByteArray&)>;
+    using MappedReader  = std::function<void(const uint8_t* data, size_t size)>;
 
 public:
     FileInfo(const FileInfo& rh);
@@ -71,9 +72,18 @@ public:
     /// Read whole file into buffer
     bool ReadFile(ByteArrayHolder& data);
 
-    /// Write buffer to file
+    /// Map file into memory read-only and pass whole contents to reader, without copy to heap.
+    /// Files which can't be mapped (empty or not regular) are read into temporary buffer instead.
+    /// Returns false if file can't be read, or was read partially.
+    /// Exceptions from reader are passed to caller, file is unmapped anyway.
+    bool ReadMapped(const MappedReader& reader);
+
+    /// Write buffer to file; without tmp copy it is written in place, and removed if write fails.
     bool WriteFile(const ByteArrayHolder& data, bool createTmpCopy = true);
 
+    /// Copy file to destination, replacing it; on Linux file is cloned (copy-on-write) when filesystem supports it.
+    bool CopyTo(const std::string& destination);
+
     /// Check existence of file on disk.
     bool Exists();
 
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "Sha256.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Wuild {
+
+namespace {
+const uint32_t g_roundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline uint32_t RotateRight(uint32_t value, int bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+}
+
+Sha256::Sha256()
+    : m_state{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 }
+{
+}
+
+Sha256& Sha256::Update(const uint8_t* data, size_t size)
+{
+    m_totalSize += size;
+    if (m_bufferSize) {
+        const size_t part = std::min(size, m_buffer.size() - m_bufferSize);
+        std::memcpy(m_buffer.data() + m_bufferSize, data, part);
+        m_bufferSize += part;
+        data += part;
+        size -= part;
+        if (m_bufferSize < m_buffer.size())
+            return *this;
+        ProcessBlock(m_buffer.data());
+        m_bufferSize = 0;
+    }
+    for (; size >= m_buffer.size(); data += m_buffer.size(), size -= m_buffer.size())
+        ProcessBlock(data);
+    std::memcpy(m_buffer.data(), data, size);
+    m_bufferSize = size;
+    return *this;
+}
+
+Sha256& Sha256::UpdateField(const std::string& str)
+{
+    const uint64_t size = str.size();
+    uint8_t        sizeBytes[8];
+    for (int i = 0; i < 8; ++i)
+        sizeBytes[i] = static_cast<uint8_t>(size >> (8 * i));
+    Update(sizeBytes, sizeof(sizeBytes));
+    return Update(reinterpret_cast<const uint8_t*>(str.data()), str.size());
+}
+
+std::string Sha256::GetHexDigest()
+{
+    const uint64_t totalBits = m_totalSize * 8;
+    const uint8_t  padding   = 0x80;
+    Update(&padding, 1);
+    const uint8_t zero = 0;
+    while (m_bufferSize != 56)
+        Update(&zero, 1);
+    uint8_t lengthBytes[8];
+    for (int i = 0; i < 8; ++i)
+        lengthBytes[i] = static_cast<uint8_t>(totalBits >> (56 - 8 * i));
+    Update(lengthBytes, sizeof(lengthBytes));
+
+    static const char* const hexDigits = "0123456789abcdef";
+    std::string              result;
+    for (uint32_t word : m_state) {
+        for (int shift = 28; shift >= 0; shift -= 4)
+            result += hexDigits[(word >> shift) & 0xf];
+    }
+    return result;
+}
+
+void Sha256::ProcessBlock(const uint8_t* block)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i)
+        w[i] = uint32_t(block[i * 4]) << 24 | uint32_t(block[i * 4 + 1]) << 16 | uint32_t(block[i * 4 + 2]) << 8 | uint32_t(block[i * 4 + 3]);
+    for (int i = 16; i < 64; ++i) {
+        const uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i]              = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+    uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+    for (int i = 0; i < 64; ++i) {
+        const uint32_t s1    = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+        const uint32_t ch    = (e & f) ^ (~e & g);
+        const uint32_t temp1 = h + s1 + ch + g_roundConstants[i] + w[i];
+        const uint32_t s0    = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+        const uint32_t maj   = (a & b) ^ (a & c) ^ (b & c);
+        const uint32_t temp2 = s0 + maj;
+        h                    = g;
+        g                    = f;
+        f                    = e;
+        e                    = d + temp1;
+        d                    = c;
+        c                    = b;
+        b                    = a;
+        a                    = temp1 + temp2;
+    }
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
+
+}
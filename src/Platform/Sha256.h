@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+#include "CommonTypes.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace Wuild {
+
+/// SHA-256 digest (FIPS 180-4), used to address content by its hash.
+class Sha256 {
+public:
+    Sha256();
+
+    Sha256& Update(const uint8_t* data, size_t size);
+    Sha256& Update(const ByteArrayHolder& data) { return Update(data.data(), data.size()); }
+    /// Adds string with its length, so sequence of fields can't be confused with their concatenation.
+    Sha256& UpdateField(const std::string& str);
+
+    /// Finalizes digest; object can't be updated after that.
+    std::string GetHexDigest();
+
+    static std::string Hash(const ByteArrayHolder& data) { return Sha256().Update(data).GetHexDigest(); }
+
+private:
+    void ProcessBlock(const uint8_t* block);
+
+    std::array<uint32_t, 8> m_state;
+    std::array<uint8_t, 64> m_buffer;
+    size_t                  m_bufferSize = 0;
+    uint64_t                m_totalSize  = 0;
+};
+
+}
@@ -18,6 +18,7 @@
 #include "ByteOrderStream.h"
 
 #include <cstring>
+#include <limits>
 #include <stdexcept>
 #include <sstream>
 #include <set>
@@ -170,6 +171,11 @@ void SocketFrameHandler::SetConnectionStatusNotifier(SocketFrameHandler::Connect
 {
     m_connStatusNotifier = std::move(callback);
 }
+
+void SocketFrameHandler::SetConnectionStatusProvider(SocketFrameHandler::ConnectionStatusProvider provider)
+{
+    m_connStatusProvider = std::move(provider);
+}
 // Application logic:
 
 void SocketFrameHandler::QueueFrame(const SocketFrame::Ptr& message, const SocketFrameHandler::ReplyNotifier& replyNotifier, TimePoint timeout)
@@ -360,11 +366,14 @@ SocketFrameHandler::ConsumeState SocketFrameHandler::ConsumeReadBuffer()
         Syslogger(m_logContext) << "Recieved buffer size = " << bufferSize << ", MaxUnAck=" << m_maxUnAcknowledgedSize << ", remote time is " << m_remoteTimeDiffToPast.ToString() << " in past compare to me. (" << m_remoteTimeDiffToPast.GetUS() << " us)";
     } else if (m_settings.m_hasConnStatus && mtype == ServiceMessageType::ConnStatus) {
         ConnectionStatus status{};
-        inputStream >> status.uniqueRepliesQueued;
+        inputStream >> status.uniqueRepliesQueued >> status.outputBytesPending >> status.queuedTasks >> status.runningTasks;
         if (m_connStatusNotifier)
             m_connStatusNotifier(status);
         else
-            Syslogger(m_logContext, Syslogger::Info) << "Server-side messages queued: " << status.uniqueRepliesQueued;
+            Syslogger(m_logContext, Syslogger::Info) << "Server-side messages queued: " << status.uniqueRepliesQueued
+                                                     << ", bytes pending: " << status.outputBytesPending
+                                                     << ", tasks queued: " << status.queuedTasks
+                                                     << ", tasks running: " << status.runningTasks;
     }
     // othrewise, we have application frame. Move its data to framebuffer.
     else {
@@ -483,7 +492,7 @@ SocketFrameHandler::QuantResult SocketFrameHandler::WriteFrames()
         ByteOrderDataStreamWriter streamWriter(buf, m_settings.m_byteOrder);
         streamWriter << uint8_t(ServiceMessageType::ConnStatus);
         auto status = CalculateStatus();
-        streamWriter << status.uniqueRepliesQueued;
+        streamWriter << status.uniqueRepliesQueued << status.outputBytesPending << status.queuedTasks << status.runningTasks;
         m_outputSegments.push_front(buf.GetHolder());
         m_lastConnStatusSend = TimePoint(true);
     }
@@ -640,12 +649,17 @@ void SocketFrameHandler::PreprocessFrame(const SocketFrame::Ptr& incomingMessage
 SocketFrameHandler::ConnectionStatus SocketFrameHandler::CalculateStatus()
 {
     std::set<size_t> transactions;
+    size_t           bytesPending = m_bytesWaitingAcknowledge;
     for (const auto& segment : m_outputSegments) {
         if (segment.transaction)
             transactions.insert(segment.transaction);
+        bytesPending += segment.data.size();
     }
     ConnectionStatus status{};
     status.uniqueRepliesQueued = static_cast<uint16_t>(transactions.size());
+    status.outputBytesPending  = static_cast<uint32_t>(std::min(bytesPending, size_t(std::numeric_limits<uint32_t>::max())));
+    if (m_connStatusProvider)
+        m_connStatusProvider(status);
     return status;
 }
 
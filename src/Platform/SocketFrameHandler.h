@@ -119,8 +119,12 @@ public:
 
     struct ConnectionStatus {
         uint16_t uniqueRepliesQueued;
+        uint32_t outputBytesPending; //!< Bytes not yet written to socket or not acknowledged.
+        uint16_t queuedTasks;        //!< Application backlog, filled by ConnectionStatusProvider.
+        uint16_t runningTasks;       //!< Application load, filled by ConnectionStatusProvider.
     };
     using ConnectionStatusCallback = std::function<void(const ConnectionStatus&)>;
+    using ConnectionStatusProvider = std::function<void(ConnectionStatus&)>;
 
 public:
     explicit SocketFrameHandler(int threadId, const SocketFrameHandlerSettings& settings = SocketFrameHandlerSettings());
@@ -160,6 +164,9 @@ public:
     /// register watcher for connection status change.
     void SetConnectionStatusNotifier(ConnectionStatusCallback callback);
 
+    /// provider fills application-level fields of status before it will be sent to the other side.
+    void SetConnectionStatusProvider(ConnectionStatusProvider provider);
+
     // Application logic:
     ///  Adding new frame to queue. If replyNotifier is set, it will called instead of IFrameReader::ProcessFrame, when reply arrived or failure occurs.
     void QueueFrame(const SocketFrame::Ptr& message, const ReplyNotifier& replyNotifier = ReplyNotifier(), TimePoint timeout = TimePoint());
@@ -238,6 +245,7 @@ protected:
 
     StateNotifierCallback     m_stateNotifier;
     ConnectionStatusCallback  m_connStatusNotifier;
+    ConnectionStatusProvider  m_connStatusProvider;
     std::atomic_uint_fast64_t m_transaction{ 0 };
 
     IDataSocket::Ptr                 m_channel;
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "ThreadPool.h"
+
+#include "Syslogger.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Wuild {
+
+class ThreadPoolImpl {
+public:
+    std::vector<std::thread>    m_threads;
+    std::deque<ThreadPool::Job> m_jobs;
+    mutable std::mutex          m_mutex;
+    std::condition_variable     m_cond;
+    bool                        m_stop  = false;
+    bool                        m_drain = false; //!< Finish queued jobs before stop
+
+    void Start(size_t threads)
+    {
+        m_stop  = false;
+        m_drain = false;
+        for (size_t i = 0; i < threads; ++i)
+            m_threads.emplace_back([this] { Worker(); });
+    }
+
+    void Stop(bool drain)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop  = true;
+            m_drain = drain;
+        }
+        m_cond.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+        m_threads.clear();
+    }
+
+    void Worker()
+    {
+        while (true) {
+            ThreadPool::Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+                if (m_stop && (!m_drain || m_jobs.empty()))
+                    return;
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+            try {
+                job();
+            }
+            catch (std::exception& ex) {
+                Syslogger(Syslogger::Err) << "std::exception caught in ThreadPool job " << ex.what();
+            }
+        }
+    }
+};
+
+ThreadPool::ThreadPool(size_t threads)
+    : m_impl(new ThreadPoolImpl)
+{
+    m_impl->Start(std::max(threads, size_t(1)));
+}
+
+ThreadPool::~ThreadPool()
+{
+    m_impl->Stop(true);
+}
+
+void ThreadPool::SetThreadCount(size_t threads)
+{
+    threads = std::max(threads, size_t(1));
+    if (threads == m_impl->m_threads.size())
+        return;
+    m_impl->Stop(false);
+    m_impl->Start(threads);
+    m_impl->m_cond.notify_all();
+}
+
+size_t ThreadPool::GetThreadCount() const
+{
+    return m_impl->m_threads.size();
+}
+
+size_t ThreadPool::GetQueueSize() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_jobs.size();
+}
+
+void ThreadPool::Enqueue(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+        m_impl->m_jobs.push_back(std::move(job));
+    }
+    m_impl->m_cond.notify_one();
+}
+
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#pragma once
+
+#include "CommonTypes.h"
+
+#include <functional>
+
+namespace Wuild {
+class ThreadPoolImpl;
+/// Fixed set of worker threads executing queued jobs in FIFO order.
+///
+/// Destructor waits for all queued jobs to finish.
+class ThreadPool {
+    std::unique_ptr<ThreadPoolImpl> m_impl;
+
+public:
+    using Job = std::function<void()>;
+
+public:
+    explicit ThreadPool(size_t threads = 1);
+    ~ThreadPool();
+
+    /// Changes number of workers; queued jobs are kept.
+    void SetThreadCount(size_t threads);
+
+    size_t GetThreadCount() const;
+
+    /// Number of jobs which are not yet taken by workers.
+    size_t GetQueueSize() const;
+
+    void Enqueue(Job job);
+};
+
+}
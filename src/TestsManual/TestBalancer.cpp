@@ -16,6 +16,9 @@
 #include <ToolBalancer.h>
 #include <Application.h>
 
+#include <algorithm>
+#include <deque>
+
 namespace {
 const std::string g_tool    = "gcc";
 const size_t      g_noIndex = std::numeric_limits<size_t>::max();
@@ -93,6 +96,177 @@ int main(int argc, char** argv)
     balancer.StartTask(index);
     TEST_ASSERT((balancer.TestGetBusy() == LoadVector{ 3, 3 }));
 
+    // prefetch: no depth until we have measurements.
+    ToolBalancer prefetchBalancer;
+    prefetchBalancer.SetSessionId(1);
+    prefetchBalancer.SetMaxPrefetch(8);
+    info1.m_connectedClients.clear();
+    prefetchBalancer.UpdateClient(info1, index);
+    prefetchBalancer.SetClientCompatible(0, true);
+    prefetchBalancer.SetClientActive(0, true);
+    TEST_ASSERT(prefetchBalancer.GetFreeThreads() == 8);
+    TEST_ASSERT((prefetchBalancer.TestGetPrefetch() == LoadVector{ 0 }));
+
+    // transfer takes quarter of compilation: 8 threads * 0.25 = 2 tasks ahead.
+    prefetchBalancer.UpdateTaskTimings(0, TimePoint(0.025), TimePoint(0.1));
+    TEST_ASSERT((prefetchBalancer.TestGetPrefetch() == LoadVector{ 2 }));
+    TEST_ASSERT(prefetchBalancer.GetFreeThreads() == 10);
+
+    for (int i = 0; i < 10; ++i)
+        prefetchBalancer.StartTask(0);
+    TEST_ASSERT(prefetchBalancer.GetFreeThreads() == 0);
+    prefetchBalancer.FinishTask(0);
+    TEST_ASSERT(prefetchBalancer.GetFreeThreads() == 1);
+
+    // slow link: depth is limited by maximum.
+    for (int i = 0; i < 30; ++i)
+        prefetchBalancer.UpdateTaskTimings(0, TimePoint(1.0), TimePoint(0.1));
+    TEST_ASSERT((prefetchBalancer.TestGetPrefetch() == LoadVector{ 8 }));
+
+    prefetchBalancer.SetMaxPrefetch(0);
+    TEST_ASSERT((prefetchBalancer.TestGetPrefetch() == LoadVector{ 0 }));
+    TEST_ASSERT(prefetchBalancer.GetFreeThreads() == 0);
+
+    // server short of memory: its idle threads and prefetch are not offered.
+    ToolBalancer memoryBalancer;
+    memoryBalancer.SetSessionId(1);
+    memoryBalancer.SetMaxPrefetch(8);
+    memoryBalancer.UpdateClient(info1, index);
+    memoryBalancer.SetClientCompatible(0, true);
+    memoryBalancer.SetClientActive(0, true);
+    memoryBalancer.UpdateTaskTimings(0, TimePoint(0.025), TimePoint(0.1));
+    TEST_ASSERT(memoryBalancer.GetFreeThreads() == 10);
+    info1.m_memoryLimitedThreads = 6;
+    memoryBalancer.UpdateClient(info1, index);
+    TEST_ASSERT(memoryBalancer.GetFreeThreads() == 2);
+    info1.m_memoryLimitedThreads = 0;
+    memoryBalancer.UpdateClient(info1, index);
+    TEST_ASSERT(memoryBalancer.GetFreeThreads() == 10);
+
+    // in-flight limit: decreased on congestion, restored while it is fully used.
+    ToolBalancer limitBalancer;
+    limitBalancer.SetSessionId(1);
+    limitBalancer.UpdateClient(info1, index);
+    limitBalancer.SetClientCompatible(0, true);
+    limitBalancer.SetClientActive(0, true);
+    for (int i = 0; i < 8; ++i)
+        limitBalancer.StartTask(0);
+    ToolBalancer::ServerSideLoad congested;
+    congested.m_queuedTasks = 12;
+    limitBalancer.SetServerSideLoad(0, congested);
+    TEST_ASSERT((limitBalancer.TestGetInflightLimit() == LoadVector{ 6 }));
+    TEST_ASSERT(limitBalancer.GetFreeThreads() == 0);
+    limitBalancer.SetServerSideLoad(0, congested); // my tasks above the limit are not finished yet.
+    TEST_ASSERT((limitBalancer.TestGetInflightLimit() == LoadVector{ 6 }));
+    limitBalancer.FinishTask(0);
+    limitBalancer.FinishTask(0);
+    limitBalancer.SetServerSideLoad(0, congested);
+    TEST_ASSERT((limitBalancer.TestGetInflightLimit() == LoadVector{ 4 }));
+    limitBalancer.FinishTask(0);
+    limitBalancer.FinishTask(0);
+    limitBalancer.SetServerSideLoad(0, ToolBalancer::ServerSideLoad());
+    TEST_ASSERT((limitBalancer.TestGetInflightLimit() == LoadVector{ 5 }));
+    TEST_ASSERT(limitBalancer.GetFreeThreads() == 1);
+    for (int i = 0; i < 4; ++i) {
+        limitBalancer.StartTask(0);
+        limitBalancer.SetServerSideLoad(0, ToolBalancer::ServerSideLoad());
+    }
+    TEST_ASSERT((limitBalancer.TestGetInflightLimit() == LoadVector{ 0 }));
+    TEST_ASSERT(limitBalancer.GetFreeThreads() == 0);
+
+    // batch timeout: 8 threads, 12 tasks queued on server.
+    TEST_ASSERT(limitBalancer.GetExecutionWaves(0, 4) == 1);
+    limitBalancer.SetServerSideLoad(0, congested);
+    TEST_ASSERT(limitBalancer.GetExecutionWaves(0, 4) == 2);
+    TEST_ASSERT(limitBalancer.GetExecutionWaves(0, 5) == 3);
+
+    // several clients share servers; coordinator info is stale, so only server status keeps queues short.
+    {
+        struct SimTask {
+            size_t m_client    = 0;
+            int    m_remaining = 0;
+        };
+        struct SimServer {
+            ToolServerInfo       m_info;
+            std::deque<SimTask>  m_queue;
+            std::vector<SimTask> m_running;
+            std::vector<int>     m_inflight;
+        };
+        const size_t clientsCount      = 4, serversCount = 2, tasksPerClient = 400;
+        const int    minExecutionTicks = 3, coordinatorPeriod = 20, warmupTicks = 100;
+
+        std::deque<ToolBalancer> clients(clientsCount);
+        std::vector<SimServer>   servers(serversCount);
+        std::vector<size_t>      tasksLeft(clientsCount, tasksPerClient);
+        for (size_t s = 0; s < serversCount; ++s) {
+            servers[s].m_info                = info1;
+            servers[s].m_info.m_toolServerId = "sim" + std::to_string(s);
+            servers[s].m_inflight.resize(clientsCount);
+        }
+        for (size_t c = 0; c < clientsCount; ++c) {
+            clients[c].SetSessionId(c + 1);
+            for (size_t s = 0; s < serversCount; ++s) {
+                clients[c].UpdateClient(servers[s].m_info, index);
+                clients[c].SetClientCompatible(s, true);
+                clients[c].SetClientActive(s, true);
+            }
+        }
+        size_t finished = 0, maxQueue = 0, busySlots = 0, totalSlots = 0;
+        for (int tick = 0; finished < clientsCount * tasksPerClient && tick < 100000; ++tick) {
+            for (size_t c = 0; c < clientsCount; ++c) {
+                while (tasksLeft[c] && clients[c].GetFreeThreads() > 0) {
+                    const size_t s = clients[c].FindFreeClient(g_tool);
+                    clients[c].StartTask(s);
+                    servers[s].m_queue.push_back({ c, minExecutionTicks + int(tasksLeft[c] % 5) });
+                    servers[s].m_inflight[c]++;
+                    tasksLeft[c]--;
+                }
+            }
+            const bool allBusy = std::all_of(tasksLeft.cbegin(), tasksLeft.cend(), [](size_t left) { return left > 0; });
+            for (size_t s = 0; s < serversCount; ++s) {
+                SimServer& server = servers[s];
+                for (auto it = server.m_running.begin(); it != server.m_running.end();) {
+                    if (--it->m_remaining > 0) {
+                        ++it;
+                        continue;
+                    }
+                    clients[it->m_client].FinishTask(s);
+                    server.m_inflight[it->m_client]--;
+                    finished++;
+                    it = server.m_running.erase(it);
+                }
+                while (!server.m_queue.empty() && server.m_running.size() < server.m_info.m_totalThreads) {
+                    server.m_running.push_back(server.m_queue.front());
+                    server.m_queue.pop_front();
+                }
+                if (tick > warmupTicks && allBusy) {
+                    maxQueue = std::max(maxQueue, server.m_queue.size());
+                    busySlots += server.m_running.size();
+                    totalSlots += server.m_info.m_totalThreads;
+                }
+                ToolBalancer::ServerSideLoad load;
+                load.m_queuedTasks  = static_cast<uint16_t>(server.m_queue.size());
+                load.m_runningTasks = static_cast<uint16_t>(server.m_running.size());
+                for (size_t c = 0; c < clientsCount; ++c)
+                    clients[c].SetServerSideLoad(s, load);
+
+                if (tick % coordinatorPeriod == 0) {
+                    server.m_info.m_connectedClients.resize(clientsCount);
+                    for (size_t c = 0; c < clientsCount; ++c) {
+                        server.m_info.m_connectedClients[c].m_sessionId   = c + 1;
+                        server.m_info.m_connectedClients[c].m_usedThreads = server.m_inflight[c];
+                    }
+                    for (size_t c = 0; c < clientsCount; ++c)
+                        clients[c].UpdateClient(server.m_info, index);
+                }
+            }
+        }
+        std::cout << "Simulation: max queue=" << maxQueue << ", utilization=" << (totalSlots ? busySlots * 100 / totalSlots : 0) << "%" << std::endl;
+        TEST_ASSERT(finished == clientsCount * tasksPerClient);
+        TEST_ASSERT(maxQueue <= 2 * info1.m_totalThreads);
+        TEST_ASSERT(busySlots * 10 >= totalSlots * 9);
+    }
+
     std::cout << "OK\n";
     return 0;
 }
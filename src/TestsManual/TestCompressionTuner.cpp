@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "TestUtils.h"
+
+#include <CompressionTuner.h>
+#include <Application.h>
+
+namespace {
+using namespace Wuild;
+
+CompressionInfo MakeCompression(Mernel::CompressionType type, int level)
+{
+    CompressionInfo compression;
+    compression.m_type  = type;
+    compression.m_level = level;
+    return compression;
+}
+
+bool operator==(const CompressionInfo& l, const CompressionInfo& r)
+{
+    return l.m_type == r.m_type && (l.m_type == Mernel::CompressionType::None || l.m_level == r.m_level);
+}
+
+// 1 MiB input: compressed size in KiB and compression time in ms, roughly as measured on preprocessed sources.
+void AddCompressions(CompressionTuner& tuner)
+{
+    const size_t mib = 1024 * 1024;
+    tuner.AddCompression(MakeCompression(Mernel::CompressionType::None, 0), mib, mib, TimePoint(0.0001));
+    tuner.AddCompression(MakeCompression(Mernel::CompressionType::ZStd, 1), mib, 300 * 1024, TimePoint(0.003));
+    tuner.AddCompression(MakeCompression(Mernel::CompressionType::ZStd, 3), mib, 250 * 1024, TimePoint(0.005));
+    tuner.AddCompression(MakeCompression(Mernel::CompressionType::ZStd, 6), mib, 230 * 1024, TimePoint(0.015));
+    tuner.AddCompression(MakeCompression(Mernel::CompressionType::ZStd, 9), mib, 220 * 1024, TimePoint(0.030));
+}
+
+// small transfers give round trip, big ones give bandwidth.
+void AddTransfers(CompressionTuner& tuner, double bytesPerSecond)
+{
+    const double roundTrip = 0.0005;
+    for (int i = 0; i < 20; ++i) {
+        const size_t bytes = i % 2 ? 1024 : 512 * 1024;
+        tuner.AddTransfer(bytes, TimePoint(roundTrip + bytes / bytesPerSecond));
+    }
+}
+
+bool ChoosesMostly(CompressionTuner& tuner, const CompressionInfo& expected)
+{
+    // exploration takes 1 of s_exploreInterval tasks, so best one is chosen for the rest.
+    uint64_t same = 0;
+    for (uint64_t i = 0; i < CompressionTuner::s_exploreInterval * 4; ++i) {
+        if (tuner.Choose() == expected)
+            same++;
+    }
+    return same >= CompressionTuner::s_exploreInterval * 4 - 4;
+}
+}
+
+/*
+ * Autotest for adaptive input compression. Arguments not required.
+ */
+int main(int argc, char** argv)
+{
+    ConfiguredApplication app(argc, argv, "TestCompressionTuner");
+
+    const auto none  = MakeCompression(Mernel::CompressionType::None, 0);
+    const auto zstd3 = MakeCompression(Mernel::CompressionType::ZStd, 3);
+
+    // configured compression is used until link is measured; every candidate is tried in turn.
+    {
+        CompressionTuner tuner(zstd3);
+        for (uint64_t i = 1; i < CompressionTuner::s_exploreInterval; ++i)
+            TEST_ASSERT(tuner.Choose() == zstd3);
+        TEST_ASSERT(tuner.Choose() == none);
+        for (uint64_t i = 1; i < CompressionTuner::s_exploreInterval; ++i)
+            TEST_ASSERT(tuner.Choose() == zstd3);
+        TEST_ASSERT(tuner.Choose() == MakeCompression(Mernel::CompressionType::ZStd, 1));
+        TEST_ASSERT(tuner.GetSummary().find("link") == std::string::npos);
+    }
+
+    // configured compression which is not among standard candidates is added to them.
+    {
+        const auto zstd5 = MakeCompression(Mernel::CompressionType::ZStd, 5);
+        CompressionTuner tuner(zstd5);
+        for (uint64_t i = 1; i < CompressionTuner::s_exploreInterval; ++i)
+            TEST_ASSERT(tuner.Choose() == zstd5);
+    }
+
+    // gigabit link: compression costs more than it saves.
+    {
+        CompressionTuner tuner(zstd3);
+        AddCompressions(tuner);
+        AddTransfers(tuner, 1024. * 1024 * 1024);
+        TEST_ASSERT(ChoosesMostly(tuner, none));
+        TEST_ASSERT(tuner.GetSummary().find("with none") != std::string::npos);
+    }
+
+    // 10 MiB/s link: moderate level wins, higher ones are too slow for the size they save.
+    {
+        CompressionTuner tuner(none);
+        AddCompressions(tuner);
+        AddTransfers(tuner, 10. * 1024 * 1024);
+        TEST_ASSERT(ChoosesMostly(tuner, zstd3));
+        TEST_ASSERT(tuner.GetSummary().find("with zstd 3") != std::string::npos);
+    }
+
+    // link gets slower: estimate follows.
+    {
+        CompressionTuner tuner(zstd3);
+        AddCompressions(tuner);
+        AddTransfers(tuner, 1024. * 1024 * 1024);
+        TEST_ASSERT(ChoosesMostly(tuner, none));
+        AddTransfers(tuner, 10. * 1024 * 1024);
+        TEST_ASSERT(ChoosesMostly(tuner, zstd3));
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
@@ -34,6 +34,7 @@ public:
         Syslogger(Syslogger::Info) << "AddTask ";
         task->m_callback(res);
     }
+    void CancelTask(LocalExecutorTask::Ptr) override {}
     void SyncExecTask(LocalExecutorTask::Ptr) override
     {
         assert(!"Not implemented for test.");
@@ -52,6 +53,15 @@ public:
         return ids;
     }
     void SetThreadCount(int) override {}
+    void SetIoThreadCount(int) override {}
+    void SetMemoryStaging(const std::string&, int64_t) override {}
+    void SetToolWarmup(TimePoint) override {}
+    void SetCpuAffinity(CpuAffinity) override {}
+    void SetMemoryAdmission(int64_t) override {}
+    size_t GetMemoryLimitedThreads() const override
+    {
+        return 0;
+    }
 };
 
 const int g_toolsServerTestPort = 12345;
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "TestUtils.h"
+
+#include <CpuAffinity.h>
+#include <Application.h>
+
+namespace {
+using namespace Wuild;
+
+// 2 packages (NUMA nodes) x 2 cores x 2 SMT threads; siblings are numbered as on Linux: cpu and cpu + 4.
+std::vector<CpuInfo> MakeTopology()
+{
+    std::vector<CpuInfo> cpus;
+    for (int cpu = 0; cpu < 8; ++cpu) {
+        CpuInfo info;
+        info.m_cpu     = cpu;
+        info.m_package = (cpu % 4) / 2;
+        info.m_core    = cpu % 2;
+        info.m_node    = info.m_package;
+        cpus.push_back(info);
+    }
+    return cpus;
+}
+}
+
+/*
+ * Autotest for CPU slot planning and replanning with running processes. Arguments not required.
+ */
+int main(int argc, char** argv)
+{
+    ConfiguredApplication app(argc, argv, "TestCpuAffinity");
+
+    const auto cpus = MakeTopology();
+
+    // plans.
+    {
+        TEST_ASSERT(PlanCpuSlots(cpus, CpuAffinity::None, 4).empty());
+        TEST_ASSERT(PlanCpuSlots({}, CpuAffinity::Core, 4).empty());
+
+        const auto core = PlanCpuSlots(cpus, CpuAffinity::Core, 6);
+        TEST_ASSERT(core.size() == 6);
+        TEST_ASSERT((core[0] == CpuSet{ 0, 4 }));
+        TEST_ASSERT((core[1] == CpuSet{ 1, 5 }));
+        TEST_ASSERT((core[2] == CpuSet{ 2, 6 }));
+        TEST_ASSERT((core[3] == CpuSet{ 3, 7 }));
+        TEST_ASSERT((core[4] == CpuSet{ 0, 4 })); // more slots than cores: siblings are shared.
+        TEST_ASSERT((core[5] == CpuSet{ 1, 5 }));
+
+        const auto spread = PlanCpuSlots(cpus, CpuAffinity::Spread, 4);
+        TEST_ASSERT(spread.size() == 4);
+        TEST_ASSERT((spread[0] == CpuSet{ 0, 4 }));
+        TEST_ASSERT((spread[1] == CpuSet{ 2, 6 }));
+        TEST_ASSERT((spread[2] == CpuSet{ 1, 5 }));
+        TEST_ASSERT((spread[3] == CpuSet{ 3, 7 }));
+
+        const auto numa = PlanCpuSlots(cpus, CpuAffinity::Numa, 2);
+        TEST_ASSERT(numa.size() == 2);
+        TEST_ASSERT((numa[0] == CpuSet{ 0, 1, 4, 5 }));
+        TEST_ASSERT((numa[1] == CpuSet{ 2, 3, 6, 7 }));
+    }
+
+    // replan keeps CPUs of running processes until they exit.
+    {
+        CpuSlots slots;
+        slots.Replan(PlanCpuSlots(cpus, CpuAffinity::Core, 4));
+        TEST_ASSERT(slots.GetSize() == 4);
+
+        size_t slot0 = 0, slot1 = 0, slot2 = 0;
+        CpuSet cpus0, cpus1, cpus2;
+        TEST_ASSERT(slots.Acquire(slot0, cpus0));
+        TEST_ASSERT(slots.Acquire(slot1, cpus1));
+        TEST_ASSERT(slot0 == 0 && slot1 == 1);
+        TEST_ASSERT((cpus1 == CpuSet{ 1, 5 }));
+
+        // spread plan moves slot 1 to other package; free slot takes it at once, busy one on release.
+        slots.Replan(PlanCpuSlots(cpus, CpuAffinity::Spread, 4));
+        TEST_ASSERT(slots.GetBusyCount() == 2);
+        TEST_ASSERT(slots.Acquire(slot2, cpus2));
+        TEST_ASSERT(slot2 == 2);
+        TEST_ASSERT((cpus2 == CpuSet{ 1, 5 }));
+        slots.Release(slot1);
+        TEST_ASSERT(slots.Acquire(slot1, cpus1));
+        TEST_ASSERT(slot1 == 1);
+        TEST_ASSERT((cpus1 == CpuSet{ 2, 6 }));
+
+        // shrink: busy slots beyond new count stay until released, and no new process takes them.
+        slots.Replan(PlanCpuSlots(cpus, CpuAffinity::Spread, 1));
+        TEST_ASSERT(slots.GetSize() == 3);
+        size_t slot = 0;
+        CpuSet taken;
+        TEST_ASSERT(!slots.Acquire(slot, taken));
+        slots.Release(slot1);
+        TEST_ASSERT(slots.GetSize() == 3); // slot 2 is still busy, indices do not move.
+        TEST_ASSERT(!slots.Acquire(slot, taken));
+        slots.Release(slot2);
+        TEST_ASSERT(slots.GetSize() == 1);
+        TEST_ASSERT(slots.GetBusyCount() == 1);
+
+        // grow again.
+        slots.Replan(PlanCpuSlots(cpus, CpuAffinity::Spread, 3));
+        TEST_ASSERT(slots.GetSize() == 3);
+        TEST_ASSERT(slots.Acquire(slot, taken));
+        TEST_ASSERT(slot == 1);
+        TEST_ASSERT((taken == CpuSet{ 2, 6 }));
+        slots.Release(slot0);
+        slots.Release(slot);
+        TEST_ASSERT(slots.GetBusyCount() == 0);
+
+        // affinity is turned off: slots are dropped as processes exit.
+        TEST_ASSERT(slots.Acquire(slot, taken));
+        slots.Replan({});
+        TEST_ASSERT(slots.GetSize() == 1);
+        TEST_ASSERT(!slots.Acquire(slot0, cpus0));
+        slots.Release(slot);
+        TEST_ASSERT(slots.GetSize() == 0);
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
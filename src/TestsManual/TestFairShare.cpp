@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "TestUtils.h"
+
+#include <FairShareQueue.h>
+#include <Application.h>
+
+namespace {
+Wuild::LocalExecutorTask::Ptr MakeTask(const std::string& group, double weight = 1.0)
+{
+    Wuild::LocalExecutorTask::Ptr task(new Wuild::LocalExecutorTask());
+    task->m_shareGroup  = group;
+    task->m_shareWeight = weight;
+    return task;
+}
+}
+
+/*
+ * Autotest for executor fair share queue. Arguments not required.
+ */
+int main(int argc, char** argv)
+{
+    using namespace Wuild;
+    ConfiguredApplication app(argc, argv, "TestFairShare");
+
+    // single group is plain FIFO.
+    {
+        FairShareQueue queue;
+        TEST_ASSERT(queue.Pop() == nullptr);
+        auto first = MakeTask("ci"), second = MakeTask("ci"), third = MakeTask("ci");
+        queue.Push(first);
+        queue.Push(second);
+        queue.Push(third);
+        TEST_ASSERT(queue.Size() == 3);
+        TEST_ASSERT(queue.Remove(second));
+        TEST_ASSERT(!queue.Remove(second));
+        TEST_ASSERT(queue.Pop() == first);
+        TEST_ASSERT(queue.Pop() == third);
+        TEST_ASSERT(queue.Empty());
+    }
+
+    // flooded queue is shared according to weights.
+    {
+        FairShareQueue queue;
+        for (int i = 0; i < 100; ++i) {
+            queue.Push(MakeTask("ci", 1.0));
+            queue.Push(MakeTask("dev", 3.0));
+        }
+        int dev = 0;
+        for (int i = 0; i < 40; ++i)
+            dev += queue.Pop()->m_shareGroup == "dev";
+        TEST_ASSERT(dev == 30);
+    }
+
+    // interactive task arriving behind large build is started next; idle time gives no credit.
+    {
+        FairShareQueue queue;
+        for (int i = 0; i < 100; ++i)
+            queue.Push(MakeTask("ci"));
+        for (int i = 0; i < 50; ++i)
+            queue.Pop();
+
+        queue.Push(MakeTask("dev"));
+        TEST_ASSERT(queue.Pop()->m_shareGroup == "dev");
+        for (int i = 0; i < 10; ++i)
+            queue.Push(MakeTask("dev"));
+
+        std::string sequence;
+        for (int i = 0; i < 10; ++i)
+            sequence += queue.Pop()->m_shareGroup == "dev" ? 'd' : 'c';
+        std::cout << "Sequence: " << sequence << "\n";
+        TEST_ASSERT(sequence.find("ddd") == std::string::npos);
+        TEST_ASSERT(sequence.find("cc") == std::string::npos);
+        TEST_ASSERT(queue.Size() == 45 + 5);
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
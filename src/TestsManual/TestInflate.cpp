@@ -15,6 +15,10 @@
 
 #include <FileUtils.h>
 #include <Application.h>
+#include <ChunkedCompression.h>
+#include <CompressionDictionary.h>
+
+#include <string>
 
 void FillRandomBuffer(std::vector<uint8_t>& data, size_t size)
 {
@@ -50,6 +54,7 @@ int main(int argc, char** argv)
             f1.ReadFile(uncompressed2);
 
             TEST_ASSERT(uncompressed.ref() == uncompressed2.ref());
+            TEST_ASSERT(uncompressed2.ref().capacity() == dataSize);
 
             ByteArrayHolder compressed;
             f1.ReadCompressed(compressed, info);
@@ -59,6 +64,7 @@ int main(int argc, char** argv)
             f2.ReadFile(compressed2);
 
             TEST_ASSERT(compressed.ref() == compressed2.ref());
+            TEST_ASSERT(ChunkedCompression::IsChunked(compressed) == (dataSize > ChunkedCompression::s_chunkSize));
             bool res = f3.WriteCompressed(compressed2, info);
 
             TEST_ASSERT(res);
@@ -76,6 +82,93 @@ int main(int argc, char** argv)
         }
         std::cout << "Compression " << int(compressionType) << " elapsed:" << start.GetElapsedTime().ToString() << "\n";
     }
+
+    {
+        // empty file is not mapped, missing one is not read.
+        TemporaryFile   empty(tmp + "/empty");
+        ByteArrayHolder data, compressed;
+        TEST_ASSERT(empty.WriteFile(data));
+        TEST_ASSERT(empty.ReadFile(data) && data.size() == 0);
+        size_t readSize = 1;
+        TEST_ASSERT(empty.ReadMapped([&readSize](const uint8_t*, size_t size) { readSize = size; }) && readSize == 0);
+        TEST_ASSERT(!FileInfo(tmp + "/missing").ReadMapped([](const uint8_t*, size_t) {}));
+        TEST_ASSERT(!FileInfo(tmp + "/missing").ReadFile(data));
+    }
+
+    {
+        // container is used from two chunks; it is read by chunks in order, and broken one is rejected.
+        CompressionInfo info;
+        info.m_type  = Mernel::CompressionType::ZStd;
+        info.m_level = 3;
+        for (size_t dataSize : { ChunkedCompression::s_chunkSize, ChunkedCompression::s_chunkSize * 2 + 1 }) {
+            ByteArrayHolder uncompressed, compressed, uncompressed2;
+            FillRandomBuffer(uncompressed.ref(), dataSize);
+            ChunkedCompression::Compress(uncompressed, compressed, info);
+            TEST_ASSERT(ChunkedCompression::IsChunked(compressed) == (dataSize > ChunkedCompression::s_chunkSize));
+            ChunkedCompression::Uncompress(compressed, uncompressed2, info);
+            TEST_ASSERT(uncompressed.ref() == uncompressed2.ref());
+
+            std::vector<size_t> chunkSizes;
+            ChunkedCompression::Uncompress(compressed, info, [&chunkSizes](const ByteArrayHolder& chunk) { chunkSizes.push_back(chunk.size()); });
+            TEST_ASSERT(chunkSizes.size() == (dataSize + ChunkedCompression::s_chunkSize - 1) / ChunkedCompression::s_chunkSize);
+            TEST_ASSERT(chunkSizes[0] == ChunkedCompression::s_chunkSize);
+        }
+
+        ByteArrayHolder uncompressed, compressed, uncompressed2;
+        FillRandomBuffer(uncompressed.ref(), ChunkedCompression::s_chunkSize * 3);
+        ChunkedCompression::Compress(uncompressed, compressed, info);
+        compressed.ref()[8]++; // size of first chunk
+        bool thrown = false;
+        try {
+            ChunkedCompression::Uncompress(compressed, uncompressed2, info);
+        }
+        catch (std::exception&) {
+            thrown = true;
+        }
+        TEST_ASSERT(thrown);
+
+        CompressionInfo none;
+        none.m_type = Mernel::CompressionType::None;
+        ChunkedCompression::Compress(uncompressed, compressed, none);
+        TEST_ASSERT(compressed.ref() == uncompressed.ref());
+    }
+
+    if (CompressionDictionary::IsSupported()) {
+        // inputs share most of content, like preprocessed sources with same headers.
+        std::vector<ByteArrayHolder> samples;
+        for (int i = 0; i < 200; ++i) {
+            std::string text;
+            for (int j = 0; j < 200; ++j)
+                text += "template<class T> struct common" + std::to_string(j) + " { T value" + std::to_string((j * 7) % 13) + "; };\n";
+            text += "int unique" + std::to_string(i) + "() { return " + std::to_string(rand()) + "; }\n";
+            samples.push_back(ByteArrayHolder(ByteArray(text.cbegin(), text.cend())));
+        }
+        auto dictionary = CompressionDictionary::Train(samples, 16 * 1024);
+        TEST_ASSERT(dictionary);
+        TEST_ASSERT(CompressionDictionary::Create(dictionary->GetData())->GetId() == dictionary->GetId());
+
+        CompressionInfo info;
+        info.m_type  = Mernel::CompressionType::ZStd;
+        info.m_level = 3;
+        ByteArrayHolder plain, compressed, uncompressed;
+        Mernel::compressDataBuffer(samples[0], plain, info);
+        dictionary->Compress(samples[0], compressed, info.m_level);
+        dictionary->Uncompress(compressed, uncompressed);
+        TEST_ASSERT(uncompressed.ref() == samples[0].ref());
+        TEST_ASSERT(compressed.size() < plain.size());
+        std::cout << "Dictionary: " << samples[0].size() << " -> " << plain.size() << " plain, " << compressed.size() << " with dictionary\n";
+
+        // frame header claiming 1 TiB of content is rejected without allocation.
+        ByteArrayHolder hugeFrame(ByteArray{ 0x28, 0xB5, 0x2F, 0xFD, 0xE0, 0, 0, 0, 0, 0, 1, 0, 0 });
+        bool            rejected = false;
+        try {
+            dictionary->Uncompress(hugeFrame, uncompressed);
+        }
+        catch (std::exception&) {
+            rejected = true;
+        }
+        TEST_ASSERT(rejected);
+    }
     std::cout << "OK\n";
     return 0;
 }
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "TestUtils.h"
+
+#include <LocalExecutionModel.h>
+#include <Application.h>
+
+namespace {
+using namespace Wuild;
+
+void AddRemote(LocalExecutionModel& model, int64_t executionUS, int64_t overheadPercent)
+{
+    for (int64_t i = 0; i < LocalExecutionModel::s_minimalRemoteSamples; ++i)
+        model.AddRemoteExecution(executionUS, overheadPercent);
+}
+}
+
+/*
+ * Autotest for local/remote decision of remote-capable tasks. Arguments not required.
+ */
+int main(int argc, char** argv)
+{
+    ConfiguredApplication app(argc, argv, "TestLocalExecution");
+
+    // nothing measured: remote is used while it has free threads, otherwise idle local core.
+    {
+        LocalExecutionModel model;
+        TEST_ASSERT(!model.PreferLocal(true));
+        TEST_ASSERT(model.PreferLocal(false));
+        model.AddRemoteExecution(1000, 500);
+        model.AddLocalExecution(100);
+        TEST_ASSERT(!model.PreferLocal(true));
+    }
+
+    // local cores are not measured yet: assumed as fast as remote, so overhead decides.
+    {
+        LocalExecutionModel model;
+        AddRemote(model, 1000000, 0);
+        TEST_ASSERT(!model.PreferLocal(true));
+        TEST_ASSERT(!model.PreferLocal(false));
+
+        LocalExecutionModel slowLink;
+        AddRemote(slowLink, 1000000, 50);
+        TEST_ASSERT(slowLink.PreferLocal(true));
+    }
+
+    // 1 s remote compilation with 50% overhead is 1.5 s.
+    {
+        LocalExecutionModel fastLocal;
+        AddRemote(fastLocal, 1000000, 50);
+        fastLocal.AddLocalExecution(1200000);
+        TEST_ASSERT(fastLocal.PreferLocal(true));
+
+        LocalExecutionModel slowLocal;
+        AddRemote(slowLocal, 1000000, 50);
+        slowLocal.AddLocalExecution(2000000);
+        TEST_ASSERT(!slowLocal.PreferLocal(true));
+        TEST_ASSERT(!slowLocal.PreferLocal(false));
+    }
+
+    // averages follow recent samples.
+    {
+        LocalExecutionModel model;
+        AddRemote(model, 1000000, 50);
+        model.AddLocalExecution(2000000);
+        TEST_ASSERT(!model.PreferLocal(true));
+        for (int i = 0; i < 20; ++i)
+            model.AddLocalExecution(500000);
+        TEST_ASSERT(model.PreferLocal(true));
+    }
+
+    // local run with preprocessor: only compilation part is compared with remote.
+    {
+        LocalExecutionModel model;
+        AddRemote(model, 1000000, 50);
+        model.AddLocalExecution(1800000, true); // preprocessing is not measured yet, sample is skipped.
+        TEST_ASSERT(model.PreferLocal(true));
+        model.AddPreprocessing(500000);
+        model.AddLocalExecution(1800000, true);
+        TEST_ASSERT(model.PreferLocal(true));
+
+        LocalExecutionModel slowLocal;
+        AddRemote(slowLocal, 1000000, 50);
+        slowLocal.AddPreprocessing(200000);
+        slowLocal.AddLocalExecution(1800000, true);
+        TEST_ASSERT(!slowLocal.PreferLocal(true));
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
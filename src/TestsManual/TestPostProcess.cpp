@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "TestUtils.h"
+
+#include <RemoteToolClientConfig.h>
+#include <Application.h>
+
+#include <algorithm>
+
+namespace {
+using namespace Wuild;
+
+ByteArray ToBytes(const std::string& str)
+{
+    return ByteArray(str.cbegin(), str.cend());
+}
+
+/// Previous implementation: each replacement searches again from the beginning, for each item.
+void ApplyReference(const RemoteToolClientConfig::PostProcess& postProcess, ByteArray& data)
+{
+    for (auto&& item : postProcess.m_items) {
+        while (true) {
+            auto it = std::search(data.begin(), data.end(), item.m_needle.begin(), item.m_needle.end());
+            if (it == data.end())
+                break;
+            std::copy(item.m_replacement.cbegin(), item.m_replacement.cend(), it);
+        }
+    }
+}
+
+bool SameAsReference(const RemoteToolClientConfig::PostProcess& postProcess, const std::string& input, const std::string& expected = std::string())
+{
+    ByteArray data = ToBytes(input), reference = ToBytes(input);
+    postProcess.Apply(data);
+    ApplyReference(postProcess, reference);
+    if (data != reference) {
+        std::cerr << "For \"" << input << "\": \"" << std::string(data.cbegin(), data.cend()) << "\", expected \"" << std::string(reference.cbegin(), reference.cend()) << "\"\n";
+        return false;
+    }
+    return expected.empty() || data == ToBytes(expected);
+}
+
+RemoteToolClientConfig::PostProcess MakeRules(const std::vector<std::pair<std::string, std::string>>& rules)
+{
+    RemoteToolClientConfig::PostProcess postProcess;
+    for (const auto& rule : rules)
+        postProcess.m_items.push_back({ ToBytes(rule.first), ToBytes(rule.second) });
+    return postProcess;
+}
+}
+
+/*
+ * Autotest for client postProcess rules: result must match previous implementation. Arguments not required.
+ */
+int main(int argc, char** argv)
+{
+    ConfiguredApplication app(argc, argv, "TestPostProcess");
+
+    // path remapping, with more specific rule first and general one after it.
+    {
+        const auto rules = MakeRules({ { "/home/user/src/", "/build/src/xxxx" }, { "/home/", "/xxxx/" } });
+        TEST_ASSERT(SameAsReference(rules, "file /home/user/src/a.cpp and /home/other/b.h", "file /build/src/xxxxa.cpp and /xxxx/other/b.h"));
+        TEST_ASSERT(SameAsReference(rules, ""));
+        TEST_ASSERT(SameAsReference(rules, "/home"));
+    }
+
+    // chained rules: result of first item is matched by second one.
+    {
+        const auto rules = MakeRules({ { "abc", "xyz" }, { "xy", "12" } });
+        TEST_ASSERT(SameAsReference(rules, "abc xy abcabc", "12z 12 12z12z"));
+    }
+
+    // replacement completes a match which starts before it.
+    {
+        const auto rules = MakeRules({ { "aab", "aba" } });
+        TEST_ASSERT(SameAsReference(rules, "aaab", "abaa"));
+        TEST_ASSERT(SameAsReference(rules, "aaaaab"));
+    }
+
+    // overlapping needles of one item.
+    {
+        const auto rules = MakeRules({ { "aa", "ab" }, { "ba", "cc" } });
+        TEST_ASSERT(SameAsReference(rules, "aaaa"));
+        TEST_ASSERT(SameAsReference(rules, "baaab"));
+    }
+
+    // random data over small alphabet, so matches overlap often.
+    {
+        srand(1);
+        for (int round = 0; round < 2000; ++round) {
+            auto randomString = [](size_t size) {
+                std::string result;
+                for (size_t i = 0; i < size; ++i)
+                    result += static_cast<char>('a' + rand() % 3);
+                return result;
+            };
+            std::vector<std::pair<std::string, std::string>> pairs;
+            for (int i = 0, count = 1 + rand() % 3; i < count; ++i) {
+                const size_t size = 1 + rand() % 3;
+                pairs.push_back({ randomString(size), randomString(size) });
+            }
+            // rules which can replace each other forever never finish with previous implementation too.
+            const auto rules = MakeRules(pairs);
+            bool       cyclic = false;
+            for (const auto& pair : pairs)
+                cyclic = cyclic || pair.first == pair.second || pair.second.find(pair.first) != std::string::npos;
+            if (cyclic)
+                continue;
+            TEST_ASSERT(SameAsReference(rules, randomString(rand() % 40)));
+        }
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "TestUtils.h"
+
+#include <ChunkedInput.h>
+#include <RemoteToolFrames.h>
+#include <RemoteToolServer.h>
+#include <SocketFrameService.h>
+
+#include <ResultCache.h>
+#include <Sha256.h>
+
+#include <atomic>
+#include <future>
+#include <set>
+
+#include "MernelPlatform/FsUtils.hpp"
+
+using namespace Wuild;
+
+namespace {
+const int         g_resultCachePort = 12347;
+const std::string g_testTool        = "testTool";
+
+/// Counts executed tasks; output is input reversed.
+class LocalExecutorCounter : public ILocalExecutor {
+public:
+    std::atomic_int m_executed{ 0 };
+
+    void AddTask(LocalExecutorTask::Ptr task) override
+    {
+        m_executed++;
+        LocalExecutorResult::Ptr res(new LocalExecutorResult("warning: stub", true));
+        res->m_outputData = ByteArrayHolder(ByteArray(task->m_inputData.ref().rbegin(), task->m_inputData.ref().rend()));
+        res->m_executionTime.SetUS(1000);
+        task->m_callback(res);
+    }
+    void     CancelTask(LocalExecutorTask::Ptr) override {}
+    void     SyncExecTask(LocalExecutorTask::Ptr) override { assert(!"Not implemented for test."); }
+    size_t   GetQueueSize() const override { return 0; }
+    TaskPair SplitTask(LocalExecutorTask::Ptr, std::string&) override { return TaskPair(); }
+    const StringVector& GetToolIds() const override
+    {
+        static const StringVector ids({ g_testTool });
+        return ids;
+    }
+    void   SetThreadCount(int) override {}
+    void   SetIoThreadCount(int) override {}
+    void   SetMemoryStaging(const std::string&, int64_t) override {}
+    void   SetToolWarmup(TimePoint) override {}
+    void   SetCpuAffinity(CpuAffinity) override {}
+    void   SetMemoryAdmission(int64_t) override {}
+    size_t GetMemoryLimitedThreads() const override { return 0; }
+};
+
+template<class Response>
+std::shared_ptr<Response> Send(SocketFrameHandler::Ptr handler, SocketFrame::Ptr frame)
+{
+    auto promise = std::make_shared<std::promise<std::shared_ptr<Response>>>();
+    handler->QueueFrame(frame, [promise](SocketFrame::Ptr responseFrame, SocketFrameHandler::ReplyState state, const std::string&) {
+        promise->set_value(state == SocketFrameHandler::ReplyState::Success ? std::dynamic_pointer_cast<Response>(responseFrame) : nullptr);
+    },
+                        TimePoint(10.0));
+    return promise->get_future().get();
+}
+
+enum class Upload
+{
+    Data,
+    DataAndHash,
+    HashOnly
+};
+
+RemoteToolRequest::Ptr MakeRequest(const StringVector& args)
+{
+    static uint64_t        taskId = 0;
+    RemoteToolRequest::Ptr request(new RemoteToolRequest());
+    request->m_sessionId                   = 1;
+    request->m_taskId                      = ++taskId;
+    request->m_invocation.m_id.m_toolId    = g_testTool;
+    request->m_invocation.m_arglist.m_args = args;
+    request->m_compression.m_type          = Mernel::CompressionType::None;
+    return request;
+}
+
+RemoteToolResponse::Ptr Invoke(SocketFrameHandler::Ptr handler, const std::string& input, const StringVector& args, Upload upload = Upload::Data)
+{
+    const ByteArrayHolder  data(ByteArray(input.cbegin(), input.cend()));
+    RemoteToolRequest::Ptr request = MakeRequest(args);
+    if (upload != Upload::HashOnly)
+        request->m_fileData = data;
+    if (upload != Upload::Data)
+        request->m_inputHash = Sha256::Hash(data);
+    return Send<RemoteToolResponse>(handler, request);
+}
+
+/// Sends input by chunks, except ones in skipped; skipped chunks are added to it. Sent data is zstd compressed.
+RemoteToolResponse::Ptr InvokeChunked(SocketFrameHandler::Ptr handler, const ChunkedInput& input, std::set<std::string>& skipped)
+{
+    RemoteToolRequest::Ptr request = MakeRequest({ "-c", "chunked.pp.cpp", "-o", "chunked.o" });
+    request->m_compression.m_type  = Mernel::CompressionType::ZStd;
+    request->m_compression.m_level = 3;
+    request->m_chunkHashes         = input.GetHashes();
+    ByteArray sent;
+    for (const auto& chunk : input.GetChunks()) {
+        if (skipped.count(chunk.m_hash)) {
+            request->m_chunkSizes.push_back(0);
+            continue;
+        }
+        skipped.insert(chunk.m_hash);
+        request->m_chunkSizes.push_back(static_cast<uint32_t>(chunk.m_size));
+        sent.insert(sent.end(), input.GetData().ref().cbegin() + chunk.m_offset, input.GetData().ref().cbegin() + chunk.m_offset + chunk.m_size);
+    }
+    Mernel::compressDataBuffer(ByteArrayHolder(std::move(sent)), request->m_fileData, request->m_compression);
+    return Send<RemoteToolResponse>(handler, request);
+}
+
+std::string ToString(const ByteArrayHolder& data)
+{
+    return std::string(data.ref().cbegin(), data.ref().cend());
+}
+
+/// Preprocessed source including same header as others.
+ChunkedInput::Ptr MakeSource(const std::string& name)
+{
+    std::string source = "# 1 \"" + name + "\"\n";
+    for (int i = 0; i < 20; ++i)
+        source += "// " + name + " before header, line " + std::to_string(i) + "\n";
+    source += "# 1 \"/usr/include/header.h\" 1 3 4\n";
+    for (int i = 0; i < 20; ++i)
+        source += "int header_function" + std::to_string(i) + "();\n";
+    source += "# 3 \"" + name + "\" 2\n";
+    source += "int main() { return 0; } // " + name + "\n";
+    return ChunkedInput::Split(ByteArrayHolder(ByteArray(source.cbegin(), source.cend())));
+}
+}
+
+/*
+ * Checks that identical request is answered from tool server result cache, without local executor,
+ * and that any difference in input or arguments is a miss. Also checks client object cache round trip,
+ * and that server accepts request without input data only when it has that input.
+ * Input sent by chunks is reassembled from sent and stored chunks exactly as it was.
+ */
+int main(int argc, char** argv)
+{
+    ConfiguredApplication app(argc, argv, "TestResultCache");
+
+    const std::string cacheDir = app.m_tempDir + "/TestResultCache";
+    std::error_code   code;
+    Mernel::std_fs::remove_all(Mernel::string2path(cacheDir), code);
+
+    {
+        // client side: object is copied into cache and back.
+        ResultCache       localCache(cacheDir + "/local", 1024 * 1024);
+        const std::string object = cacheDir + "/test.o";
+        const ByteArray   objectData{ 0x7f, 'E', 'L', 'F', 1, 2, 3 };
+        TEST_ASSERT(FileInfo(object).WriteFile(ByteArrayHolder(objectData)));
+        TEST_ASSERT(!localCache.Materialize("abcdef", object + "2"));
+        localCache.PutFile("abcdef", object);
+        FileInfo(object).Remove();
+        TEST_ASSERT(localCache.Materialize("abcdef", object));
+        ByteArrayHolder materialized;
+        TEST_ASSERT(FileInfo(object).ReadFile(materialized) && materialized.ref() == objectData);
+        TEST_ASSERT(localCache.GetStats().m_hits == 1 && localCache.GetStats().m_misses == 1 && localCache.GetStats().m_entries == 1);
+    }
+
+    auto executor = std::make_shared<LocalExecutorCounter>();
+
+    RemoteToolServer::Config toolServerConfig;
+    toolServerConfig.m_listenHost            = "localhost";
+    toolServerConfig.m_listenPort            = g_resultCachePort;
+    toolServerConfig.m_coordinator.m_enabled = false;
+    toolServerConfig.m_resultCacheDir        = cacheDir;
+    RemoteToolServer server(executor, { { g_testTool, "1.0" } });
+    TEST_ASSERT(server.SetConfig(toolServerConfig));
+    server.Start();
+
+    SocketFrameHandlerSettings settings;
+    settings.m_channelProtocolVersion = g_remoteToolProtocolVersion;
+    settings.m_hasConnStatus          = true;
+    settings.m_segmentSize            = 8192;
+    SocketFrameHandler::Ptr handler(new SocketFrameHandler(settings));
+    handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolResponse>::Create());
+    handler->RegisterFrameReader(SocketFrameReaderTemplate<RemoteToolInputProbeResponse>::Create());
+    handler->SetTcpChannel("localhost", g_resultCachePort);
+    handler->Start();
+
+    const StringVector args{ "-c", "test.pp.cpp", "-o", "test.o" };
+    auto               first = Invoke(handler, "int main();", args);
+    TEST_ASSERT(first && first->m_result);
+    TEST_ASSERT(executor->m_executed == 1);
+
+    auto second = Invoke(handler, "int main();", args);
+    TEST_ASSERT(second && second->m_result);
+    TEST_ASSERT(executor->m_executed == 1);
+    TEST_ASSERT(ToString(second->m_fileData) == ToString(first->m_fileData));
+    TEST_ASSERT(second->m_stdOut == first->m_stdOut);
+
+    Invoke(handler, "int main(int);", args);
+    TEST_ASSERT(executor->m_executed == 2);
+    Invoke(handler, "int main();", { "-O2", "-c", "test.pp.cpp", "-o", "test.o" });
+    TEST_ASSERT(executor->m_executed == 3);
+
+    // hash-first upload: server has only inputs which were sent with hash.
+    const std::string         bigInput = "int big();";
+    RemoteToolInputProbe::Ptr probe(new RemoteToolInputProbe());
+    probe->m_hashes = { Sha256::Hash(ByteArrayHolder(ByteArray(bigInput.cbegin(), bigInput.cend()))) };
+    auto probeResult = Send<RemoteToolInputProbeResponse>(handler, probe);
+    TEST_ASSERT(probeResult && probeResult->m_available.empty());
+    auto missing = Invoke(handler, bigInput, args, Upload::HashOnly);
+    TEST_ASSERT(missing && !missing->m_result && missing->m_inputRequired);
+    TEST_ASSERT(executor->m_executed == 3);
+
+    auto withData = Invoke(handler, bigInput, args, Upload::DataAndHash);
+    TEST_ASSERT(withData && withData->m_result);
+    TEST_ASSERT(executor->m_executed == 4);
+    probeResult = Send<RemoteToolInputProbeResponse>(handler, probe);
+    TEST_ASSERT(probeResult && probeResult->m_available == probe->m_hashes);
+    auto byHash = Invoke(handler, bigInput, { "-O1", "-c", "test.pp.cpp", "-o", "test.o" }, Upload::HashOnly);
+    TEST_ASSERT(byHash && byHash->m_result && ToString(byHash->m_fileData) == ToString(withData->m_fileData));
+    TEST_ASSERT(executor->m_executed == 5);
+
+    // chunked upload: header chunk is sent once, then taken from server store.
+    auto first1 = MakeSource("first.cpp"), second1 = MakeSource("second.cpp"), third1 = MakeSource("third.cpp");
+    TEST_ASSERT(first1->GetChunks().size() == 3 && second1->GetChunks().size() == 3);
+    TEST_ASSERT(first1->GetChunks()[1].m_hash == second1->GetChunks()[1].m_hash);
+    TEST_ASSERT(first1->GetChunks()[0].m_hash != second1->GetChunks()[0].m_hash);
+    std::string joined;
+    for (const auto& chunk : first1->GetChunks())
+        joined += ToString(first1->GetData()).substr(chunk.m_offset, chunk.m_size);
+    TEST_ASSERT(joined == ToString(first1->GetData()));
+
+    auto reversed = [](const ChunkedInput& input) {
+        const std::string data = ToString(input.GetData());
+        return std::string(data.crbegin(), data.crend());
+    };
+    std::set<std::string> sentChunks;
+    auto                  firstResult = InvokeChunked(handler, *first1, sentChunks);
+    TEST_ASSERT(firstResult && firstResult->m_result && ToString(firstResult->m_fileData) == reversed(*first1));
+    auto secondResult = InvokeChunked(handler, *second1, sentChunks);
+    TEST_ASSERT(secondResult && secondResult->m_result && ToString(secondResult->m_fileData) == reversed(*second1));
+    TEST_ASSERT(executor->m_executed == 7);
+
+    std::set<std::string> neverSent{ third1->GetChunks()[0].m_hash };
+    auto                  missingChunk = InvokeChunked(handler, *third1, neverSent);
+    TEST_ASSERT(missingChunk && !missingChunk->m_result && missingChunk->m_inputRequired);
+    TEST_ASSERT(executor->m_executed == 7);
+
+    handler->Stop();
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017-2021 Smirnov Vladimir mapron1@gmail.com
+ * Source code licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0 or in file COPYING-APACHE-2.0.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.h
+ */
+
+#include "TestUtils.h"
+
+#include <ThreadCountScaler.h>
+#include <Application.h>
+
+/*
+ * Autotest for tool server thread count scaling. Arguments not required.
+ */
+int main(int argc, char** argv)
+{
+    using namespace Wuild;
+    ConfiguredApplication app(argc, argv, "TestThreadScaler");
+    const int morning = 8 * 60, day = 12 * 60, night = 23 * 60;
+
+    RemoteToolServerConfig config;
+    config.m_threadCount = 8;
+    TEST_ASSERT(!ThreadCountScaler(config, 8).IsEnabled());
+
+    // schedule: decreased at once, increased gradually; night range passes midnight.
+    {
+        RemoteToolServerConfig scheduled = config;
+        scheduled.m_threadSchedule       = { { 9 * 60, 19 * 60, 2 }, { 19 * 60, 9 * 60, 16 } };
+        ThreadCountScaler scaler(scheduled, 8);
+        TEST_ASSERT(scaler.IsEnabled());
+        TEST_ASSERT(scaler.Update(-1, 0, day) == 2);
+        TEST_ASSERT(scaler.Update(-1, 0, night) == 3);
+        int steps = 1;
+        while (scaler.Update(-1, 0, night) < 16)
+            steps++;
+        TEST_ASSERT(steps < 12);
+        TEST_ASSERT(scaler.Update(-1, 0, morning) == 16);
+    }
+
+    // load: CPUs used by others are left to them, own tasks are not counted.
+    {
+        RemoteToolServerConfig adaptive = config;
+        adaptive.m_minThreadCount       = 2;
+        ThreadCountScaler scaler(adaptive, 8);
+        TEST_ASSERT(scaler.IsEnabled());
+        TEST_ASSERT(scaler.Update(8.0, 8, day) == 8);
+        TEST_ASSERT(scaler.Update(6.2, 2, day) == 4);
+        TEST_ASSERT(scaler.Update(20.0, 4, day) == 2);
+        TEST_ASSERT(scaler.Update(0.5, 2, day) == 3);
+        TEST_ASSERT(scaler.Update(-1, 0, day) == 4);
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
@@ -55,6 +55,10 @@ public:
     /// Prepare invocation for remote execution
     virtual ToolCommandline PrepareRemote(const ToolCommandline& original) const = 0;
 
+    /// Makes completed compilation read its input from stdin, and write output to stdout if toolchain can.
+    /// Returns false (leaving invocation untouched) if pipe mode is disabled or not supported for invocation.
+    virtual bool SetupPipes(ToolCommandline& invocation, bool& pipeOutput) const = 0;
+
     static std::string GetPreprocessedPath(const std::string& sourcePath,
                                            const std::string& objectPath)
     {
@@ -15,6 +15,8 @@
 
 #include "LocalExecutorTask.h"
 
+#include <CpuAffinity.h>
+
 namespace Wuild {
 /// Interface for execution tasks on local host.
 class ILocalExecutor {
@@ -27,6 +29,9 @@ public:
     /// Schedule task for execution. task contains callback to call when finished.
     virtual void AddTask(LocalExecutorTask::Ptr task) = 0;
 
+    /// Removes task from queue or kills its process if already running. Task callback will be called with cancelled result.
+    virtual void CancelTask(LocalExecutorTask::Ptr task) = 0;
+
     /// Caller thread will blocked until task finished. Precondition: queue must be empty.
     virtual void SyncExecTask(LocalExecutorTask::Ptr task) = 0;
 
@@ -39,6 +44,27 @@ public:
     /// Sets maximal process count.
     virtual void SetThreadCount(int threads) = 0;
 
+    /// Sets count of threads writing input and reading output files (with compression). 0 means automatic.
+    virtual void SetIoThreadCount(int threads) = 0;
+
+    /// Puts temporary input and output files to path (in-memory filesystem), while available memory stays above reservedMemory bytes.
+    /// Otherwise, and if writing there fails, regular temp path is used. Empty path disables.
+    virtual void SetMemoryStaging(const std::string& path, int64_t reservedMemory) = 0;
+
+    /// Runs empty compilation with each GCC/Clang tool now, and again each time executor was idle for interval,
+    /// so compiler driver, backend, assembler and their libraries stay in page cache. Zero interval disables.
+    virtual void SetToolWarmup(TimePoint interval) = 0;
+
+    /// Gives each of process slots (see SetThreadCount) its own CPU set, where OS supports it.
+    virtual void SetCpuAffinity(CpuAffinity policy) = 0;
+
+    /// Starts new process only if available memory stays above reservedMemory bytes after expected peak memory
+    /// of it and of recently started processes; expectation is learned from previous runs of same tool. Zero disables.
+    virtual void SetMemoryAdmission(int64_t reservedMemory) = 0;
+
+    /// Count of idle process slots which are not used because of memory admission.
+    virtual size_t GetMemoryLimitedThreads() const = 0;
+
     /// Queued tasks count.
     virtual size_t GetQueueSize() const = 0;
 };
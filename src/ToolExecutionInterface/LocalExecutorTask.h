@@ -29,7 +29,12 @@ struct LocalExecutorResult {
     using Ptr = std::shared_ptr<LocalExecutorResult>;
 
     TimePoint       m_executionTime = 0;     //!< Time taken of actual process running
+    TimePoint       m_queueTime     = 0;     //!< Time task spent in executor queue before start
+    TimePoint       m_inputTime     = 0;     //!< Time taken to decompress and write input file
+    TimePoint       m_outputTime    = 0;     //!< Time taken to read and compress output file
+    int64_t         m_peakMemory    = 0;     //!< Peak resident memory of process and its children, bytes; 0 = unknown
     bool            m_result        = false; //!< True if process exited with success code (e.g. 0)
+    bool            m_cancelled     = false; //!< True if task was cancelled before completion
     ByteArrayHolder m_outputData;            //!< Result file data
     std::string     m_stdOut;                //!< Console output of process
 
@@ -50,14 +55,28 @@ struct LocalExecutorTask {
     CompressionInfo m_compressionInput;  //!< Compression information
     CompressionInfo m_compressionOutput; //!< Compression information
 
-    bool          m_writeInput = true;
-    bool          m_readOutput = true;
-    bool          m_readStderr = true;
+    bool          m_writeInput   = true;
+    bool          m_readOutput   = true;
+    bool          m_readStderr   = true;
+    bool          m_cancelled    = false; //!< Set by executor when task is cancelled.
+    bool          m_memoryStaged = false; //!< Temporary files are in memory filesystem.
+    bool          m_pipeInput    = false; //!< Input is written to process stdin instead of m_inputFile.
+    bool          m_pipeOutput   = false; //!< Output is read from process stdout instead of m_outputFile.
     TemporaryFile m_inputFile;  //!< Temporary file used for tool input
     TemporaryFile m_outputFile; //!< Temporary file used for tool output
+    std::string   m_stdinData;  //!< Uncompressed input in pipe mode
+    std::string   m_stdoutData; //!< Captured output in pipe mode
 
+    std::string m_shareGroup;        //!< Executor queue is shared fairly between groups (e.g. clients)
+    double      m_shareWeight = 1.0; //!< Relative share of group in executor queue
+
+    TimePoint m_queuedAt       = 0;
+    TimePoint m_inputTime      = 0;
     TimePoint m_executionStart = 0;
 
+    size_t  m_inputSize      = 0; //!< Size of m_inputData when task was admitted by executor
+    int64_t m_expectedMemory = 0; //!< Peak memory estimate used for admission
+
     std::string GetShortErrorInfo() const
     {
         return m_invocation.m_id.m_toolId + ": " + m_invocation.GetArgsString();
@@ -67,6 +86,13 @@ struct LocalExecutorTask {
     {
         m_callback(LocalExecutorResult::Ptr(new LocalExecutorResult(text)));
     }
+
+    void CancelledResult() const
+    {
+        LocalExecutorResult::Ptr result(new LocalExecutorResult("Cancelled."));
+        result->m_cancelled = true;
+        m_callback(result);
+    }
 };
 
 }